@@ -255,7 +255,7 @@ void BeginCanvas(CanvasState *canvas) {
                    ImGui::GetMousePos().y - ImGui::GetWindowPos().y};
         float prevZoom = canvas->Zoom;
         canvas->Zoom = ImClamp(
-            canvas->Zoom + io.MouseWheel * canvas->Zoom / 16.f, 0.3f, 3.f);
+            canvas->Zoom + io.MouseWheel * canvas->Zoom / 16.f, 0.05f, 3.f);
         float zoomFactor = (prevZoom - canvas->Zoom) / prevZoom;
         canvas->Offset += (mouseRel - canvas->Offset) * zoomFactor;
       }
@@ -908,4 +908,14 @@ bool GetSlotPosition(void *node_id, const char *slot_title, bool is_input,
   return true;
 }
 
+void SetSlotPosition(void *node_id, const char *slot_title, bool is_input,
+                     const ImVec2 &pos) {
+  IM_ASSERT(gCanvas != nullptr);
+  auto *impl = gCanvas->_Impl;
+  impl->CachedData.SetFloat(MakeSlotDataID("x", slot_title, node_id, is_input),
+                            pos.x);
+  impl->CachedData.SetFloat(MakeSlotDataID("y", slot_title, node_id, is_input),
+                            pos.y);
+}
+
 } // namespace ImNodes
@@ -116,5 +116,7 @@ IMGUI_API bool IsSlotCurveHovered();
 IMGUI_API bool IsConnectingCompatibleSlot();
 /// Returns the cached screen position of a slot. Call after the slot has been rendered at least once.
 IMGUI_API bool GetSlotPosition(void* node_id, const char* slot_title, bool is_input, ImVec2* out_pos);
+/// Overrides the cached screen position of a slot, for slots of nodes that were not rendered this frame.
+IMGUI_API void SetSlotPosition(void* node_id, const char* slot_title, bool is_input, const ImVec2& pos);
 
 }   // namespace ImNodes
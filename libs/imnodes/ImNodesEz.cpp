@@ -376,6 +376,12 @@ bool Connection(void *input_node, const char *input_slot, void *output_node,
   return ImNodes::Connection(input_node, input_slot, output_node, output_slot);
 }
 
+void BeginConnectionLayer() {
+  IM_ASSERT(GContext != nullptr);
+  Context &g = *GContext;
+  g.CanvasSplitter.SetCurrentChannel(ImGui::GetWindowDrawList(), 0);
+}
+
 void PushStyleVar(ImNodesStyleVar idx, float val) {
   IM_ASSERT(GContext != nullptr);
   Context &g = *GContext;
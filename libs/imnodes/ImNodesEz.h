@@ -116,6 +116,8 @@ IMGUI_API void InputSlots(const SlotInfo* slots, int snum);
 IMGUI_API void OutputSlots(const SlotInfo* slots, int snum);
 
 bool Connection(void* input_node, const char* input_slot, void* output_node, const char* output_slot);
+/// Directs following draw list output to the connection layer, behind nodes. For drawing connections without Connection().
+IMGUI_API void BeginConnectionLayer();
 
 IMGUI_API void PushStyleVar(ImNodesStyleVar idx, float val);
 IMGUI_API void PushStyleVar(ImNodesStyleVar idx, const ImVec2 &val);
@@ -1,6 +1,7 @@
 #include "AIAssistant.hpp"
 #include "SystemPrompt.hpp"
 #include "AnthropicProvider.hpp"
+#include "Repaint.hpp"
 #include <iostream>
 
 namespace Logicarium {
@@ -108,6 +109,7 @@ namespace Logicarium {
             std::lock_guard<std::mutex> lock(responseMutex);
             pendingChunks += textDelta;
         }
+        Repaint::Request();
     }
 
     void AIAssistant::OnError(const std::string& error) {
@@ -115,6 +117,7 @@ namespace Logicarium {
         errorMessage = error;
         state = AIRequestState::Error;
         std::cerr << "AI request error: " << error << std::endl;
+        Repaint::Request();
     }
 
     void AIAssistant::OnComplete() {
@@ -123,6 +126,7 @@ namespace Logicarium {
             state = AIRequestState::Complete;
             std::cout << "AI request completed" << std::endl;
         }
+        Repaint::Request();
     }
 
 }
@@ -0,0 +1,206 @@
+#include "BinaryIO.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Logicarium {
+struct Crc32Table {
+  uint32_t table[256];
+  constexpr Crc32Table() : table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit)
+        crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+      table[i] = crc;
+    }
+  }
+};
+static constexpr Crc32Table crc32Table;
+
+uint32_t Crc32(std::string_view data, uint32_t crc) {
+  crc = ~crc;
+  for (unsigned char c : data)
+    crc = crc32Table.table[(crc ^ c) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+static constexpr size_t MagicSize = 4;
+static constexpr size_t SectionEntrySize = 24;
+
+bool ReadSections(std::string_view file, std::vector<FileSection> &sections) {
+  sections.clear();
+  ByteReader header(file.substr(std::min(file.size(), MagicSize)));
+  uint32_t count = header.U32();
+  if (file.size() < MagicSize || !header.Ok() ||
+      count > header.Remaining() / SectionEntrySize)
+    return false;
+  sections.resize(count);
+  for (FileSection &section : sections) {
+    section.id = header.U32();
+    section.crc = header.U32();
+    uint64_t offset = header.U64();
+    uint64_t size = header.U64();
+    if (offset > file.size() || size > file.size() - offset)
+      return false;
+    section.data = file.substr((size_t)offset, (size_t)size);
+  }
+  return true;
+}
+
+bool WriteSectionedFile(const std::string &path, std::string_view magic,
+                        std::vector<FileSection> sections) {
+  size_t size = magic.size() + 4 + sections.size() * SectionEntrySize;
+  for (const FileSection &section : sections)
+    size += section.data.size();
+  ByteWriter out;
+  out.Reserve(size);
+  out.Raw(magic);
+  out.U32((uint32_t)sections.size());
+  uint64_t offset = magic.size() + 4 + sections.size() * SectionEntrySize;
+  for (const FileSection &section : sections) {
+    out.U32(section.id);
+    out.U32(Crc32(section.data));
+    out.U64(offset);
+    out.U64(section.data.size());
+    offset += section.data.size();
+  }
+  for (const FileSection &section : sections)
+    out.Raw(section.data);
+  return WriteFileBytes(path, out.Bytes());
+}
+
+void WriteStringSection(ByteWriter &out,
+                        const std::vector<std::string_view> &strings) {
+  size_t size = 4 + strings.size() * 4;
+  for (std::string_view text : strings)
+    size += text.size() + 1;
+  out.Reserve(size);
+  out.U32((uint32_t)strings.size());
+  uint32_t end = 0;
+  for (std::string_view text : strings)
+    out.U32(end += (uint32_t)text.size() + 1);
+  for (std::string_view text : strings) {
+    out.Raw(text);
+    out.Raw(std::string_view("", 1));
+  }
+}
+
+bool ReadFileBytes(const std::string &path, std::string &bytes) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  bytes.clear();
+  bool ok = fseek(f, 0, SEEK_END) == 0;
+  long size = ok ? ftell(f) : -1;
+  ok = size >= 0 && fseek(f, 0, SEEK_SET) == 0;
+  if (ok && size > 0) {
+    bytes.resize((size_t)size);
+    ok = fread(&bytes[0], 1, bytes.size(), f) == bytes.size();
+  }
+  fclose(f);
+  return ok;
+}
+
+bool WriteFileBytes(const std::string &path, std::string_view bytes) {
+  // Named for this process and call, so writers racing on one path, such as
+  // the background compile and a synchronous one, each rename a whole file
+  static std::atomic<uint32_t> writes{0};
+#ifdef _WIN32
+  unsigned long process = GetCurrentProcessId();
+#else
+  unsigned long process = (unsigned long)getpid();
+#endif
+  std::string temporary = path + ".tmp" + std::to_string(process) + "." +
+                          std::to_string(writes.fetch_add(1));
+  FILE *f = fopen(temporary.c_str(), "wb");
+  if (!f)
+    return false;
+  bool written = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  written = fclose(f) == 0 && written;
+  std::error_code error;
+  if (written)
+    std::filesystem::rename(temporary, path, error);
+  if (!written || error) {
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::Open(const std::string &path) {
+  Close();
+#ifdef _WIN32
+  HANDLE file = CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file != INVALID_HANDLE_VALUE) {
+    LARGE_INTEGER length;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+      // The mapping keeps the file open, so the handle can go right away
+      mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping)
+        data = (const char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (data) {
+        size = (size_t)length.QuadPart;
+        mapped = true;
+      } else if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+      }
+    }
+    CloseHandle(file);
+  }
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file >= 0) {
+    struct stat info;
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+      void *view =
+          mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+      if (view != MAP_FAILED) {
+        data = (const char *)view;
+        size = (size_t)info.st_size;
+        mapped = true;
+      }
+    }
+    close(file);
+  }
+#endif
+  if (mapped)
+    return true;
+  // Empty files can't be mapped, and some file systems can't map at all
+  if (!ReadFileBytes(path, fallback))
+    return false;
+  data = fallback.data();
+  size = fallback.size();
+  return true;
+}
+
+void MappedFile::Close() {
+  if (mapped) {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap((void *)data, size);
+#endif
+  }
+  data = nullptr;
+  size = 0;
+  mapped = false;
+  fallback = std::string();
+}
+} // namespace Logicarium
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Logicarium {
+// Fixed-width little-endian fields for the binary file formats, so a file
+// reads back the same whatever the platform's byte order or the width of its
+// int and size_t.
+class ByteWriter {
+public:
+  void U32(uint32_t value) {
+    char field[4];
+    for (int i = 0; i < 4; ++i)
+      field[i] = (char)(value >> (8 * i));
+    bytes.append(field, sizeof(field));
+  }
+  void U64(uint64_t value) {
+    char field[8];
+    for (int i = 0; i < 8; ++i)
+      field[i] = (char)(value >> (8 * i));
+    bytes.append(field, sizeof(field));
+  }
+  void I32(int32_t value) { U32((uint32_t)value); }
+  void F32(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    U32(bits);
+  }
+  // Length, then the bytes
+  void String(std::string_view text) {
+    U32((uint32_t)text.size());
+    bytes.append(text);
+  }
+  void Raw(std::string_view data) { bytes.append(data); }
+
+  void Reserve(size_t size) { bytes.reserve(size); }
+  const std::string &Bytes() const { return bytes; }
+  size_t Size() const { return bytes.size(); }
+
+private:
+  std::string bytes;
+};
+
+// Reads what a ByteWriter wrote. Reading past the end yields zeros and
+// clears Ok(), so a truncated file is caught by one check at the end rather
+// than one after every field.
+class ByteReader {
+public:
+  explicit ByteReader(std::string_view bytes) : bytes(bytes) {}
+
+  uint32_t U32() {
+    const unsigned char *p = Take(4);
+    uint32_t value = 0;
+    for (int i = 0; p && i < 4; ++i)
+      value |= (uint32_t)p[i] << (8 * i);
+    return value;
+  }
+  uint64_t U64() {
+    const unsigned char *p = Take(8);
+    uint64_t value = 0;
+    for (int i = 0; p && i < 8; ++i)
+      value |= (uint64_t)p[i] << (8 * i);
+    return value;
+  }
+  int32_t I32() { return (int32_t)U32(); }
+  float F32() {
+    uint32_t bits = U32();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+  // A view into the bytes being read
+  std::string_view String() { return Raw(U32()); }
+  std::string_view Raw(size_t length) {
+    const unsigned char *p = Take(length);
+    return p ? std::string_view((const char *)p, length) : std::string_view();
+  }
+
+  bool Ok() const { return ok; }
+  size_t Remaining() const { return bytes.size() - pos; }
+
+private:
+  std::string_view bytes;
+  size_t pos = 0;
+  bool ok = true;
+
+  const unsigned char *Take(size_t length) {
+    if (!ok || length > bytes.size() - pos) {
+      ok = false;
+      return nullptr;
+    }
+    const char *p = bytes.data() + pos;
+    pos += length;
+    return (const unsigned char *)p;
+  }
+};
+
+// Strings a file stores once each and refers to by index, in the order they
+// were first added
+class StringTable {
+public:
+  uint32_t Add(const std::string &text) {
+    auto [it, added] = indices.emplace(text, (uint32_t)strings.size());
+    if (added)
+      strings.push_back(&it->first);
+    return it->second;
+  }
+  const std::vector<const std::string *> &Strings() const { return strings; }
+
+private:
+  std::unordered_map<std::string, uint32_t> indices;
+  std::vector<const std::string *> strings; // In index order
+};
+
+// 64-bit FNV-1a, for content hashes and file checksums. Pass the previous
+// result as hash to continue over more data.
+inline uint64_t Fnv1a(std::string_view data,
+                      uint64_t hash = 14695981039346656037ull) {
+  for (unsigned char c : data)
+    hash = (hash ^ c) * 1099511628211ull;
+  return hash;
+}
+
+// CRC-32 (the zlib one), for checking sections of a file. Pass the previous
+// result as crc to continue over more data.
+uint32_t Crc32(std::string_view data, uint32_t crc = 0);
+
+// Sectioned files (BPS3 scenes, BPL1 gate libraries) are a 4-byte magic, a
+// u32 section count, then per section a u32 id, u32 CRC-32 of its bytes, u64
+// offset from the start of the file and u64 size, then the sections. An id is
+// four ASCII characters read as a u32.
+constexpr uint32_t SectionId(const char (&name)[5]) {
+  return (uint32_t)(unsigned char)name[0] |
+         (uint32_t)(unsigned char)name[1] << 8 |
+         (uint32_t)(unsigned char)name[2] << 16 |
+         (uint32_t)(unsigned char)name[3] << 24;
+}
+struct FileSection {
+  uint32_t id = 0;
+  uint32_t crc = 0; // WriteSectionedFile works it out itself
+  std::string_view data;
+};
+// The sections of file, which starts with its magic. False if the table or a
+// section runs past the end of the file; CRCs are left to the caller.
+bool ReadSections(std::string_view file, std::vector<FileSection> &sections);
+bool WriteSectionedFile(const std::string &path, std::string_view magic,
+                        std::vector<FileSection> sections);
+// The string table section both formats use: u32 count, u32 end of each
+// string relative to the text that follows the ends, then the strings, each
+// followed by a 0 byte
+void WriteStringSection(ByteWriter &out,
+                        const std::vector<std::string_view> &strings);
+
+// Reads the whole file with a single read
+bool ReadFileBytes(const std::string &path, std::string &bytes);
+// Writes a temporary file of its own and renames it over path, so a reader
+// never sees half a file and concurrent writers never share one
+bool WriteFileBytes(const std::string &path, std::string_view bytes);
+
+// A file mapped read-only into memory: opening it reads nothing, and each
+// page comes in from disk the first time it is touched. Falls back to reading
+// the whole file where it can't be mapped.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile() { Close(); }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool Open(const std::string &path);
+  void Close();
+  std::string_view Bytes() const { return {data, size}; }
+
+private:
+  const char *data = nullptr;
+  size_t size = 0;
+  bool mapped = false;
+  std::string fallback;
+#ifdef _WIN32
+  void *mapping = nullptr; // The file mapping object's HANDLE
+#endif
+};
+} // namespace Logicarium
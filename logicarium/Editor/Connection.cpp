@@ -1,4 +1,5 @@
 #include "Connection.hpp"
+#include "Node.hpp"
 
 namespace Logicarium {
     bool Connection::operator==(const Connection& other) const
@@ -13,4 +14,116 @@ namespace Logicarium {
     {
         return !operator ==(other);
     }
+
+    namespace Wires {
+    static uint64_t revision = 0;
+
+    // Ring of the latest changes, each with the revision it made
+    struct LoggedChange {
+        uint64_t revision = 0;
+        Change change{};
+    };
+    static constexpr size_t LogSize = 4096;
+    static LoggedChange changeLog[LogSize];
+    static uint64_t logged = 0;       // Changes written so far
+    static uint64_t lostRevision = 0; // Newest revision overwritten
+    static int unlogged = 0;          // Live Unlogged scopes
+
+    static void Log(Node *inputNode, int inputSlot)
+    {
+        if (unlogged)
+            return;
+        LoggedChange &entry = changeLog[logged++ % LogSize];
+        if (logged > LogSize)
+            lostRevision = entry.revision;
+        entry.revision = revision;
+        entry.change = {inputNode->handle, inputSlot};
+    }
+
+    uint64_t Revision()
+    {
+        return revision;
+    }
+
+    bool ChangesSince(uint64_t since, std::vector<Change> &out)
+    {
+        if (since < lostRevision || since > revision)
+            return false;
+        uint64_t kept = logged < LogSize ? logged : LogSize;
+        for (uint64_t i = 0; i < kept; ++i) {
+            const LoggedChange &entry = changeLog[(logged - 1 - i) % LogSize];
+            if (entry.revision <= since)
+                break;
+            out.push_back(entry.change);
+        }
+        return true;
+    }
+
+    Unlogged::Unlogged() { ++unlogged; }
+    Unlogged::~Unlogged() { --unlogged; }
+
+    bool Connect(Node *outputNode, int outputSlot, Node *inputNode, int inputSlot)
+    {
+        if (!outputNode || !inputNode)
+            return false;
+        if (outputSlot < 0 || outputSlot >= outputNode->outputSlotCount)
+            return false;
+        if (inputSlot < 0 || inputSlot >= (int)inputNode->drivers.size())
+            return false;
+
+        // Input pins accept a single driver
+        Disconnect(inputNode, inputSlot);
+
+        Driver &driver = inputNode->drivers[inputSlot];
+        driver.node = outputNode;
+        driver.slot = outputSlot;
+        driver.fanoutIndex = (int)outputNode->fanout.size();
+
+        Connection conn;
+        conn.inputNode = inputNode;
+        conn.inputSlot = inputSlot;
+        conn.outputNode = outputNode;
+        conn.outputSlot = outputSlot;
+        outputNode->fanout.push_back(conn);
+        ++revision;
+        Log(inputNode, inputSlot);
+        return true;
+    }
+
+    void Disconnect(Node *inputNode, int inputSlot)
+    {
+        if (inputSlot < 0 || inputSlot >= (int)inputNode->drivers.size())
+            return;
+
+        Driver &driver = inputNode->drivers[inputSlot];
+        if (!driver.node)
+            return;
+
+        // Swap-remove from the source's fanout, then patch the back-reference
+        // of the entry that moved into the hole
+        std::vector<Connection> &fanout = driver.node->fanout;
+        int index = driver.fanoutIndex;
+        if (index != (int)fanout.size() - 1) {
+            fanout[index] = fanout.back();
+            const Connection &moved = fanout[index];
+            moved.inputNode->drivers[moved.inputSlot].fanoutIndex = index;
+        }
+        fanout.pop_back();
+
+        driver = Driver{};
+        ++revision;
+        Log(inputNode, inputSlot);
+    }
+
+    void DisconnectAll(Node *node)
+    {
+        for (int i = 0; i < (int)node->drivers.size(); ++i)
+            Disconnect(node, i);
+
+        while (!node->fanout.empty()) {
+            const Connection &conn = node->fanout.back();
+            Disconnect(conn.inputNode, conn.inputSlot);
+        }
+    }
+    } // namespace Wires
 }
@@ -1,16 +1,68 @@
 #pragma once
-#include <string>
+
+#include "NodeArena.hpp"
+#include <cstdint>
+#include <vector>
 
 namespace Logicarium {
+class Node;
+
+// A wire from an output pin to an input pin. Pins are addressed by their index
+// into the node's slot lists; names are resolved to indices once, when the wire
+// is created.
 class Connection {
 public:
-  void *inputNode = nullptr;
-  std::string inputSlot;
+  Node *inputNode = nullptr;
+  int inputSlot = -1;
 
-  void *outputNode = nullptr;
-  std::string outputSlot;
+  Node *outputNode = nullptr;
+  int outputSlot = -1;
 
   bool operator==(const Connection &other) const;
   bool operator!=(const Connection &other) const;
 };
+
+// Driver table entry for a single input pin: the output pin feeding it, and the
+// position of the matching entry in the source node's fanout list.
+struct Driver {
+  Node *node = nullptr;
+  int slot = -1;
+  int fanoutIndex = -1;
+};
+
+// Central edge table. Every wire lives exactly once in its input node's driver
+// array and once in its output node's fanout list; the two entries index each
+// other, so inserting and removing a wire are both O(1).
+namespace Wires {
+// Connects outputNode.outputSlot -> inputNode.inputSlot, replacing whatever was
+// driving that input before. Returns false if either pin index is invalid.
+bool Connect(Node *outputNode, int outputSlot, Node *inputNode, int inputSlot);
+// Removes the wire driving inputNode.inputSlot, if any.
+void Disconnect(Node *inputNode, int inputSlot);
+// Removes every wire touching the node in either direction.
+void DisconnectAll(Node *node);
+// Bumped by every change to the wire set, so caches built from it can tell
+// when they are stale.
+uint64_t Revision();
+
+// An input pin whose wire was connected, replaced or removed. The node is
+// named by handle, since it may be gone by the time the change is read.
+struct Change {
+  NodeHandle node;
+  int inputSlot;
+};
+// Appends the pins changed after revision since, newest first. False if the
+// log no longer reaches back that far; caches then rebuild from scratch.
+bool ChangesSince(uint64_t since, std::vector<Change> &out);
+// Changes made while one of these is alive bump the revision but aren't
+// logged: for wiring no index is kept of, like a custom gate's internals,
+// which would otherwise crowd the scene's changes out of the log.
+class Unlogged {
+public:
+  Unlogged();
+  ~Unlogged();
+  Unlogged(const Unlogged &) = delete;
+  Unlogged &operator=(const Unlogged &) = delete;
+};
+} // namespace Wires
 } // namespace Logicarium
@@ -0,0 +1,264 @@
+#include "GateLibraryFile.hpp"
+
+namespace Logicarium {
+static constexpr std::string_view Magic = "BPL1";
+
+static constexpr uint32_t StringsSection = SectionId("STRS");
+static constexpr uint32_t GatesSection = SectionId("GATE");
+static constexpr uint32_t NodesSection = SectionId("NODE");
+static constexpr uint32_t ConnectionsSection = SectionId("CONN");
+static constexpr uint32_t PinsSection = SectionId("PINS");
+
+static constexpr size_t GateSize = 52;
+static constexpr size_t NodeSize = 16;
+static constexpr size_t ConnectionSize = 16;
+static constexpr size_t PinSize = 4;
+
+// One entry of the gate table
+struct GateRecord {
+  uint32_t name = 0, color = 0;
+  int32_t inputs = 0, outputs = 0;
+  uint32_t firstNode = 0, nodeCount = 0;
+  uint32_t firstConnection = 0, connectionCount = 0;
+  // Input pin indices, output pin indices, input names, output names
+  uint32_t firstPin = 0, pinCounts[4] = {};
+
+  static GateRecord Read(std::string_view gates, uint32_t index) {
+    ByteReader in(gates.substr((size_t)index * GateSize, GateSize));
+    GateRecord gate;
+    gate.name = in.U32();
+    gate.color = in.U32();
+    gate.inputs = in.I32();
+    gate.outputs = in.I32();
+    gate.firstNode = in.U32();
+    gate.nodeCount = in.U32();
+    gate.firstConnection = in.U32();
+    gate.connectionCount = in.U32();
+    gate.firstPin = in.U32();
+    for (uint32_t &count : gate.pinCounts)
+      count = in.U32();
+    return gate;
+  }
+  uint64_t PinCount() const {
+    return (uint64_t)pinCounts[0] + pinCounts[1] + pinCounts[2] + pinCounts[3];
+  }
+};
+
+bool IsGateLibraryFile(std::string_view bytes) {
+  return bytes.substr(0, Magic.size()) == Magic;
+}
+
+// The records of a section, past its u32 count, which has to match them
+static bool ReadRecords(std::string_view section, size_t recordSize,
+                        std::string_view &records, uint32_t &count) {
+  ByteReader in(section);
+  count = in.U32();
+  if (!in.Ok() || in.Remaining() != (size_t)count * recordSize)
+    return false;
+  records = section.substr(4);
+  return true;
+}
+
+// Whether [first, first + count) lies within size records
+static bool InRange(uint32_t first, uint64_t count, uint32_t size) {
+  return first <= size && count <= size - first;
+}
+
+std::shared_ptr<const GateLibraryFile>
+GateLibraryFile::Open(const std::string &path) {
+  auto library = std::make_shared<GateLibraryFile>();
+  if (!library->file.Open(path) || !library->Parse())
+    return nullptr;
+  return library;
+}
+
+bool GateLibraryFile::Parse() {
+  std::string_view bytes = file.Bytes();
+  std::vector<FileSection> table;
+  if (!IsGateLibraryFile(bytes) || !ReadSections(bytes, table))
+    return false;
+  std::string_view sections[5];
+  const uint32_t ids[5] = {StringsSection, GatesSection, NodesSection,
+                           ConnectionsSection, PinsSection};
+  for (const FileSection &section : table) {
+    // The gate table is read in full below anyway; the other sections are
+    // what opening must not touch
+    if (section.id == GatesSection && Crc32(section.data) != section.crc)
+      return false;
+    for (int k = 0; k < 5; ++k)
+      if (section.id == ids[k])
+        sections[k] = section.data;
+  }
+
+  ByteReader strings(sections[0]);
+  stringCount = strings.U32();
+  if (!strings.Ok() || stringCount > strings.Remaining() / 4)
+    return false;
+  ends = sections[0].substr(4, (size_t)stringCount * 4);
+  text = sections[0].substr(4 + ends.size());
+
+  uint32_t nodeCount, connectionCount, pinCount;
+  if (!ReadRecords(sections[1], GateSize, gates, gateCount) ||
+      !ReadRecords(sections[2], NodeSize, nodes, nodeCount) ||
+      !ReadRecords(sections[3], ConnectionSize, connections,
+                   connectionCount) ||
+      !ReadRecords(sections[4], PinSize, pins, pinCount))
+    return false;
+  for (uint32_t i = 0; i < gateCount; ++i) {
+    GateRecord gate = GateRecord::Read(gates, i);
+    if (gate.name >= stringCount ||
+        !InRange(gate.firstNode, gate.nodeCount, nodeCount) ||
+        !InRange(gate.firstConnection, gate.connectionCount,
+                 connectionCount) ||
+        !InRange(gate.firstPin, gate.PinCount(), pinCount))
+      return false;
+  }
+  return true;
+}
+
+std::string_view GateLibraryFile::String(uint32_t index) const {
+  if (index >= stringCount)
+    return {};
+  ByteReader in(ends.substr(index ? ((size_t)index - 1) * 4 : 0, 8));
+  size_t start = index ? in.U32() : 0;
+  size_t end = in.U32();
+  if (end <= start || end > text.size() || text[end - 1] != '\0')
+    return {};
+  return text.substr(start, end - 1 - start);
+}
+
+GateSummary GateLibraryFile::Summary(uint32_t index) const {
+  GateRecord gate = GateRecord::Read(gates, index);
+  GateSummary summary;
+  summary.name = String(gate.name);
+  summary.color = gate.color;
+  summary.inputCount = gate.inputs;
+  summary.outputCount = gate.outputs;
+  return summary;
+}
+
+GateDefinitionRef GateLibraryFile::Build(uint32_t index) const {
+  GateRecord gate = GateRecord::Read(gates, index);
+  auto def = std::make_shared<GateDefinition>();
+  def->name = String(gate.name);
+  def->color = gate.color;
+  def->isTemporary = false; // Loaded gates are permanent
+
+  ByteReader nodeRecords(nodes.substr((size_t)gate.firstNode * NodeSize,
+                                      (size_t)gate.nodeCount * NodeSize));
+  def->nodes.resize(gate.nodeCount);
+  for (NodeDefinition &node : def->nodes) {
+    node.type = String(nodeRecords.U32());
+    node.pos.x = nodeRecords.F32();
+    node.pos.y = nodeRecords.F32();
+    node.id = nodeRecords.I32();
+  }
+
+  ByteReader connectionRecords(
+      connections.substr((size_t)gate.firstConnection * ConnectionSize,
+                         (size_t)gate.connectionCount * ConnectionSize));
+  def->connections.resize(gate.connectionCount);
+  for (ConnectionDefinition &conn : def->connections) {
+    conn.inputNodeId = connectionRecords.I32();
+    conn.inputSlot = String(connectionRecords.U32());
+    conn.outputNodeId = connectionRecords.I32();
+    conn.outputSlot = String(connectionRecords.U32());
+  }
+
+  ByteReader pinRecords(pins.substr((size_t)gate.firstPin * PinSize,
+                                    (size_t)gate.PinCount() * PinSize));
+  std::vector<int> *indices[] = {&def->inputPinIndices,
+                                 &def->outputPinIndices};
+  for (int k = 0; k < 2; ++k) {
+    indices[k]->resize(gate.pinCounts[k]);
+    for (int &pin : *indices[k])
+      pin = pinRecords.I32();
+  }
+  std::vector<std::string> *names[] = {&def->inputPinNames,
+                                       &def->outputPinNames};
+  for (int k = 0; k < 2; ++k) {
+    names[k]->resize(gate.pinCounts[2 + k]);
+    for (std::string &name : *names[k])
+      name = String(pinRecords.U32());
+  }
+  return def;
+}
+
+bool WriteGateLibrary(const std::string &path,
+                      const std::vector<GateDefinitionRef> &definitions) {
+  StringTable strings;
+  ByteWriter gates, nodes, connections, pins;
+  uint32_t nodeCount = 0, connectionCount = 0, pinCount = 0;
+  size_t nodeTotal = 0, connectionTotal = 0;
+  for (const GateDefinitionRef &def : definitions) {
+    nodeTotal += def->nodes.size();
+    connectionTotal += def->connections.size();
+  }
+  gates.Reserve(4 + definitions.size() * GateSize);
+  nodes.Reserve(4 + nodeTotal * NodeSize);
+  connections.Reserve(4 + connectionTotal * ConnectionSize);
+  gates.U32((uint32_t)definitions.size());
+  nodes.U32((uint32_t)nodeTotal);
+  connections.U32((uint32_t)connectionTotal);
+
+  ByteWriter pinRecords;
+  for (const GateDefinitionRef &def : definitions) {
+    GateSummary summary = Summarize(*def);
+    gates.U32(strings.Add(def->name));
+    gates.U32(def->color);
+    gates.I32(summary.inputCount);
+    gates.I32(summary.outputCount);
+    gates.U32(nodeCount);
+    gates.U32((uint32_t)def->nodes.size());
+    gates.U32(connectionCount);
+    gates.U32((uint32_t)def->connections.size());
+    gates.U32(pinCount);
+    gates.U32((uint32_t)def->inputPinIndices.size());
+    gates.U32((uint32_t)def->outputPinIndices.size());
+    gates.U32((uint32_t)def->inputPinNames.size());
+    gates.U32((uint32_t)def->outputPinNames.size());
+
+    for (const NodeDefinition &node : def->nodes) {
+      nodes.U32(strings.Add(node.type));
+      nodes.F32(node.pos.x);
+      nodes.F32(node.pos.y);
+      nodes.I32(node.id);
+    }
+    for (const ConnectionDefinition &conn : def->connections) {
+      connections.I32(conn.inputNodeId);
+      connections.U32(strings.Add(conn.inputSlot));
+      connections.I32(conn.outputNodeId);
+      connections.U32(strings.Add(conn.outputSlot));
+    }
+    for (const std::vector<int> *indices :
+         {&def->inputPinIndices, &def->outputPinIndices})
+      for (int pin : *indices)
+        pinRecords.I32(pin);
+    for (const std::vector<std::string> *names :
+         {&def->inputPinNames, &def->outputPinNames})
+      for (const std::string &name : *names)
+        pinRecords.U32(strings.Add(name));
+
+    nodeCount += (uint32_t)def->nodes.size();
+    connectionCount += (uint32_t)def->connections.size();
+    pinCount = (uint32_t)(pinRecords.Size() / PinSize);
+  }
+  pins.Reserve(4 + pinRecords.Size());
+  pins.U32(pinCount);
+  pins.Raw(pinRecords.Bytes());
+
+  std::vector<std::string_view> table;
+  table.reserve(strings.Strings().size());
+  for (const std::string *text : strings.Strings())
+    table.push_back(*text);
+  ByteWriter stringSection;
+  WriteStringSection(stringSection, table);
+
+  return WriteSectionedFile(path, Magic,
+                            {{StringsSection, 0, stringSection.Bytes()},
+                             {GatesSection, 0, gates.Bytes()},
+                             {NodesSection, 0, nodes.Bytes()},
+                             {ConnectionsSection, 0, connections.Bytes()},
+                             {PinsSection, 0, pins.Bytes()}});
+}
+} // namespace Logicarium
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Nodes/Gates/CustomGate.hpp"
+#include "BinaryIO.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Logicarium {
+// A gate library in the BPL1 file format, which is laid out to be used where
+// it is mapped rather than read: every string is stored once in a string
+// table, and the nodes, connections and pins of all definitions are flat
+// arrays of fixed-size records that definitions refer to by index range.
+// Opening a library reads its header and gate table only; a definition's
+// records are read, and their pages come in from disk, when it is built.
+//
+// Layout, all integers little-endian:
+//
+//   "BPL1", u32 section count
+//   Section table, per section: u32 id, u32 CRC-32 of its bytes, u64 offset
+//     from the start of the file, u64 size
+//   Sections, in any order; readers skip ids they don't know:
+//     "STRS"  u32 count, u32 end of each string relative to the text that
+//             follows the ends, then the strings, each followed by a 0 byte
+//     "GATE"  u32 count, then per definition: u32 name, u32 color, i32 input
+//             count, i32 output count (its In and Out nodes), u32 first node,
+//             u32 node count, u32 first connection, u32 connection count,
+//             u32 first pin, u32 input pin, output pin, input name and output
+//             name counts
+//     "NODE"  u32 count, then per node: u32 type, f32 x, f32 y, i32 id
+//     "CONN"  u32 count, then per connection: i32 input node id, u32 input
+//             slot, i32 output node id, u32 output slot
+//     "PINS"  u32 count, then u32s; a definition's run holds its input pin
+//             indices, output pin indices, input names and output names
+//
+// Only the gate table's CRC is checked on opening, since checking the rest
+// would read the whole file. Index ranges are checked against the sections
+// on opening and string indices when a definition is built, so a damaged file
+// builds damaged gates rather than reading outside the mapping.
+//
+// The older .bin format, which came before, is read by NodeEditor::LoadGates.
+class GateLibraryFile : public GateDefinitionSource {
+public:
+  // Null if path can't be opened or isn't an intact BPL1 library
+  static std::shared_ptr<const GateLibraryFile> Open(const std::string &path);
+
+  uint32_t Count() const { return gateCount; }
+  // Read from the gate table alone
+  GateSummary Summary(uint32_t index) const;
+  GateDefinitionRef Build(uint32_t index) const override;
+
+private:
+  MappedFile file;
+  std::string_view ends, text; // Of the string table
+  uint32_t stringCount = 0, gateCount = 0;
+  std::string_view gates, nodes, connections, pins; // Records, past the count
+
+  bool Parse();
+  std::string_view String(uint32_t index) const;
+};
+
+// Whether bytes start like a BPL1 file
+bool IsGateLibraryFile(std::string_view bytes);
+bool WriteGateLibrary(const std::string &path,
+                      const std::vector<GateDefinitionRef> &definitions);
+} // namespace Logicarium
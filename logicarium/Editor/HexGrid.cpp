@@ -0,0 +1,146 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "HexGrid.hpp"
+#include <cmath>
+#include <imgui_internal.h>
+
+namespace Logicarium {
+// Hexagon size in canvas units at the finest level
+static constexpr float HexSize = 50.0f;
+// Coarser levels kick in when hexagons would get smaller than this on screen
+static constexpr float MinHexPixels = 20.0f;
+static constexpr float LineThickness = 1.5f;
+static constexpr float Sqrt3 = 1.7320508f;
+
+static constexpr int Corners = 6;
+
+void HexGrid::Build(float hexSize, ImVec2 viewSize, ImU32 color,
+                    bool antiAliased, float fringe, ImVec2 uv) {
+  builtHexSize = hexSize;
+  builtViewSize = viewSize;
+  builtColor = color;
+  builtAntiAliased = antiAliased;
+
+  // Outline corners are pushed out along the corner direction; at a hexagon
+  // corner the miter is 1 / cos(30deg) times the half thickness
+  float half = antiAliased ? ImMax(LineThickness - fringe, 0.0f) * 0.5f
+                           : LineThickness * 0.5f;
+  float miter = 2.0f / Sqrt3;
+  float radius = hexSize * 0.5f;
+  ImU32 transparent = color & ~IM_COL32_A_MASK;
+
+  // Corner rings, innermost last: fringe, line, line, fringe
+  float ringRadius[4];
+  ImU32 ringColor[4];
+  int rings = antiAliased ? 4 : 2;
+  vertsPerHex = Corners * rings;
+  if (antiAliased) {
+    ringRadius[0] = radius + (half + fringe) * miter;
+    ringRadius[1] = radius + half * miter;
+    ringRadius[2] = radius - half * miter;
+    ringRadius[3] = radius - (half + fringe) * miter;
+    ringColor[0] = ringColor[3] = transparent;
+    ringColor[1] = ringColor[2] = color;
+  } else {
+    ringRadius[0] = radius + half * miter;
+    ringRadius[1] = radius - half * miter;
+    ringColor[0] = ringColor[1] = color;
+  }
+
+  ImVec2 corner[Corners];
+  for (int i = 0; i < Corners; ++i) {
+    float angle = IM_PI / 3.0f * (i + 0.5f);
+    corner[i] = ImVec2(cosf(angle), sinf(angle));
+  }
+
+  hexIndices.clear();
+  for (int i = 0; i < Corners; ++i) {
+    int a = i * rings;
+    int b = ((i + 1) % Corners) * rings;
+    for (int band = 0; band < rings - 1; ++band) {
+      hexIndices.push_back((ImDrawIdx)(a + band));
+      hexIndices.push_back((ImDrawIdx)(a + band + 1));
+      hexIndices.push_back((ImDrawIdx)(b + band + 1));
+      hexIndices.push_back((ImDrawIdx)(a + band));
+      hexIndices.push_back((ImDrawIdx)(b + band + 1));
+      hexIndices.push_back((ImDrawIdx)(b + band));
+    }
+  }
+
+  // Enough rows and columns to cover the view from a lattice point up to one
+  // period (one column, two rows) before its corner
+  float spacingX = hexSize * Sqrt3;
+  float spacingY = hexSize * 1.5f;
+  int cols = (int)ceilf(viewSize.x / spacingX) + 2;
+  int rows = (int)ceilf(viewSize.y / spacingY) + 3;
+
+  vertices.clear();
+  vertices.reserve((size_t)(cols + 1) * (rows + 1) * Corners * rings);
+  for (int y = -1; y < rows; ++y)
+    for (int x = -1; x < cols; ++x) {
+      ImVec2 center(x * spacingX, y * spacingY);
+      if (y % 2 != 0)
+        center.x += spacingX * 0.5f;
+      for (int i = 0; i < Corners; ++i)
+        for (int ring = 0; ring < rings; ++ring) {
+          ImDrawVert vertex;
+          vertex.pos = center + corner[i] * ringRadius[ring];
+          vertex.uv = uv;
+          vertex.col = ringColor[ring];
+          vertices.push_back(vertex);
+        }
+    }
+}
+
+void HexGrid::Draw(ImDrawList *drawList, ImVec2 pos, ImVec2 size, ImVec2 offset,
+                   float zoom, ImU32 color) {
+  if (size.x <= 0 || size.y <= 0 || zoom <= 0)
+    return;
+
+  float hexSize = HexSize * zoom;
+  while (hexSize < MinHexPixels)
+    hexSize *= 2.0f;
+
+  bool antiAliased = (drawList->Flags & ImDrawListFlags_AntiAliasedLines) != 0;
+  if (hexSize != builtHexSize || size.x != builtViewSize.x ||
+      size.y != builtViewSize.y || color != builtColor ||
+      antiAliased != builtAntiAliased)
+    Build(hexSize, size, color, antiAliased, drawList->_FringeScale,
+          drawList->_Data->TexUvWhitePixel);
+
+  // The built grid starts at a lattice point; pick the last one at or before
+  // the view corner
+  ImVec2 period(hexSize * Sqrt3, hexSize * 3.0f);
+  ImVec2 base(floorf(-offset.x / period.x) * period.x,
+              floorf(-offset.y / period.y) * period.y);
+  ImVec2 shift = pos + offset + base;
+
+  // Emitted in chunks so a single reservation stays within 16-bit indices
+  if (vertsPerHex == 0)
+    return;
+  int hexes = (int)vertices.size() / vertsPerHex;
+  int hexesPerChunk = 0xFFFF / vertsPerHex;
+
+  for (int first = 0; first < hexes; first += hexesPerChunk) {
+    int count = ImMin(hexesPerChunk, hexes - first);
+    drawList->PrimReserve(count * (int)hexIndices.size(), count * vertsPerHex);
+
+    const ImDrawVert *source = vertices.data() + (size_t)first * vertsPerHex;
+    for (int i = 0; i < count * vertsPerHex; ++i) {
+      drawList->_VtxWritePtr[i] = source[i];
+      drawList->_VtxWritePtr[i].pos += shift;
+    }
+    drawList->_VtxWritePtr += count * vertsPerHex;
+
+    ImDrawIdx start = (ImDrawIdx)drawList->_VtxCurrentIdx;
+    for (int hex = 0; hex < count; ++hex) {
+      ImDrawIdx hexStart = (ImDrawIdx)(start + hex * vertsPerHex);
+      for (ImDrawIdx index : hexIndices)
+        *drawList->_IdxWritePtr++ = (ImDrawIdx)(hexStart + index);
+    }
+    drawList->_VtxCurrentIdx += count * vertsPerHex;
+  }
+}
+} // namespace Logicarium
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pch.hpp"
+#include <vector>
+
+namespace Logicarium {
+// Canvas background of small hexagon outlines. The grid is periodic, so the
+// outlines covering the view are built once for a given hexagon size and
+// view size, then only shifted by the canvas offset each frame. Zoomed out,
+// the grid switches to every second hexagon (the same pattern at twice the
+// spacing) and so on, which keeps the number drawn bounded at any zoom.
+class HexGrid {
+public:
+  // Draws the grid over the rectangle at pos. offset and zoom are the
+  // canvas' own.
+  void Draw(ImDrawList *drawList, ImVec2 pos, ImVec2 size, ImVec2 offset,
+            float zoom, ImU32 color);
+
+private:
+  // Outlines of every hexagon in the view, relative to a lattice point
+  std::vector<ImDrawVert> vertices;
+  std::vector<ImDrawIdx> hexIndices; // One hexagon, relative to its first vertex
+  int vertsPerHex = 0;
+  float builtHexSize = 0;
+  ImVec2 builtViewSize;
+  ImU32 builtColor = 0;
+  bool builtAntiAliased = false;
+
+  void Build(float hexSize, ImVec2 viewSize, ImU32 color, bool antiAliased,
+             float fringe, ImVec2 uv);
+};
+} // namespace Logicarium
@@ -0,0 +1,133 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "Minimap.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Logicarium {
+static const ImU32 BackgroundColor = IM_COL32(16, 20, 28, 255);
+
+static Minimap::TextureBackend textureBackend;
+
+void Minimap::SetTextureBackend(const TextureBackend &backend) {
+  textureBackend = backend;
+}
+
+Minimap::~Minimap() {
+  if (texture && textureBackend.destroy)
+    textureBackend.destroy(texture);
+}
+
+void Minimap::Reset(const ImRect &area) {
+  ImVec2 center = area.GetCenter();
+  float half = std::max(std::max(area.GetWidth(), area.GetHeight()) * 0.5f,
+                        1.0f);
+  bounds = ImRect(center - ImVec2(half, half), center + ImVec2(half, half));
+  scale = Size / (half * 2.0f);
+  std::fill(std::begin(dirty), std::end(dirty), true);
+  dirtyCount = Tiles * Tiles;
+}
+
+void Minimap::MarkDirty(const ImRect &rect) {
+  auto tile = [&](float v, float origin) {
+    return std::clamp((int)floorf((v - origin) * scale / TileSize), 0,
+                      Tiles - 1);
+  };
+  if (!rect.Overlaps(bounds))
+    return;
+  int x0 = tile(rect.Min.x, bounds.Min.x), x1 = tile(rect.Max.x, bounds.Min.x);
+  int y0 = tile(rect.Min.y, bounds.Min.y), y1 = tile(rect.Max.y, bounds.Min.y);
+  for (int y = y0; y <= y1; ++y)
+    for (int x = x0; x <= x1; ++x) {
+      bool &flag = dirty[y * Tiles + x];
+      dirtyCount += !flag;
+      flag = true;
+    }
+}
+
+ImRect Minimap::BeginTile(int tile) {
+  clipX0 = (tile % Tiles) * TileSize;
+  clipY0 = (tile / Tiles) * TileSize;
+  clipX1 = clipX0 + TileSize;
+  clipY1 = clipY0 + TileSize;
+  for (int y = clipY0; y < clipY1; ++y)
+    std::fill_n(&pixels[y * Size + clipX0], TileSize, BackgroundColor);
+
+  ImVec2 min = bounds.Min + ImVec2((float)clipX0, (float)clipY0) / scale;
+  return ImRect(min, min + ImVec2(TileSize, TileSize) / scale);
+}
+
+void Minimap::Fill(const ImRect &rect, ImU32 color) {
+  int x0 = (int)floorf((rect.Min.x - bounds.Min.x) * scale);
+  int y0 = (int)floorf((rect.Min.y - bounds.Min.y) * scale);
+  int x1 = std::max((int)ceilf((rect.Max.x - bounds.Min.x) * scale), x0 + 1);
+  int y1 = std::max((int)ceilf((rect.Max.y - bounds.Min.y) * scale), y0 + 1);
+  x0 = std::max(x0, clipX0);
+  y0 = std::max(y0, clipY0);
+  x1 = std::min(x1, clipX1);
+  y1 = std::min(y1, clipY1);
+  for (int y = y0; y < y1; ++y)
+    for (int x = x0; x < x1; ++x)
+      pixels[y * Size + x] = color;
+}
+
+void Minimap::Upload() {
+  if (!textureBackend.create) {
+    std::fill(std::begin(dirty), std::end(dirty), false);
+    dirtyCount = 0;
+    return;
+  }
+  if (!texture) {
+    texture = textureBackend.create(Size, Size);
+    textureStale = true;
+  }
+  if (textureStale) {
+    textureBackend.update(texture, 0, 0, Size, Size, pixels.data(), Size);
+    textureStale = false;
+  } else {
+    // One upload per run of dirty tiles along a row
+    for (int row = 0; row < Tiles; ++row)
+      for (int x = 0; x < Tiles;) {
+        if (!dirty[row * Tiles + x]) {
+          ++x;
+          continue;
+        }
+        int end = x;
+        while (end < Tiles && dirty[row * Tiles + end])
+          ++end;
+        int px = x * TileSize, py = row * TileSize;
+        textureBackend.update(texture, px, py, (end - x) * TileSize, TileSize,
+                              &pixels[py * Size + px], Size);
+        x = end;
+      }
+  }
+  std::fill(std::begin(dirty), std::end(dirty), false);
+  dirtyCount = 0;
+}
+
+ImVec2 Minimap::ToCanvas(ImVec2 mapPoint, float size) const {
+  return bounds.Min + mapPoint * (bounds.GetWidth() / size);
+}
+
+void Minimap::Draw(ImDrawList *drawList, ImVec2 pos, float size,
+                   const ImRect &view) const {
+  ImVec2 max = pos + ImVec2(size, size);
+  drawList->AddRectFilled(pos - ImVec2(2, 2), max + ImVec2(2, 2),
+                          IM_COL32(0, 0, 0, 160), 4.0f);
+  if (texture)
+    drawList->AddImage(texture, pos, max);
+  else
+    drawList->AddRectFilled(pos, max, BackgroundColor);
+
+  // Canvas units to screen pixels on the map
+  float toScreen = size / bounds.GetWidth();
+  auto project = [&](ImVec2 p) { return pos + (p - bounds.Min) * toScreen; };
+  drawList->PushClipRect(pos, max, true);
+  drawList->AddRect(project(view.Min), project(view.Max),
+                    IM_COL32(255, 255, 255, 200), 0.0f, 0, 1.5f);
+  drawList->PopClipRect();
+  drawList->AddRect(pos, max, IM_COL32(100, 200, 255, 120), 0.0f, 0, 1.0f);
+}
+} // namespace Logicarium
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "pch.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Logicarium {
+// Overview of the whole canvas, rasterized on the CPU into a small texture.
+// The map is split into tiles and only tiles marked dirty (something over
+// them moved, changed state, appeared or went away) are redrawn and
+// re-uploaded, so a frame where nothing changed costs nothing however large
+// the scene is.
+class Minimap {
+public:
+  static constexpr int Size = 256;    // Texture edge, in pixels
+  static constexpr int TileSize = 32; // Redraw and upload granularity
+  static constexpr int Tiles = Size / TileSize;
+
+  // Texture hooks provided by the renderer. Without them the map is still
+  // kept up to date but shows no image.
+  struct TextureBackend {
+    ImTextureID (*create)(int width, int height) = nullptr;
+    // Uploads the width x height block at (x, y); rows of pixels are
+    // `stride` pixels apart
+    void (*update)(ImTextureID texture, int x, int y, int width, int height,
+                   const ImU32 *pixels, int stride) = nullptr;
+    void (*destroy)(ImTextureID texture) = nullptr;
+  };
+  static void SetTextureBackend(const TextureBackend &backend);
+
+  Minimap() = default;
+  ~Minimap();
+  Minimap(const Minimap &) = delete;
+  Minimap &operator=(const Minimap &) = delete;
+
+  // Maps the square around area (canvas units) onto the map and marks every
+  // tile dirty
+  void Reset(const ImRect &area);
+  bool Covers(const ImRect &rect) const { return bounds.Contains(rect); }
+  void MarkDirty(const ImRect &rect); // Canvas units
+  bool Dirty() const { return dirtyCount > 0; }
+
+  // Clears every dirty tile, calls paint(area) for each so the caller can
+  // Fill() what lies in that area (canvas units), then uploads them
+  template <typename F> void Redraw(F &&paint) {
+    for (int tile = 0; tile < Tiles * Tiles; ++tile) {
+      if (!dirty[tile])
+        continue;
+      ImRect area = BeginTile(tile);
+      paint(area);
+    }
+    Upload();
+  }
+  // Fills rect (canvas units), clipped to the tile being redrawn. Anything
+  // smaller than a pixel still covers one.
+  void Fill(const ImRect &rect, ImU32 color);
+
+  // Draws the map at pos, size x size pixels, with the outline of view
+  void Draw(ImDrawList *drawList, ImVec2 pos, float size,
+            const ImRect &view) const;
+  // Canvas point under a point on the map drawn size pixels wide
+  ImVec2 ToCanvas(ImVec2 mapPoint, float size) const;
+
+  const ImU32 *Pixels() const { return pixels.data(); }
+
+private:
+  ImRect bounds;      // Canvas area shown, always square
+  float scale = 1.0f; // Pixels per canvas unit
+  std::vector<ImU32> pixels = std::vector<ImU32>(Size * Size, 0);
+  bool dirty[Tiles * Tiles] = {};
+  int dirtyCount = 0;
+  int clipX0 = 0, clipY0 = 0, clipX1 = 0, clipY1 = 0; // Tile being redrawn
+  ImTextureID texture = nullptr;
+  bool textureStale = true; // Whole texture needs uploading
+
+  ImRect BeginTile(int tile);
+  void Upload();
+};
+} // namespace Logicarium
@@ -4,6 +4,8 @@
 
 #include "NodeEditor.hpp"
 #include "AI/AIAssistant.hpp"
+#include "Profiler.hpp"
+#include "Repaint.hpp"
 #include <imgui_internal.h>
 #include <map>
 #include <string>
@@ -12,13 +14,17 @@
 namespace Logicarium {
 inline void NodeEditor::RenderNode(Node *node) { node->Render(); }
 
-Node *nodeToDuplicate = nullptr;
-Node *nodeToEdit = nullptr;
-Node *nodeToDelete = nullptr;
-Node *nodeToSaveGate = nullptr;
-Node *nodeToRename = nullptr;
+// Deferred actions requested from node context menus. Held as handles so a
+// target that disappears before the action runs resolves to null.
+NodeHandle nodeToDuplicate = NullNodeHandle;
+NodeHandle nodeToEdit = NullNodeHandle;
+NodeHandle nodeToDelete = NullNodeHandle;
+NodeHandle nodeToSaveGate = NullNodeHandle;
+NodeHandle nodeToRename = NullNodeHandle;
 char renameBuf[128] = "";
 bool nodeHoveredForContextMenu = false;
+// Set while viewing a gate instance's internals, whose wiring is fixed
+bool wiringLocked = false;
 
 void NodeEditor::RenderDock() {
   if (!showDock)
@@ -61,8 +67,7 @@ void NodeEditor::RenderDock() {
   float xOffset = iconPadding;
   ImVec2 mousePos = ImGui::GetMousePos();
 
-  auto renderIcon = [&](const char *label, std::function<Node *()> factory,
-                        ImU32 color) {
+  auto renderIcon = [&](const PaletteEntry &entry) {
     ImVec2 center = ImVec2(dockPos.x + xOffset + iconSize * 0.5f,
                            dockPos.y + dockHeight * 0.5f);
     bool hovered = (mousePos.x >= dockPos.x + xOffset &&
@@ -79,16 +84,15 @@ void NodeEditor::RenderDock() {
     // Icon Circle
     drawList->AddCircleFilled(
         animatedCenter, currentSize * 0.5f,
-        (color & 0x00FFFFFF) | ((int)(0xDD * dockAlphaMultiplier) << 24), 32);
+        (entry.color & 0x00FFFFFF) | ((int)(0xDD * dockAlphaMultiplier) << 24),
+        32);
     drawList->AddCircle(
         animatedCenter, currentSize * 0.5f,
         IM_COL32(255, 255, 255, (int)(80 * dockAlphaMultiplier)), 32, 1.5f);
 
     // Symbol/Label in center
     ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[0]); // Use default font
-    std::string shortLabel = label;
-    if (shortLabel.size() > 4)
-      shortLabel = shortLabel.substr(0, 3) + ".";
+    const std::string &shortLabel = entry.icon;
 
     float fontSize = 14.0f * scale;
     ImVec2 textSize = ImGui::CalcTextSize(shortLabel.c_str());
@@ -105,13 +109,13 @@ void NodeEditor::RenderDock() {
     // Full Label Tooltip or hint
     if (hovered) {
       ImGui::BeginTooltip();
-      ImGui::Text("%s", label);
+      ImGui::Text("%s", entry.name.c_str());
       ImGui::EndTooltip();
 
-      if (ImGui::IsMouseClicked(0)) {
-        Node *newNode = factory();
+      if (ImGui::IsMouseClicked(0) && !StructureLocked()) {
+        Node *newNode = entry.create(*arena);
         nodes.push_back(newNode);
-        ImNodes::AutoPositionNode(newNode);
+        AutoPositionNode(newNode);
         // Attempt to make the node active immediately for dragging
         ImGui::SetActiveID(ImGui::GetID(newNode), ImGui::GetCurrentWindow());
       }
@@ -120,23 +124,17 @@ void NodeEditor::RenderDock() {
     xOffset += iconSize + iconPadding;
   };
 
-  for (auto &f : availableNodes) {
-    Node *tmp = f();
-    renderIcon(tmp->title, f, tmp->GetColor());
-    delete tmp;
-  }
+  for (const auto &entry : availableNodes)
+    renderIcon(entry);
 
-  for (auto &f : availableGates) {
-    Node *tmp = f();
-    renderIcon(tmp->title, f, tmp->GetColor());
-    delete tmp;
-  }
+  for (const auto &entry : availableGates)
+    renderIcon(entry);
 }
 
 void NodeEditor::DuplicateNode(Node *node) {
   if (!node)
     return;
-  Node *newNode = CreateNodeByType(node->title);
+  Node *newNode = CreateNodeByType(*arena, node->type);
   if (newNode) {
     newNode->pos = ImVec2(node->pos.x + 30.0f, node->pos.y + 30.0f);
     nodes.push_back(newNode);
@@ -145,15 +143,11 @@ void NodeEditor::DuplicateNode(Node *node) {
 }
 
 void NodeEditor::SelectAllNodes() {
-  for (auto *node : nodes) {
-    node->selected = true;
-  }
+  arena->ForEach([](Node *node) { node->selected = true; });
 }
 
 void NodeEditor::DeselectAllNodes() {
-  for (auto *node : nodes) {
-    node->selected = false;
-  }
+  arena->ForEach([](Node *node) { node->selected = false; });
 }
 
 void NodeEditor::DuplicateSelectedNodes() {
@@ -170,7 +164,7 @@ void NodeEditor::DuplicateSelectedNodes() {
   // Deselect originals, duplicate and select new ones
   for (auto *node : selected) {
     node->selected = false;
-    Node *newNode = CreateNodeByType(node->title);
+    Node *newNode = CreateNodeByType(*arena, node->type);
     if (newNode) {
       newNode->pos = ImVec2(node->pos.x + 30.0f, node->pos.y + 30.0f);
       newNode->selected = true;
@@ -179,28 +173,15 @@ void NodeEditor::DuplicateSelectedNodes() {
     }
   }
 
-  // Duplicate connections between selected nodes
+  // Duplicate connections between selected nodes (each wire is visited once,
+  // from its output side)
   for (auto *node : selected) {
-    for (const auto &conn : node->connections) {
-      // Only process connections where this node is the output (to avoid
-      // duplicating twice)
-      if (conn.outputNode != node)
-        continue;
-
-      Node *inputNode = (Node *)conn.inputNode;
-      Node *outputNode = (Node *)conn.outputNode;
-
+    for (const auto &conn : node->fanout) {
       // Check if both ends of the connection are in the selected set
-      if (originalToDuplicate.count(inputNode) &&
-          originalToDuplicate.count(outputNode)) {
-        Connection newConn;
-        newConn.inputNode = originalToDuplicate[inputNode];
-        newConn.inputSlot = conn.inputSlot;
-        newConn.outputNode = originalToDuplicate[outputNode];
-        newConn.outputSlot = conn.outputSlot;
-
-        ((Node *)newConn.inputNode)->connections.push_back(newConn);
-        ((Node *)newConn.outputNode)->connections.push_back(newConn);
+      if (originalToDuplicate.count(conn.inputNode) &&
+          originalToDuplicate.count(conn.outputNode)) {
+        Wires::Connect(originalToDuplicate[conn.outputNode], conn.outputSlot,
+                       originalToDuplicate[conn.inputNode], conn.inputSlot);
       }
     }
   }
@@ -219,22 +200,18 @@ void NodeEditor::FrameSelectedNodes() {
   for (auto *node : nodes) {
     if (node->selected) {
       hasSelection = true;
-      minPos.x = ImMin(minPos.x, node->pos.x);
-      minPos.y = ImMin(minPos.y, node->pos.y);
-      maxPos.x =
-          ImMax(maxPos.x, node->pos.x + 150.0f); // Approximate node width
-      maxPos.y =
-          ImMax(maxPos.y, node->pos.y + 80.0f); // Approximate node height
+      ImRect bounds = NodeBounds(node);
+      minPos = ImMin(minPos, bounds.Min);
+      maxPos = ImMax(maxPos, bounds.Max);
     }
   }
 
   if (!hasSelection) {
     // If nothing selected, frame all nodes
     for (auto *node : nodes) {
-      minPos.x = ImMin(minPos.x, node->pos.x);
-      minPos.y = ImMin(minPos.y, node->pos.y);
-      maxPos.x = ImMax(maxPos.x, node->pos.x + 150.0f);
-      maxPos.y = ImMax(maxPos.y, node->pos.y + 80.0f);
+      ImRect bounds = NodeBounds(node);
+      minPos = ImMin(minPos, bounds.Min);
+      maxPos = ImMax(maxPos, bounds.Max);
     }
   }
 
@@ -275,10 +252,16 @@ void NodeEditor::HandleKeyBindings() {
     SelectAllNodes();
   }
 
-  // Escape: Deselect all / cancel connection drop menu
+  // Escape: Cancel connection drop menu / deselect all / leave the gate
+  // being inspected
   if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+    bool anySelected = false;
+    for (Node *node : nodes)
+      anySelected |= node->selected;
     if (showConnectionDropMenu) {
       showConnectionDropMenu = false;
+    } else if (!anySelected && StructureLocked()) {
+      LeaveToLevel(hierarchy.size() - 1);
     } else {
       DeselectAllNodes();
     }
@@ -287,7 +270,7 @@ void NodeEditor::HandleKeyBindings() {
   // === EDITING ===
 
   // Ctrl+D: Duplicate selected
-  if (ctrl && ImGui::IsKeyPressed(ImGuiKey_D)) {
+  if (ctrl && ImGui::IsKeyPressed(ImGuiKey_D) && !StructureLocked()) {
     DuplicateSelectedNodes();
   }
 
@@ -295,7 +278,7 @@ void NodeEditor::HandleKeyBindings() {
   if (ImGui::IsKeyPressed(ImGuiKey_Backspace)) {
     for (auto *node : nodes) {
       if (node->selected) {
-        nodeToDelete = node;
+        nodeToDelete = node->handle;
         break;
       }
     }
@@ -305,7 +288,7 @@ void NodeEditor::HandleKeyBindings() {
   if (ImGui::IsKeyPressed(ImGuiKey_E) && !ctrl) {
     for (auto *node : nodes) {
       if (node->selected) {
-        nodeToEdit = node;
+        nodeToEdit = node->handle;
         break;
       }
     }
@@ -340,7 +323,7 @@ void NodeEditor::HandleKeyBindings() {
   if (ImGui::IsKeyPressed(ImGuiKey_Minus) ||
       ImGui::IsKeyPressed(ImGuiKey_KeypadSubtract)) {
     if (canvas) {
-      canvas->Zoom = ImMax(canvas->Zoom / 1.2f, 0.25f);
+      canvas->Zoom = ImMax(canvas->Zoom / 1.2f, 0.05f);
     }
   }
 
@@ -358,11 +341,21 @@ void NodeEditor::HandleKeyBindings() {
     showScriptEditor = !showScriptEditor;
   }
 
+  // F3: Toggle profiler
+  if (ImGui::IsKeyPressed(ImGuiKey_F3)) {
+    showProfiler = !showProfiler;
+  }
+
   // D: Toggle dock
   if (ImGui::IsKeyPressed(ImGuiKey_D) && !ctrl) {
     showDock = !showDock;
   }
 
+  // M: Toggle minimap
+  if (ImGui::IsKeyPressed(ImGuiKey_M) && !ctrl) {
+    showMinimap = !showMinimap;
+  }
+
   // === FILE OPERATIONS ===
 
   // Ctrl+S: Save scene
@@ -384,8 +377,10 @@ void NodeEditor::HandleKeyBindings() {
 }
 
 void NodeEditor::UpdateGateDefinitionFromCurrentScene(const std::string &name) {
-  for (auto &def : customGateDefinitions) {
-    if (def.name == name) {
+  for (auto &defRef : customGateDefinitions) {
+    if (defRef.Name() == name) {
+      // Definitions are shared and immutable: edit a copy and swap it in
+      GateDefinition def = *defRef.Get();
       def.nodes.clear();
       def.connections.clear();
       def.inputPinIndices.clear();
@@ -409,49 +404,449 @@ void NodeEditor::UpdateGateDefinitionFromCurrentScene(const std::string &name) {
       }
 
       for (auto *n : nodes) {
-        for (const auto &conn : n->connections) {
-          if (conn.outputNode == n) {
-            ConnectionDefinition cDef;
-            cDef.outputNodeId = nodeToId[n];
-            cDef.outputSlot = conn.outputSlot;
-            cDef.inputNodeId = nodeToId[(Node *)conn.inputNode];
-            cDef.inputSlot = conn.inputSlot;
-            def.connections.push_back(cDef);
-          }
+        for (const auto &conn : n->fanout) {
+          ConnectionDefinition cDef;
+          cDef.outputNodeId = nodeToId[n];
+          cDef.outputSlot = n->outputSlots[conn.outputSlot].title;
+          cDef.inputNodeId = nodeToId[conn.inputNode];
+          cDef.inputSlot = conn.inputNode->inputSlots[conn.inputSlot].title;
+          def.connections.push_back(cDef);
         }
       }
-      // Update the global registry as well
-      CustomGate::GateRegistry[name] = def;
+      // Update the global registry and the palette as well
+      defRef = CustomGate::GateRegistry.Register(std::move(def));
+      for (auto &entry : availableGates)
+        if (entry.name == name)
+          entry = MakeGatePaletteEntry(defRef);
       break;
     }
   }
 }
 
-inline void NodeEditor::RenderNodes() {
-  anyNodeDragged = false;
-  for (auto it = nodes.begin(); it != nodes.end();) {
-    Node *node = *it;
+// Extra room around the view before a node or wire counts as off-screen,
+// in canvas units. Covers node padding and the frame a drag moves things by.
+static constexpr float CullMargin = 32.0f;
+// Stand-in size for nodes that have never been laid out
+static const ImVec2 DefaultNodeSize(80.0f, 40.0f);
+// How close, in screen pixels, a dropped wire has to land to snap to a slot
+static constexpr float SnapRadius = 24.0f;
+
+ImRect NodeEditor::NodeBounds(const Node *node) const {
+  ImVec2 size = node->size.x > 0 ? node->size : DefaultNodeSize;
+  return ImRect(node->pos, node->pos + size);
+}
+
+static uint64_t WireKey(NodeHandle inputNode, int inputSlot) {
+  return ((uint64_t)inputNode << 32) | (uint32_t)inputSlot;
+}
+static uint64_t WireKey(const Node *inputNode, int inputSlot) {
+  return WireKey(inputNode->handle, inputSlot);
+}
 
-    RenderNode(node);
+void NodeEditor::IndexWire(Node *inputNode, int inputSlot) {
+  const Driver &driver = inputNode->drivers[inputSlot];
+  if (!driver.node) {
+    wireIndex.Remove(WireKey(inputNode, inputSlot));
+    return;
+  }
+
+  ImVec2 from = driver.node->pos;
+  if (driver.slot < (int)driver.node->outputAnchors.size())
+    from += driver.node->outputAnchors[driver.slot];
+  ImVec2 to = inputNode->pos;
+  if (inputSlot < (int)inputNode->inputAnchors.size())
+    to += inputNode->inputAnchors[inputSlot];
+
+  // The curve never leaves the box spanned by its endpoints, widened by the
+  // curve strength on either side
+  ImRect bounds(ImMin(from, to), ImMax(from, to));
+  bounds.Expand(ImVec2(ImNodes::Ez::GetState().Style.CurveStrength, 0));
+  wireIndex.Update(WireKey(inputNode, inputSlot), bounds);
+}
 
-    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0))
-      anyNodeDragged = true;
+void NodeEditor::UpdateNodeBounds(Node *node) {
+  ImRect before;
+  bool wasIndexed = nodeIndex.Find(node->handle, &before);
+  ImRect bounds = NodeBounds(node);
+  if (!nodeIndex.Update(node->handle, bounds))
+    return;
+  if (showMinimap && !minimapStale) {
+    if (wasIndexed)
+      minimap.MarkDirty(before);
+    if (minimap.Covers(bounds))
+      minimap.MarkDirty(bounds);
+    else
+      minimapStale = true; // Moved off the map, which has to grow
+  }
+  for (int i = 0; i < (int)node->drivers.size(); ++i)
+    IndexWire(node, i);
+  for (const auto &connection : node->fanout)
+    IndexWire(connection.inputNode, connection.inputSlot);
+}
 
-    if (node->selected && ImGui::IsKeyPressedMap(ImGuiKey_Delete) &&
-        ImGui::IsWindowFocused()) {
-      for (auto &connection : node->connections) {
-        if (connection.outputNode == node) {
-          ((Node *)connection.inputNode)->DeleteConnection(connection);
+// Nodes and wires are only added or removed through the arena and Wires,
+// which log what they change, so the indexes are patched with just that.
+// They are rebuilt when the log doesn't reach back far enough: after a
+// Clear(), a change of level or a very large edit. Moves are patched in as
+// they happen.
+void NodeEditor::SyncSpatialIndex() {
+  bool rebuild = false;
+  if (indexedArenaRevision != arena->Revision()) {
+    changedNodes.clear();
+    rebuild = !arena->ChangesSince(indexedArenaRevision, changedNodes);
+    if (rebuild) {
+      arena->TrackChanges();
+      nodeIndex.Clear();
+      drawOrderStale = true;
+      for (Node *node : nodes)
+        nodeIndex.Update(node->handle, NodeBounds(node));
+      minimapStale = true;
+    } else {
+      for (NodeHandle handle : changedNodes) {
+        if (Node *node = arena->Get(handle)) {
+          drawOrder.try_emplace(handle, nextDrawOrder++);
+          UpdateNodeBounds(node);
         } else {
-          ((Node *)connection.outputNode)->DeleteConnection(connection);
+          nodeIndex.Remove(handle);
+          drawOrder.erase(handle);
         }
       }
-      node->connections.clear();
+    }
+    indexedArenaRevision = arena->Revision();
+  }
+
+  if (drawOrderStale) {
+    drawOrder.clear();
+    for (uint32_t i = 0; i < (uint32_t)nodes.size(); ++i)
+      drawOrder[nodes[i]->handle] = i;
+    nextDrawOrder = (uint32_t)nodes.size();
+    drawOrderStale = false;
+  }
+
+  if (indexedWireRevision != Wires::Revision() || rebuild) {
+    changedWires.clear();
+    if (rebuild || !Wires::ChangesSince(indexedWireRevision, changedWires)) {
+      wireIndex.Clear();
+      for (Node *node : nodes)
+        for (int i = 0; i < (int)node->drivers.size(); ++i)
+          if (node->drivers[i].node)
+            IndexWire(node, i);
+    } else {
+      for (const Wires::Change &change : changedWires) {
+        Node *node = arena->Get(change.node);
+        if (node && change.inputSlot < (int)node->drivers.size())
+          IndexWire(node, change.inputSlot);
+        else // Its node is gone, so nothing else can be using the key
+          wireIndex.Remove(WireKey(change.node, change.inputSlot));
+      }
+    }
+    indexedWireRevision = Wires::Revision();
+  }
+}
+
+void NodeEditor::QueryNodes(const ImRect &area, std::vector<Node *> &out) {
+  out.clear();
+  nodeIndex.Query(area, [&](uint64_t id, const ImRect &) {
+    if (Node *node = arena->Get((NodeHandle)id))
+      out.push_back(node);
+  });
+  // Keep scene order, which is also the stacking order
+  std::sort(out.begin(), out.end(), [&](Node *a, Node *b) {
+    return drawOrder[a->handle] < drawOrder[b->handle];
+  });
+}
+
+Node *NodeEditor::NodeAt(ImVec2 point) {
+  Node *top = nullptr;
+  uint32_t topOrder = 0;
+  nodeIndex.Query(ImRect(point, point), [&](uint64_t id, const ImRect &) {
+    Node *node = arena->Get((NodeHandle)id);
+    if (node && (!top || drawOrder[node->handle] > topOrder)) {
+      top = node;
+      topOrder = drawOrder[node->handle];
+    }
+  });
+  return top;
+}
+
+ImVec2 NodeEditor::MouseCanvasPos() const {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  return (ImGui::GetMousePos() - canvasWindowPos - canvas->Offset) /
+         canvas->Zoom;
+}
+
+void NodeEditor::AutoPositionNode(Node *node) {
+  // Start under the mouse, so culling keeps the node laid out until ImNodes
+  // has centred it there
+  node->pos = MouseCanvasPos();
+  ImNodes::AutoPositionNode(node);
+}
+
+bool NodeEditor::SnapConnection(Node *source, const char *slotTitle,
+                                int slotKind) {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  bool fromInput = ImNodes::IsInputSlotKind(slotKind);
+  ImVec2 mouse = MouseCanvasPos();
+  float radius = SnapRadius / canvas->Zoom;
+
+  Node *best = nullptr;
+  int bestSlot = -1;
+  float bestDistance = radius * radius;
+  ImRect area(mouse, mouse);
+  area.Expand(radius);
+  nodeIndex.Query(area, [&](uint64_t id, const ImRect &) {
+    Node *node = arena->Get((NodeHandle)id);
+    if (!node || node == source)
+      return;
+    // Inputs pair with outputs and vice versa
+    const auto &anchors = fromInput ? node->outputAnchors : node->inputAnchors;
+    for (int i = 0; i < (int)anchors.size(); ++i) {
+      float distance = ImLengthSqr(node->pos + anchors[i] - mouse);
+      if (distance < bestDistance) {
+        best = node;
+        bestSlot = i;
+        bestDistance = distance;
+      }
+    }
+  });
+  if (!best)
+    return false;
+
+  if (fromInput)
+    return Wires::Connect(best, bestSlot, source,
+                          source->FindInputSlot(slotTitle));
+  return Wires::Connect(source, source->FindOutputSlot(slotTitle), best,
+                        bestSlot);
+}
 
-      delete node;
-      it = nodes.erase(it);
-    } else
-      ++it;
+void NodeEditor::RecordNodeLayout(Node *node, ImVec2 drawnAt) {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  // Screen position the node's top-left corner was drawn at
+  ImVec2 origin =
+      ImGui::GetWindowPos() + drawnAt * canvas->Zoom + canvas->Offset;
+  node->size = (ImGui::GetItemRectMax() - origin) / canvas->Zoom;
+
+  ImVec2 slotPos;
+  node->inputAnchors.resize(node->inputSlotCount);
+  for (int i = 0; i < node->inputSlotCount; ++i) {
+    ImNodes::GetSlotPosition(node, node->inputSlots[i].title, true, &slotPos);
+    node->inputAnchors[i] = (slotPos - origin) / canvas->Zoom;
+  }
+  node->outputAnchors.resize(node->outputSlotCount);
+  for (int i = 0; i < node->outputSlotCount; ++i) {
+    ImNodes::GetSlotPosition(node, node->outputSlots[i].title, false, &slotPos);
+    node->outputAnchors[i] = (slotPos - origin) / canvas->Zoom;
+  }
+}
+
+inline void NodeEditor::RenderNodes() {
+  PROFILE_ZONE("RenderNodes");
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  const ImGuiIO &io = ImGui::GetIO();
+  int frame = ImGui::GetFrameCount();
+  viewRect.Min = (ImVec2(0, 0) - canvas->Offset) / canvas->Zoom;
+  viewRect.Max = (ImGui::GetWindowSize() - canvas->Offset) / canvas->Zoom;
+
+  SyncSpatialIndex();
+
+  anyNodeDragged = false;
+  NodeDetail detail = DetailForZoom(canvas->Zoom);
+  if (detail == NodeDetail::Full) {
+    ImRect area = viewRect;
+    area.Expand(CullMargin);
+    QueryNodes(area, visibleNodes);
+
+    bool selectionChanged = false;
+    bool groupDrag = false;
+    for (Node *node : visibleNodes) {
+      bool wasSelected = node->selected;
+      ImVec2 drawnAt = node->pos;
+      RenderNode(node);
+      RecordNodeLayout(node, drawnAt);
+      node->laidOutFrame = frame;
+
+      if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0)) {
+        anyNodeDragged = true;
+        groupDrag |= node->selected;
+      }
+      selectionChanged |= node->selected != wasSelected;
+      UpdateNodeBounds(node);
+    }
+
+    // ImNodes only moves and (de)selects the nodes it laid out. Carry a
+    // selection drag over to selected nodes outside the view, and let a plain
+    // click or box selection clear them too.
+    if (groupDrag) {
+      ImVec2 delta = io.MouseDelta / canvas->Zoom;
+      for (Node *node : nodes)
+        if (node->selected && node->laidOutFrame != frame) {
+          node->pos += delta;
+          UpdateNodeBounds(node);
+        }
+    }
+    bool clickedEmpty = ImGui::IsWindowHovered() && ImGui::IsMouseClicked(0) &&
+                        !ImGui::IsAnyItemHovered() && !NodeAt(MouseCanvasPos());
+    if ((selectionChanged || clickedEmpty) && !io.KeyCtrl && !io.KeyShift)
+      for (Node *node : nodes)
+        if (node->laidOutFrame != frame)
+          node->selected = false;
+  }
+
+  if (ImGui::IsKeyPressedMap(ImGuiKey_Delete) && ImGui::IsWindowFocused() &&
+      !StructureLocked()) {
+    for (auto it = nodes.begin(); it != nodes.end();) {
+      Node *node = *it;
+      if (node->selected) {
+        Wires::DisconnectAll(node);
+
+        arena->Destroy(node);
+        it = nodes.erase(it);
+      } else
+        ++it;
+    }
+  }
+
+  switch (detail) {
+  case NodeDetail::Full:
+    RenderWires();
+    break;
+  case NodeDetail::Boxes:
+    RenderWires();
+    RenderNodeBoxes();
+    break;
+  case NodeDetail::Tiles:
+    RenderDensityTiles();
+    break;
+  }
+}
+
+// Canvas position of a slot. Nodes laid out this frame have it fresh in
+// ImNodes' cache; for the rest it comes from the recorded anchors (or the
+// node corner if the node was never laid out).
+ImVec2 NodeEditor::SlotCanvasPos(Node *node, int slot, bool input) const {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  if (node->laidOutFrame == ImGui::GetFrameCount()) {
+    ImVec2 screen;
+    const auto &slots = input ? node->inputSlots : node->outputSlots;
+    ImNodes::GetSlotPosition(node, slots[slot].title, input, &screen);
+    return (screen - ImGui::GetWindowPos() - canvas->Offset) / canvas->Zoom;
+  }
+  const auto &anchors = input ? node->inputAnchors : node->outputAnchors;
+  return slot < (int)anchors.size() ? node->pos + anchors[slot] : node->pos;
+}
+
+static ImU32 WireColor(Node *source, int slot, Node *target) {
+  // Highlight wires between two selected nodes
+  if (source->selected && target->selected)
+    return IM_COL32(0, 200, 255, 255);
+  return source->GetWireColor(slot);
+}
+
+// Wires are drawn once every node is laid out, so slot positions are current.
+// Only wires whose bounding box reaches into the view are visited. They are
+// drawn in one batch by the WireRenderer; the few that need ImNodes' own
+// handling go through ImNodes::Connection instead: the wire under the mouse
+// (hover highlight, double-click to remove) and wires on the slot a new
+// connection is being dragged from (ImNodes uses them to rule out duplicates).
+void NodeEditor::RenderWires() {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  ImVec2 origin = ImGui::GetWindowPos() + canvas->Offset;
+  int frame = ImGui::GetFrameCount();
+  // ImNodes tucks wire ends slightly into the slot widgets
+  ImVec2 indent(canvas->Style.ConnectionIndent, 0);
+
+  ImRect area = viewRect;
+  area.Expand(CullMargin);
+  visibleWires.clear();
+  wireIndex.Query(area, [&](uint64_t id, const ImRect &) {
+    visibleWires.push_back(id);
+  });
+
+  void *pendingNode = nullptr;
+  const char *pendingSlot = nullptr;
+  int pendingKind = 0;
+  bool pending =
+      ImNodes::GetPendingConnection(&pendingNode, &pendingSlot, &pendingKind);
+  bool pendingInput = pending && ImNodes::IsInputSlotKind(pendingKind);
+
+  // Wires handed to ImNodes last frame go through it once more, so it can
+  // clear the hover state it keeps for their slots
+  std::swap(interactiveWires, lastInteractiveWires);
+  interactiveWires.clear();
+
+  wireRenderer.Begin(frame);
+  for (uint64_t id : visibleWires) {
+    // Deleted nodes and removed wires linger until the next rebuild
+    Node *target = arena->Get((NodeHandle)(id >> 32));
+    int inputSlot = (int)(uint32_t)id;
+    if (!target || inputSlot >= (int)target->drivers.size())
+      continue;
+    const Driver &driver = target->drivers[inputSlot];
+    Node *node = driver.node;
+    if (!node)
+      continue;
+
+    ImVec2 from = SlotCanvasPos(node, driver.slot, false) - indent;
+    ImVec2 to = SlotCanvasPos(target, inputSlot, true) + indent;
+    wireRenderer.Add(id, from, to, WireColor(node, driver.slot, target),
+                     canvas->Style.CurveStrength);
+
+    if (pending &&
+        (pendingInput
+             ? pendingNode == target &&
+                   strcmp(pendingSlot, target->inputSlots[inputSlot].title) == 0
+             : pendingNode == node &&
+                   strcmp(pendingSlot, node->outputSlots[driver.slot].title) ==
+                       0))
+      interactiveWires.push_back(id);
+  }
+
+  if (uint64_t hovered = wireRenderer.HitTest(MouseCanvasPos(),
+                                              canvas->Style.CurveThickness))
+    interactiveWires.push_back(hovered);
+  for (uint64_t id : lastInteractiveWires)
+    if (std::find(interactiveWires.begin(), interactiveWires.end(), id) ==
+        interactiveWires.end())
+      interactiveWires.push_back(id);
+
+  for (uint64_t id : interactiveWires)
+    wireRenderer.Skip(id);
+  ImNodes::Ez::BeginConnectionLayer();
+  wireRenderer.Draw(ImGui::GetWindowDrawList(), origin, canvas->Zoom,
+                    canvas->Style.CurveThickness * canvas->Zoom);
+
+  ImColor originalConnectionColor = canvas->Colors[ImNodes::ColConnection];
+  for (uint64_t id : interactiveWires) {
+    Node *target = arena->Get((NodeHandle)(id >> 32));
+    int inputSlot = (int)(uint32_t)id;
+    if (!target || inputSlot >= (int)target->drivers.size())
+      continue;
+    const Driver &driver = target->drivers[inputSlot];
+    Node *node = driver.node;
+    if (!node)
+      continue;
+    const char *outputTitle = node->outputSlots[driver.slot].title;
+    const char *inputTitle = target->inputSlots[inputSlot].title;
+
+    // ImNodes reads slot positions from its cache, which is only fresh for
+    // nodes it laid out this frame
+    if (node->laidOutFrame != frame)
+      ImNodes::SetSlotPosition(
+          node, outputTitle, false,
+          origin + SlotCanvasPos(node, driver.slot, false) * canvas->Zoom);
+    if (target->laidOutFrame != frame)
+      ImNodes::SetSlotPosition(
+          target, inputTitle, true,
+          origin + SlotCanvasPos(target, inputSlot, true) * canvas->Zoom);
+
+    canvas->Colors[ImNodes::ColConnection] =
+        WireColor(node, driver.slot, target);
+    bool connected =
+        ImNodes::Ez::Connection(target, inputTitle, node, outputTitle);
+    canvas->Colors[ImNodes::ColConnection] = originalConnectionColor;
+
+    if (!connected && !StructureLocked())
+      Wires::Disconnect(target, inputSlot);
   }
 }
 
@@ -460,26 +855,24 @@ inline void NodeEditor::RenderContextMenu() {
       ImGui::BeginPopupContextWindow("NodesContextMenu",
                                      ImGuiPopupFlags_MouseButtonRight |
                                          ImGuiPopupFlags_NoOpenOverItems)) {
-    for (const auto &desc : availableNodes) {
-      auto item = desc();
-      if (ImGui::MenuItem(item->title)) {
-        nodes.push_back(item);
-        ImNodes::AutoPositionNode(nodes.back());
+    ImGui::BeginDisabled(StructureLocked());
+    for (const auto &entry : availableNodes) {
+      if (ImGui::MenuItem(entry.name.c_str())) {
+        nodes.push_back(entry.create(*arena));
+        AutoPositionNode(nodes.back());
       }
     }
     ImGui::Separator();
     if (ImGui::BeginMenu("Gates")) {
-      for (const auto &desc : availableGates) {
-        auto item = desc();
-        if (ImGui::MenuItem(item->title)) {
-          nodes.push_back(item);
-          ImNodes::AutoPositionNode(nodes.back());
-        } else {
-          delete item; // Don't leak if not clicked
+      for (const auto &entry : availableGates) {
+        if (ImGui::MenuItem(entry.name.c_str())) {
+          nodes.push_back(entry.create(*arena));
+          AutoPositionNode(nodes.back());
         }
       }
       ImGui::EndMenu();
     }
+    ImGui::EndDisabled();
 
     ImGui::Separator();
     if (ImGui::MenuItem("Reset Zoom"))
@@ -491,6 +884,7 @@ inline void NodeEditor::RenderContextMenu() {
 void NodeEditor::Redraw() {
   // Update AI assistant streaming
   if (aiAssistant) {
+    PROFILE_ZONE("AI Update");
     aiAssistant->Update();
   }
 
@@ -498,108 +892,96 @@ void NodeEditor::Redraw() {
 
   // Handle global interaction requests
   if (nodeToDuplicate) {
-    DuplicateNode(nodeToDuplicate);
-    nodeToDuplicate = nullptr;
+    if (!StructureLocked())
+      DuplicateNode(arena->Get(nodeToDuplicate));
+    nodeToDuplicate = NullNodeHandle;
   }
-  if (nodeToEdit) {
+  if (Node *editTarget = arena->Get(nodeToEdit)) {
     // Check if it's a custom gate or a standard gate
-    bool isCustom = CustomGate::GateRegistry.count(nodeToEdit->title);
+    bool isCustom = CustomGate::GateRegistry.Find(editTarget->type) != nullptr;
 
     if (isCustom) {
-      originalSceneScript = currentScript;
-      editingGateName = nodeToEdit->title;
-
-      // Find the definition
-      for (const auto &def : customGateDefinitions) {
-        if (def.name == editingGateName) {
-          // Clear current nodes
-          for (auto *n : nodes)
-            delete n;
-          nodes.clear();
-
-          // Map for ID reconstruction
-          std::map<int, Node *> idToNode;
-
-          // 1. Create nodes
-          for (const auto &nodeDef : def.nodes) {
-            Node *n = CreateNodeByType(nodeDef.type);
-            if (n) {
-              n->pos = nodeDef.pos;
-              n->id = "n" + std::to_string(nodeDef.id);
-              nodes.push_back(n);
-              idToNode[nodeDef.id] = n;
-            }
-          }
-
-          // 2. Create connections
-          for (const auto &connDef : def.connections) {
-            if (idToNode.count(connDef.inputNodeId) &&
-                idToNode.count(connDef.outputNodeId)) {
-              Connection conn;
-              conn.inputNode = idToNode[connDef.inputNodeId];
-              conn.inputSlot = connDef.inputSlot;
-              conn.outputNode = idToNode[connDef.outputNodeId];
-              conn.outputSlot = connDef.outputSlot;
-              ((Node *)conn.inputNode)->connections.push_back(conn);
-              ((Node *)conn.outputNode)->connections.push_back(conn);
-            }
-          }
-          UpdateScriptFromNodes();
-          lastParsedScript = ""; // Force reparse to ensure visual consistency
-          UpdateNodesFromScript();
-          break;
-        }
-      }
-    } else {
+      EnterGate((CustomGate *)editTarget);
+    } else if (!StructureLocked()) {
       // Standard gate - open code editor
-      gateBeingEdited = (Gate *)nodeToEdit;
-      editingCode = gateBeingEdited->GetCode();
+      gateBeingEdited = nodeToEdit;
+      editingCode = ((Gate *)editTarget)->GetCode();
       showCodeEditor = true;
     }
-    nodeToEdit = nullptr;
   }
-  if (nodeToDelete) {
+  nodeToEdit = NullNodeHandle;
+  if (StructureLocked())
+    nodeToDelete = NullNodeHandle;
+  if (Node *deleteTarget = arena->Get(nodeToDelete)) {
     for (auto it = nodes.begin(); it != nodes.end(); ++it) {
-      if (*it == nodeToDelete) {
+      if (*it == deleteTarget) {
         // Handle connections
-        for (auto &connection : (*it)->connections) {
-          if (connection.outputNode == *it) {
-            ((Node *)connection.inputNode)->DeleteConnection(connection);
-          } else {
-            ((Node *)connection.outputNode)->DeleteConnection(connection);
-          }
-        }
-        delete *it;
+        Wires::DisconnectAll(*it);
+        arena->Destroy(*it);
         nodes.erase(it);
         break;
       }
     }
-    nodeToDelete = nullptr;
   }
+  nodeToDelete = NullNodeHandle;
 
   // Handle saving a temporary gate to permanent library
-  if (nodeToSaveGate) {
-    std::string gateNameToSave = nodeToSaveGate->title;
-    if (CustomGate::GateRegistry.count(gateNameToSave)) {
-      auto &def = CustomGate::GateRegistry[gateNameToSave];
-      if (def.isTemporary) {
-        // Mark as permanent
-        def.isTemporary = false;
-
-        // Add to customGateDefinitions for serialization
-        customGateDefinitions.push_back(def);
-
-        // Add to availableGates to show in the dock
-        availableGates.push_back(
-            [def]() -> Gate * { return new CustomGate(def); });
-      }
+  if (Node *saveTarget = arena->Get(nodeToSaveGate)) {
+    const auto &registered = CustomGate::GateRegistry.Find(saveTarget->type);
+    if (registered && registered->isTemporary) {
+      // Mark as permanent (copy-on-write; placed instances keep their copy)
+      GateDefinition saved = *registered;
+      saved.isTemporary = false;
+      GateDefinitionRef def =
+          CustomGate::GateRegistry.Register(std::move(saved));
+
+      // Add to customGateDefinitions for serialization
+      customGateDefinitions.push_back(def);
+
+      // Add to availableGates to show in the dock
+      availableGates.push_back(MakeGatePaletteEntry(def));
     }
-    nodeToSaveGate = nullptr;
   }
+  nodeToSaveGate = NullNodeHandle;
+
+  // Script edits compiled in the background since the last frame
+  if (auto compiled = scriptCompiler.Take())
+    ApplyCompiledScript(*compiled);
 
   Node::GlobalFrameCount++;
-  auto context = ImNodes::Ez::CreateContext();
-  IM_UNUSED(context);
+
+  // Settle the whole circuit once per frame, whether or not it is on screen.
+  // Pulling from the sinks (nodes nothing reads, Out pins among them) first
+  // keeps the order a drawn scene would evaluate in; the pass over every node
+  // then reaches loops that feed no sink, such as a latch or ring oscillator
+  // only wired into itself. Evaluate is cached per frame, so nodes the sinks
+  // reached cost nothing the second time. Drawing hits the cached values.
+  // With power saving on nothing else wakes the main loop for a circuit that
+  // is still settling or a clock that keeps ticking, so any output changing
+  // asks for another frame.
+  {
+    PROFILE_ZONE("Simulation");
+    const std::vector<Node *> &scene = SceneNodes();
+    for (Node *node : scene)
+      if (node->fanout.empty())
+        node->Evaluate();
+    bool changed = simulatedOutputs.size() != scene.size();
+    simulatedOutputs.resize(scene.size());
+    for (size_t i = 0; i < scene.size(); ++i) {
+      Node *node = scene[i];
+      uint64_t outputs = node->Evaluate();
+      for (int slot = 1; slot < std::min(node->outputSlotCount, 64); ++slot)
+        outputs |= (uint64_t)node->Evaluate(slot) << slot;
+      changed |= outputs != simulatedOutputs[i];
+      simulatedOutputs[i] = outputs;
+    }
+    if (changed)
+      Repaint::Request();
+    // Gates being inspected update even when nothing in the scene reads them
+    for (const HierarchyLevel &level : hierarchy)
+      if (level.gate)
+        level.gate->Evaluate(0);
+  }
 
   // --- REMOVED REDUNDANT MENU BAR BLOCK ---
 
@@ -732,9 +1114,10 @@ void NodeEditor::Redraw() {
   // Rename Node Popup
   static bool renameStarted = false;
   static bool renameFocusOnce = false;
-  if (nodeToRename && !renameStarted) {
+  Node *renameTarget = arena->Get(nodeToRename);
+  if (renameTarget && !renameStarted) {
     ImGui::OpenPopup("RenameNodePopup");
-    strncpy(renameBuf, nodeToRename->id.c_str(), 127);
+    strncpy(renameBuf, renameTarget->id.c_str(), 127);
     renameBuf[127] = '\0';
     renameStarted = true;
     renameFocusOnce = true;
@@ -754,20 +1137,20 @@ void NodeEditor::Redraw() {
     if (ImGui::Button("Rename", ImVec2(120, 0)) ||
         ImGui::IsKeyPressed(ImGuiKey_Enter)) {
       std::string newName = renameBuf;
-      if (!newName.empty() && newName.find(' ') == std::string::npos) {
-        nodeToRename->id = newName;
+      if (renameTarget && !newName.empty() &&
+          newName.find(' ') == std::string::npos) {
+        renameTarget->id = newName;
         UpdateScriptFromNodes();
         lastParsedScript = currentScript;
-        strncpy(scriptBuf, currentScript.c_str(), 8191);
       }
-      nodeToRename = nullptr;
+      nodeToRename = NullNodeHandle;
       renameStarted = false;
       ImGui::CloseCurrentPopup();
     }
     ImGui::SameLine();
     if (ImGui::Button("Cancel", ImVec2(120, 0)) ||
         ImGui::IsKeyPressed(ImGuiKey_Escape)) {
-      nodeToRename = nullptr;
+      nodeToRename = NullNodeHandle;
       renameStarted = false;
       ImGui::CloseCurrentPopup();
     }
@@ -775,7 +1158,7 @@ void NodeEditor::Redraw() {
   } else {
     // If popup closed by clicking outside or other means
     if (renameStarted && !ImGui::IsPopupOpen("RenameNodePopup")) {
-      nodeToRename = nullptr;
+      nodeToRename = NullNodeHandle;
       renameStarted = false;
     }
   }
@@ -876,36 +1259,18 @@ void NodeEditor::Redraw() {
       if (ImGui::BeginMenu("View")) {
         ImGui::MenuItem("Scene Script", "Tab", &showScriptEditor);
         ImGui::MenuItem("Dock", "D", &showDock);
+        ImGui::MenuItem("Minimap", "M", &showMinimap);
+        ImGui::Separator();
+        ImGui::MenuItem("Profiler", "F3", &showProfiler);
+        bool powerSaving = Repaint::PowerSaving();
+        if (ImGui::MenuItem("Power Saving", nullptr, &powerSaving))
+          Repaint::SetPowerSaving(powerSaving);
         ImGui::EndMenu();
       }
       ImGui::EndMenuBar();
     }
 
-    // Editing Banner
-    if (!editingGateName.empty()) {
-      ImGui::PushStyleColor(ImGuiCol_ChildBg, IM_COL32(180, 100, 20, 200));
-      ImGui::BeginChild("EditingBanner", ImVec2(0, 40), true,
-                        ImGuiWindowFlags_NoScrollbar |
-                            ImGuiWindowFlags_NoScrollWithMouse);
-      ImGui::Text("Editing Gate: %s", editingGateName.c_str());
-      ImGui::SameLine(ImGui::GetContentRegionAvail().x - 200);
-      if (ImGui::Button("Save and Close", ImVec2(120, 0))) {
-        UpdateGateDefinitionFromCurrentScene(editingGateName);
-        currentScript = originalSceneScript;
-        lastParsedScript = ""; // Force reparse
-        UpdateNodesFromScript();
-        editingGateName = "";
-      }
-      ImGui::SameLine();
-      if (ImGui::Button("Discard", ImVec2(80, 0))) {
-        currentScript = originalSceneScript;
-        lastParsedScript = ""; // Force reparse
-        UpdateNodesFromScript();
-        editingGateName = "";
-      }
-      ImGui::EndChild();
-      ImGui::PopStyleColor();
-    }
+    RenderHierarchyBanner();
 
     // Missing Gates Warning Banner
     if (showMissingGatesBanner && !missingGateTypes.empty()) {
@@ -983,6 +1348,10 @@ void NodeEditor::Redraw() {
   canvasWindowPos = ImGui::GetWindowPos();
 
   HandleKeyBindings();
+  if (frameAllPending) {
+    FrameSelectedNodes();
+    frameAllPending = false;
+  }
 
   // --- Cyberpunk Visuals Start ---
 
@@ -991,49 +1360,17 @@ void NodeEditor::Redraw() {
   ImDrawList *drawList = ImGui::GetWindowDrawList();
   ImVec2 canvasPos = ImGui::GetCursorScreenPos();
   ImVec2 canvasSize = ImGui::GetContentRegionAvail();
+  canvasRect = ImRect(canvasPos, canvasPos + canvasSize);
 
   // Draw deep dark background
   drawList->AddRectFilled(
       canvasPos, ImVec2(canvasPos.x + canvasSize.x, canvasPos.y + canvasSize.y),
       IM_COL32(20, 20, 25, 255));
 
-  // Grid Logic
-  const float HEX_SIZE = 50.0f * canvas->Zoom;
-  const float SQRT3 = 1.7320508f;
-  const float HEX_W = HEX_SIZE * SQRT3;
-  const float HEX_H = HEX_SIZE * 2.0f;
-  const float HEX_X_SPACING = HEX_W;
-  const float HEX_Y_SPACING = HEX_H * 0.75f;
-
-  ImVec2 offset = canvas->Offset;
-
-  // Calculate visible range
-  int startX = (int)((-offset.x) / HEX_X_SPACING) - 1;
-  int startY = (int)((-offset.y) / HEX_Y_SPACING) - 1;
-  int endX = startX + (int)(canvasSize.x / HEX_X_SPACING) + 2;
-  int endY = startY + (int)(canvasSize.y / HEX_Y_SPACING) + 2;
-
-  ImColor gridColor = IM_COL32(50, 60, 70, 40); // Faint hex lines
-
-  for (int y = startY; y < endY; ++y) {
-    for (int x = startX; x < endX; ++x) {
-      float xPos = x * HEX_X_SPACING;
-      float yPos = y * HEX_Y_SPACING;
-      if (y % 2 != 0)
-        xPos += HEX_X_SPACING * 0.5f;
-
-      ImVec2 center =
-          ImVec2(canvasPos.x + offset.x + xPos, canvasPos.y + offset.y + yPos);
-
-      // Draw Hexagon
-      ImVec2 verts[6];
-      for (int i = 0; i < 6; ++i) {
-        float angle = 3.14159f / 3.0f * (i + 0.5f);
-        verts[i] = ImVec2(center.x + cos(angle) * HEX_SIZE * 0.5f,
-                          center.y + sin(angle) * HEX_SIZE * 0.5f);
-      }
-      drawList->AddPolyline(verts, 6, gridColor, true, 1.5f);
-    }
+  {
+    PROFILE_ZONE("Background");
+    hexGrid.Draw(drawList, canvasPos, canvasSize, canvas->Offset, canvas->Zoom,
+                 IM_COL32(50, 60, 70, 40)); // Faint hex lines
   }
 
   // 2. Glassmorphism Styles
@@ -1050,18 +1387,22 @@ void NodeEditor::Redraw() {
 
   ImGui::Text("Debug: %s", debugMsg.c_str());
 
+  // Ahead of the nodes, so clicks on the map don't reach nodes under it
+  HandleMinimapInput();
   RenderNodes();
+  RenderMinimap();
 
   RenderContextMenu();
 
   // Detect connection dropped in empty space
-  if (!showConnectionDropMenu) {
+  if (!showConnectionDropMenu && !StructureLocked()) {
     void *srcNode;
     const char *srcSlot;
     int srcKind;
     if (ImNodes::GetPendingConnection(&srcNode, &srcSlot, &srcKind)) {
       const ImGuiPayload *payload = ImGui::GetDragDropPayload();
-      if (payload && ImGui::IsMouseReleased(0) && !payload->Delivery) {
+      if (payload && ImGui::IsMouseReleased(0) && !payload->Delivery &&
+          !SnapConnection((Node *)srcNode, srcSlot, srcKind)) {
         dropSourceNode = srcNode;
         dropSourceSlot = std::string(srcSlot);
         dropSourceSlotKind = srcKind;
@@ -1093,44 +1434,57 @@ void NodeEditor::Redraw() {
     // Header Row
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
     ImGui::Text("Scene Script");
+    if (currentScript != lastParsedScript) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("(compiling)");
+    }
     ImGui::SameLine(ImGui::GetContentRegionAvail().x - 90);
     if (ImGui::SmallButton("Sync")) {
       UpdateScriptFromNodes();
     }
     ImGui::SameLine();
+    ImGui::BeginDisabled(StructureLocked());
     if (ImGui::SmallButton("Apply")) {
       lastParsedScript = ""; // Force reparse
       UpdateNodesFromScript();
     }
+    ImGui::EndDisabled();
     ImGui::PopStyleVar(); // FramePadding
 
     // Only update script from nodes if the user isn't currently typing in the
     // editor
     static bool scriptActive = false;
 
-    if (!scriptActive) {
+    // or while an edit is still compiling: the graph doesn't reflect it yet,
+    // so regenerating would throw the edit away. Same while the script has
+    // errors, which would drop the broken lines before they can be fixed.
+    if (!scriptActive && currentScript == lastParsedScript &&
+        scriptErrors.empty()) {
       UpdateScriptFromNodes();
     }
 
-    // scriptBuf is now a member variable
-    static bool bufferInitialized = false;
-    if (!scriptActive || !bufferInitialized) {
-      strncpy(scriptBuf, currentScript.c_str(), 8191);
-      bufferInitialized = true;
+    // The editor works on currentScript itself, growing it as needed, so
+    // nothing is copied in or out per frame and nothing is truncated
+    ImGuiInputTextFlags scriptFlags = ImGuiInputTextFlags_CallbackResize;
+    if (StructureLocked())
+      scriptFlags |= ImGuiInputTextFlags_ReadOnly;
+    if (scriptJumpTo >= 0) {
+      // Only while jumping: the callback costs a pass over the text
+      scriptFlags |= ImGuiInputTextFlags_CallbackAlways;
+      ImGui::SetKeyboardFocusHere();
     }
-
     ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 5.0f);
     if (ImGui::InputTextMultiline(
-            "##script", scriptBuf, 8192,
-            ImVec2(-1, -ImGui::GetTextLineHeightWithSpacing() * 8))) {
-      currentScript = scriptBuf;
-      UpdateNodesFromScript();
+            "##script", currentScript.data(), currentScript.capacity() + 1,
+            ImVec2(-1, -ImGui::GetTextLineHeightWithSpacing() * 8),
+            scriptFlags, ScriptInputCallback, this)) {
+      QueueScriptCompile();
     }
     ImGui::PopStyleVar();
 
     scriptActive = ImGui::IsItemActive();
 
-    if (!scriptError.empty()) {
+    if (!scriptErrors.empty()) {
       ImGui::Separator();
       if (ImGui::Selectable(errorPanelCollapsed ? "> Show Errors"
                                                 : "v Hide Errors")) {
@@ -1139,10 +1493,17 @@ void NodeEditor::Redraw() {
       if (!errorPanelCollapsed) {
         ImGui::BeginChild("ErrorList", ImVec2(0, 150), true);
         ImGui::SetWindowFontScale(0.9f);
-        ImGui::TextWrapped("%s", scriptError.c_str());
+        // Clicking an error puts the cursor where it was found
+        for (int i = 0; i < (int)scriptErrors.size(); ++i) {
+          const ScriptError &error = scriptErrors[i];
+          ImGui::PushID(i);
+          if (ImGui::Selectable(FormatScriptError(error).c_str()))
+            scriptJumpTo = i;
+          ImGui::PopID();
+        }
         ImGui::EndChild();
       }
-    } // End of !scriptError.empty()
+    } // End of !scriptErrors.empty()
 
     // AI Assistant Section
     RenderAIAssistant();
@@ -1183,8 +1544,9 @@ void NodeEditor::Redraw() {
 
   if (ImGui::BeginPopupModal("Logic Editor", NULL,
                              ImGuiWindowFlags_AlwaysAutoResize)) {
-    ImGui::Text("Editing Logic for: %p (%s)", gateBeingEdited,
-                gateBeingEdited ? gateBeingEdited->title : "Unknown");
+    Gate *gateTarget = (Gate *)arena->Get(gateBeingEdited);
+    ImGui::Text("Editing Logic for: %p (%s)", (void *)gateTarget,
+                gateTarget ? gateTarget->title : "Unknown");
     ImGui::Separator();
 
     char codeBuf[1024];
@@ -1196,8 +1558,8 @@ void NodeEditor::Redraw() {
 
     ImGui::Separator();
     if (ImGui::Button("Apply", ImVec2(120, 0))) {
-      if (gateBeingEdited) {
-        gateBeingEdited->SetCode(editingCode);
+      if (gateTarget) {
+        gateTarget->SetCode(editingCode);
       }
       ImGui::CloseCurrentPopup();
     }
@@ -1207,6 +1569,9 @@ void NodeEditor::Redraw() {
     }
     ImGui::EndPopup();
   }
+
+  if (showProfiler)
+    Profiler::ShowOverlay(&showProfiler);
 }
 
 void NodeEditor::RenderConnectionDropMenu() {
@@ -1243,97 +1608,58 @@ void NodeEditor::RenderConnectionDropMenu() {
   if (ImGui::BeginPopup("ConnectionDropMenu")) {
     bool fromOutput = ImNodes::IsOutputSlotKind(dropSourceSlotKind);
 
-    for (const auto &desc : availableNodes) {
-      auto item = desc();
+    for (const auto &entry : availableNodes) {
       // Filter: if dragging from output, only show nodes with inputs
       // If dragging from input, only show nodes with outputs
       bool compatible =
-          fromOutput ? (item->inputSlotCount > 0) : (item->outputSlotCount > 0);
-      if (compatible && ImGui::MenuItem(item->title)) {
-        Node *newNode = desc();
+          fromOutput ? (entry.inputCount > 0) : (entry.outputCount > 0);
+      if (compatible && ImGui::MenuItem(entry.name.c_str())) {
+        Node *newNode = entry.create(*arena);
 
         // Position node at drop location (canvas coordinates)
         newNode->pos = (connectionDropPos - canvasWindowPos) / canvas->Zoom -
                        canvas->Offset;
         nodes.push_back(newNode);
 
-        // Create connection
-        Connection conn;
+        // Create connection (input pins only accept a single driver, which
+        // Connect() takes care of)
+        Node *sourceNode = (Node *)dropSourceNode;
         if (fromOutput) {
-          conn.outputNode = dropSourceNode;
-          conn.outputSlot = dropSourceSlot;
-          conn.inputNode = newNode;
-          conn.inputSlot = newNode->inputSlots[0].title;
+          Wires::Connect(sourceNode,
+                         sourceNode->FindOutputSlot(dropSourceSlot.c_str()),
+                         newNode, 0);
         } else {
-          // Input pins only accept single connection - remove existing one
-          Node *inputNode = (Node *)dropSourceNode;
-          for (auto it = inputNode->connections.begin();
-               it != inputNode->connections.end(); ++it) {
-            if (it->inputNode == dropSourceNode &&
-                it->inputSlot == dropSourceSlot) {
-              ((Node *)it->outputNode)->DeleteConnection(*it);
-              inputNode->connections.erase(it);
-              break;
-            }
-          }
-
-          conn.inputNode = dropSourceNode;
-          conn.inputSlot = dropSourceSlot;
-          conn.outputNode = newNode;
-          conn.outputSlot = newNode->outputSlots[0].title;
+          Wires::Connect(newNode, 0, sourceNode,
+                         sourceNode->FindInputSlot(dropSourceSlot.c_str()));
         }
 
-        ((Node *)conn.inputNode)->connections.push_back(conn);
-        ((Node *)conn.outputNode)->connections.push_back(conn);
-
         showConnectionDropMenu = false;
       }
-      delete item;
     }
 
     ImGui::Separator();
     if (ImGui::BeginMenu("Gates")) {
-      for (const auto &desc : availableGates) {
-        auto item = desc();
-        bool compatible = fromOutput ? (item->inputSlotCount > 0)
-                                     : (item->outputSlotCount > 0);
-        if (compatible && ImGui::MenuItem(item->title)) {
-          Node *newNode = desc();
+      for (const auto &entry : availableGates) {
+        bool compatible =
+            fromOutput ? (entry.inputCount > 0) : (entry.outputCount > 0);
+        if (compatible && ImGui::MenuItem(entry.name.c_str())) {
+          Node *newNode = entry.create(*arena);
           newNode->pos = (connectionDropPos - canvasWindowPos) / canvas->Zoom -
                          canvas->Offset;
           nodes.push_back(newNode);
 
-          Connection conn;
+          Node *sourceNode = (Node *)dropSourceNode;
           if (fromOutput) {
-            conn.outputNode = dropSourceNode;
-            conn.outputSlot = dropSourceSlot;
-            conn.inputNode = newNode;
-            conn.inputSlot = newNode->inputSlots[0].title;
+            Wires::Connect(sourceNode,
+                           sourceNode->FindOutputSlot(dropSourceSlot.c_str()),
+                           newNode, 0);
           } else {
-            // Input pins only accept single connection - remove existing one
-            Node *inputNode = (Node *)dropSourceNode;
-            for (auto it = inputNode->connections.begin();
-                 it != inputNode->connections.end(); ++it) {
-              if (it->inputNode == dropSourceNode &&
-                  it->inputSlot == dropSourceSlot) {
-                ((Node *)it->outputNode)->DeleteConnection(*it);
-                inputNode->connections.erase(it);
-                break;
-              }
-            }
-
-            conn.inputNode = dropSourceNode;
-            conn.inputSlot = dropSourceSlot;
-            conn.outputNode = newNode;
-            conn.outputSlot = newNode->outputSlots[0].title;
+            Wires::Connect(newNode, 0, sourceNode,
+                           sourceNode->FindInputSlot(dropSourceSlot.c_str()));
           }
 
-          ((Node *)conn.inputNode)->connections.push_back(conn);
-          ((Node *)conn.outputNode)->connections.push_back(conn);
-
           showConnectionDropMenu = false;
         }
-        delete item;
       }
       ImGui::EndMenu();
     }
@@ -1346,6 +1672,8 @@ void NodeEditor::RenderConnectionDropMenu() {
 }
 
 NodeEditor::NodeEditor() {
+  nodesContext = ImNodes::Ez::CreateContext();
+
   // Initialize AI Assistant
   aiAssistant = std::make_unique<AIAssistant>();
   aiAssistant->LoadConfig("ai_config.json");
@@ -1353,5 +1681,6 @@ NodeEditor::NodeEditor() {
 
 NodeEditor::~NodeEditor() {
   // Destructor needed for unique_ptr<AIAssistant> with forward declaration
+  ImNodes::Ez::FreeContext(nodesContext);
 }
 } // namespace Logicarium
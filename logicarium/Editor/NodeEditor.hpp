@@ -2,27 +2,112 @@
 
 #include "Connection.hpp"
 #include "Gates.hpp"
+#include "HexGrid.hpp"
+#include "Minimap.hpp"
 #include "Nodes.hpp"
+#include "ScriptCompiler.hpp"
+#include "SpatialIndex.hpp"
+#include "WireRenderer.hpp"
+#include <cstdio>
 #include <filesystem>
 #include <set>
+#include <string_view>
 #include <memory>
+#include <unordered_map>
 
 // Forward declarations
 namespace Logicarium {
   class AIAssistant;
+  struct SceneFile;
 }
 
 namespace Logicarium {
 class NodeEditor {
+  NodeArena sceneArena; // Owns every node in the top-level scene
+  // Arena and nodes of the level being viewed: the scene itself, or the
+  // internal graph of a gate drilled into (see hierarchy)
+  NodeArena *arena = &sceneArena;
   std::vector<Node *> nodes;
   char gateName[128] = "NewGate";
   float newGateColor[3] = {0.2f, 0.2f, 0.2f}; // Default color
   std::string debugMsg = "Ready";
   bool openCreateGatePopup = false;
   bool anyNodeDragged = false;
+  // Output slots of each scene node after the last simulation step, one bit
+  // per slot, to tell when the circuit changed and needs redrawing
+  std::vector<uint64_t> simulatedOutputs;
 
   void RenderNode(Node *node);
   void RenderNodes();
+  void RenderWires();
+
+  // Visible part of the canvas in canvas units, refreshed by RenderNodes
+  ImRect viewRect;
+  void RecordNodeLayout(Node *node, ImVec2 drawnAt);
+
+  // Spatial indexes over node rectangles and wire bounding boxes (wires keyed
+  // by their input pin). Patched as nodes and wires are added, removed or
+  // moved; rebuilt when the arena is cleared or the level changes.
+  SpatialIndex nodeIndex;
+  SpatialIndex wireIndex;
+  // By handle; ascending in `nodes` order, with new nodes after the rest
+  std::unordered_map<NodeHandle, uint32_t> drawOrder;
+  uint32_t nextDrawOrder = 0;
+  bool drawOrderStale = false; // `nodes` was reordered
+  uint64_t indexedArenaRevision = ~0ull;
+  uint64_t indexedWireRevision = ~0ull;
+  std::vector<NodeHandle> changedNodes; // Scratch for SyncSpatialIndex
+  std::vector<Wires::Change> changedWires;
+  std::vector<Node *> visibleNodes; // Scratch for range queries
+  std::vector<uint64_t> visibleWires;
+  WireRenderer wireRenderer;
+  HexGrid hexGrid;
+  std::vector<uint64_t> interactiveWires; // Wires drawn through ImNodes
+  std::vector<uint64_t> lastInteractiveWires;
+  ImVec2 SlotCanvasPos(Node *node, int slot, bool input) const;
+  void SyncSpatialIndex();
+  ImRect NodeBounds(const Node *node) const;
+  void UpdateNodeBounds(Node *node);
+  void IndexWire(Node *inputNode, int inputSlot);
+  // Nodes overlapping area, in scene (stacking) order
+  void QueryNodes(const ImRect &area, std::vector<Node *> &out);
+  // Top-most node under a canvas point
+  Node *NodeAt(ImVec2 point);
+  ImVec2 MouseCanvasPos() const;
+  void AutoPositionNode(Node *node);
+  // Connects a wire dropped near, rather than on, a compatible slot
+  bool SnapConnection(Node *source, const char *slotTitle, int slotKind);
+
+  // Zoomed out, full node widgets are unreadable and too costly, so the
+  // canvas falls back to flat boxes and then to aggregated density tiles
+  enum class NodeDetail { Full, Boxes, Tiles };
+  static NodeDetail DetailForZoom(float zoom);
+  void RenderNodeBoxes();
+  void RenderDensityTiles();
+  void CenterViewOn(ImVec2 point, float zoom);
+
+  struct DensityTile {
+    int nodes = 0;
+    int high = 0; // Nodes whose output is currently true
+    bool selected = false;
+  };
+  // Rebuilt every frame at tile detail; kept as members to reuse storage
+  std::unordered_map<uint32_t, DensityTile> densityTiles;
+  std::unordered_map<uint64_t, int> wireBundles; // Tile pair -> wire count
+
+  // Minimap overlay. Moves are marked on it as UpdateNodeBounds sees them;
+  // signal and selection changes are found by sweeping a slice of the nodes
+  // each frame against the state last painted for them.
+  Minimap minimap;
+  bool minimapStale = true;         // Rebuild everything, e.g. nodes added
+  std::vector<uint8_t> minimapDrawn; // Painted state, by index into `nodes`
+  size_t minimapSweep = 0;          // Next node to check
+  size_t minimapSweepLeft = 0;      // Nodes left in the current pass
+  bool minimapSweepChanged = false;
+  ImVec2 MinimapPos() const;
+  void HandleMinimapInput();
+  void SweepMinimap();
+  void RenderMinimap();
   void RenderContextMenu();
   void RenderDock();
   void RenderConnectionDropMenu();
@@ -35,15 +120,32 @@ class NodeEditor {
   std::string dropSourceSlot;
   int dropSourceSlotKind = 0;
   ImVec2 canvasWindowPos;
+  ImRect canvasRect; // On screen; the canvas column, not the whole window
   void CreateGate();
 
-  std::vector<GateDefinition> customGateDefinitions;
+  // The gate library. Gates from a BPL1 file stay unbuilt views into it until
+  // one is placed, entered or saved.
+  std::vector<LazyGateDefinition> customGateDefinitions;
+  // Libraries are saved as BPL1; the older .bin format still loads
   void SaveGates(const std::string &filename);
   void LoadGates(const std::string &filename);
+  void LoadLegacyGates(FILE *f);
 
-  // Scene save/load
+  // Scene save/load. Scenes are saved as BPS3; BPS1 and BPS2 still load.
   void SaveScene(const std::string &filename);
   void LoadScene(const std::string &filename);
+  // What LoadScene does once the old scene is cleared, per format
+  void LoadSceneFile(const SceneFile &scene);
+  // Imports the libraries a BPS3 scene's script imported, before its nodes
+  // are made, and puts them in the script in place of the old imports
+  void LoadSceneImports(const SceneFile &scene,
+                        const std::filesystem::path &directory);
+  void LoadLegacyScene(FILE *f, bool isV2);
+  // A loaded node, or a placeholder if its custom gate isn't registered
+  Node *CreateSceneNode(std::string_view type, int inputCount,
+                        int outputCount);
+  // Records a custom gate type the scene uses if it isn't registered
+  void NoteSceneDependency(std::string_view typeName);
 
   // Missing gate tracking (for custom gates not loaded)
   std::vector<std::string> missingGateTypes;
@@ -51,19 +153,86 @@ class NodeEditor {
   bool showMissingGatesBanner = false;
   void TryUpgradePlaceholders();
 
-  std::string editingGateName;
-  std::string originalSceneScript;
+  // Drill-down into custom gates. Each level shows one graph in place of its
+  // parent's, which stays alive underneath, so moving between levels is just
+  // swapping which arena and node list the editor works on.
+  struct HierarchyLevel {
+    std::string label; // Breadcrumb text
+    // Live instance whose internals are shown. Its wiring is fixed by the
+    // definition, so these levels can be inspected but not edited.
+    CustomGate *gate = nullptr;
+    // Editable copy of a definition's graph (gate is null)
+    std::unique_ptr<NodeArena> ownedArena;
+    std::string definitionName;
+    // Parent level, restored on the way out
+    NodeArena *parentArena = nullptr;
+    std::vector<Node *> parentNodes;
+    ImVec2 parentOffset;
+    float parentZoom = 1.0f;
+    std::string parentScript;
+    // What the parent's graph was last built from; differs from parentScript
+    // when an edit hadn't been applied yet
+    std::string parentParsedScript;
+    std::set<PlaceholderGate *> parentPlaceholders;
+  };
+  std::vector<HierarchyLevel> hierarchy; // Empty at the top-level scene
+  bool frameAllPending = false;
+  void EnterGate(CustomGate *gate);
+  void EditDefinition(const GateDefinitionRef &def);
+  // Pops back to the level at depth (0 is the scene)
+  void LeaveToLevel(size_t depth);
+  void PushLevel(HierarchyLevel level, NodeArena *levelArena,
+                 std::vector<Node *> levelNodes);
+  bool StructureLocked() const {
+    return !hierarchy.empty() && hierarchy.back().gate;
+  }
+  const std::vector<Node *> &SceneNodes() const {
+    return hierarchy.empty() ? nodes : hierarchy.front().parentNodes;
+  }
+  void RenderHierarchyBanner();
+  // Swaps node for a replacement built from the same type, carrying over
+  // position, id, selection and wires
+  void ReplaceNode(Node *node, Node *replacement);
+  // Rebuilds scene instances of custom gates that use the given type
+  void RefreshInstances(const std::string &type);
+
   void DuplicateNode(Node *node);
   void UpdateGateDefinitionFromCurrentScene(const std::string &name);
 
   std::string currentScript;
   std::string lastParsedScript;
-  std::string scriptError;
+  std::vector<ScriptError> scriptErrors;
+  LineIndex scriptLines; // Of the text the errors were found in
+  // Index of the error to select in the editor on the next frame, or -1
+  int scriptJumpTo = -1;
+  // Keeps currentScript's size in step with the editor, and selects the
+  // error being jumped to
+  static int ScriptInputCallback(ImGuiInputTextCallbackData *data);
   std::string scriptDefinitions; // Stores define...end blocks for preservation
   bool showScriptEditor = true;
   bool errorPanelCollapsed = false;
   void UpdateScriptFromNodes();
+  // Compiles and applies the script right away
   void UpdateNodesFromScript();
+  // Typing goes through the background compiler instead; each finished
+  // result is applied at the start of the next frame, and the graph stays as
+  // it was until then
+  ScriptCompiler scriptCompiler;
+  void QueueScriptCompile();
+  void ApplyCompiledScript(const CompiledScript &compiled);
+  // Adds a compile's definitions to the gate registry, keeping the
+  // registered copy of any that didn't change
+  void RegisterScriptDefinitions(const CompiledScript &compiled);
+  // Brings the graph in line with a parsed script, touching only the nodes
+  // and wires that differ
+  void ApplySceneScript(const ScriptAst &scene);
+  // What the last generated script was built from; regenerating is skipped
+  // while that and the text are unchanged
+  uint64_t scriptFingerprint = 0;
+  std::string generatedScript;
+
+  // Canvas state, styles and draw list splitters for ImNodes
+  ImNodes::Ez::Context *nodesContext = nullptr;
 
   // AI Assistant
   std::unique_ptr<AIAssistant> aiAssistant;
@@ -71,7 +240,6 @@ class NodeEditor {
   bool aiSectionCollapsed = false;
   std::string pendingAIScript;
   std::string lastAIPrompt;
-  char scriptBuf[8192] = ""; // Script editor buffer
   void RenderAIAssistant();
 
   bool openSaveGatePopup = false;
@@ -83,9 +251,11 @@ class NodeEditor {
   std::filesystem::path currentPath = std::filesystem::current_path();
 
   bool showCodeEditor = false;
+  bool showProfiler = false;
   std::string editingCode;
-  Gate *gateBeingEdited = nullptr;
+  NodeHandle gateBeingEdited = NullNodeHandle;
   bool showDock = true;
+  bool showMinimap = true;
 
   void HandleKeyBindings();
   void SelectAllNodes();
@@ -1,5 +1,6 @@
 #include "NodeEditor.hpp"
 #include "AI/AIAssistant.hpp"
+#include "Repaint.hpp"
 #include <imgui.h>
 #include <iostream>
 
@@ -75,6 +76,7 @@ namespace Logicarium {
             static float dotTimer = 0.0f;
             dotTimer += ImGui::GetIO().DeltaTime;
             int dotCount = ((int)(dotTimer * 2.0f)) % 4;
+            Repaint::Within(0.5);
             std::string dots = "";
             for (int i = 0; i < dotCount; i++) dots += ".";
             ImGui::SameLine();
@@ -135,13 +137,9 @@ namespace Logicarium {
                     pendingAIScript = response;
                 }
 
-                // Apply to script buffer (max 8191 chars + null terminator)
-                size_t copyLen = std::min(pendingAIScript.length(), (size_t)8191);
-                memcpy(scriptBuf, pendingAIScript.c_str(), copyLen);
-                scriptBuf[copyLen] = '\0';
-
                 // Update nodes from script
-                currentScript = scriptBuf;
+                LeaveToLevel(0);
+                currentScript = pendingAIScript;
                 UpdateNodesFromScript();
 
                 // Clear prompt and reset AI
@@ -1,6 +1,11 @@
 #include "../Nodes/Gates/CustomGate.hpp"
 #include "../Nodes/Gates/PlaceholderGate.hpp"
+#include "../Nodes/Gates/WordGate.hpp"
+#include "BinaryIO.hpp"
+#include "GateLibraryFile.hpp"
 #include "NodeEditor.hpp"
+#include "Profiler.hpp"
+#include "SceneFile.hpp"
 #include <ImNodes.h>
 #include <algorithm>
 #include <functional>
@@ -8,16 +13,41 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Logicarium {
 
 // Helper to check if a type is a built-in type (actually created by
 // CreateNodeByType)
-static bool IsBuiltInType(const std::string &type) {
+static bool IsBuiltInType(std::string_view type) {
   // Only types that CreateNodeByType can actually create without the registry
+  WordGate::Op op;
+  int width;
   return type == "AND" || type == "NOT" || type == "In" || type == "Out" ||
-         type == "Input" || type == "Output";
+         type == "Input" || type == "Output" ||
+         WordGate::ParseTypeName(type, op, width);
+}
+
+// A library path written relative to from, rewritten relative to to.
+// Absolute paths are left alone.
+static std::string RebaseImport(std::string_view path,
+                                const std::filesystem::path &from,
+                                const std::filesystem::path &to) {
+  namespace fs = std::filesystem;
+  fs::path target(path);
+  if (target.is_absolute())
+    return std::string(path);
+  auto directory = [](const fs::path &dir) {
+    std::error_code error;
+    fs::path full = fs::absolute(dir.empty() ? fs::path(".") : dir, error);
+    full = full.lexically_normal();
+    return full.has_filename() ? full : full.parent_path();
+  };
+  fs::path rebased =
+      (directory(from) / target).lexically_normal().lexically_relative(
+          directory(to));
+  return rebased.empty() ? std::string(path) : rebased.generic_string();
 }
 
 void NodeEditor::CreateGate() {
@@ -75,15 +105,13 @@ void NodeEditor::CreateGate() {
 
   // 2. Collect Connections
   for (auto *node : nodes) {
-    for (const auto &conn : node->connections) {
-      if (conn.outputNode == node) {
-        ConnectionDefinition cd;
-        cd.inputNodeId = nodePtrToId[(Node *)conn.inputNode];
-        cd.inputSlot = conn.inputSlot;
-        cd.outputNodeId = nodePtrToId[(Node *)conn.outputNode];
-        cd.outputSlot = conn.outputSlot;
-        def.connections.push_back(cd);
-      }
+    for (const auto &conn : node->fanout) {
+      ConnectionDefinition cd;
+      cd.inputNodeId = nodePtrToId[conn.inputNode];
+      cd.inputSlot = conn.inputNode->inputSlots[conn.inputSlot].title;
+      cd.outputNodeId = nodePtrToId[node];
+      cd.outputSlot = node->outputSlots[conn.outputSlot].title;
+      def.connections.push_back(cd);
     }
   }
 
@@ -101,96 +129,68 @@ void NodeEditor::CreateGate() {
                (int)(newGateColor[2] * 255), 200);
   def.isTemporary = false; // UI-created gates are permanent
 
-  customGateDefinitions.push_back(def);
-  CustomGate::GateRegistry[def.name] = def;
+  GateDefinitionRef registered =
+      CustomGate::GateRegistry.Register(std::move(def));
+  customGateDefinitions.push_back(registered);
 
-  availableGates.push_back([def]() -> Gate * { return new CustomGate(def); });
+  availableGates.push_back(MakeGatePaletteEntry(registered));
 }
 
 void NodeEditor::SaveGates(const std::string &filename) {
-  FILE *f = fopen(filename.c_str(), "wb");
-  if (!f)
-    return;
-
-  size_t count = customGateDefinitions.size();
-  fwrite(&count, sizeof(size_t), 1, f);
-
-  for (const auto &def : customGateDefinitions) {
-    // Name
-    size_t nameLen = def.name.size();
-    fwrite(&nameLen, sizeof(size_t), 1, f);
-    fwrite(def.name.c_str(), 1, nameLen, f);
-
-    // Color
-    fwrite(&def.color, sizeof(ImU32), 1, f);
-
-    // Nodes
-    size_t nodeCount = def.nodes.size();
-    fwrite(&nodeCount, sizeof(size_t), 1, f);
-    for (const auto &node : def.nodes) {
-      size_t typeLen = node.type.size();
-      fwrite(&typeLen, sizeof(size_t), 1, f);
-      fwrite(node.type.c_str(), 1, typeLen, f);
-      fwrite(&node.pos, sizeof(ImVec2), 1, f);
-      fwrite(&node.id, sizeof(int), 1, f);
-    }
-
-    // Connections
-    size_t connCount = def.connections.size();
-    fwrite(&connCount, sizeof(size_t), 1, f);
-    for (const auto &conn : def.connections) {
-      fwrite(&conn.inputNodeId, sizeof(int), 1, f);
-
-      size_t inSlotLen = conn.inputSlot.size();
-      fwrite(&inSlotLen, sizeof(size_t), 1, f);
-      fwrite(conn.inputSlot.c_str(), 1, inSlotLen, f);
-
-      fwrite(&conn.outputNodeId, sizeof(int), 1, f);
-
-      size_t outSlotLen = conn.outputSlot.size();
-      fwrite(&outSlotLen, sizeof(size_t), 1, f);
-      fwrite(conn.outputSlot.c_str(), 1, outSlotLen, f);
-    }
-
-    // Pin Indices
-    size_t inPinCount = def.inputPinIndices.size();
-    fwrite(&inPinCount, sizeof(size_t), 1, f);
-    fwrite(def.inputPinIndices.data(), sizeof(int), inPinCount, f);
-
-    size_t outPinCount = def.outputPinIndices.size();
-    fwrite(&outPinCount, sizeof(size_t), 1, f);
-    fwrite(def.outputPinIndices.data(), sizeof(int), outPinCount, f);
-
-    // Save pin names
-    size_t inNameCount = def.inputPinNames.size();
-    fwrite(&inNameCount, sizeof(size_t), 1, f);
-    for (const auto &name : def.inputPinNames) {
-      size_t len = name.size();
-      fwrite(&len, sizeof(size_t), 1, f);
-      fwrite(name.c_str(), 1, len, f);
-    }
-    size_t outNameCount = def.outputPinNames.size();
-    fwrite(&outNameCount, sizeof(size_t), 1, f);
-    for (const auto &name : def.outputPinNames) {
-      size_t len = name.size();
-      fwrite(&len, sizeof(size_t), 1, f);
-      fwrite(name.c_str(), 1, len, f);
-    }
-  }
-  fclose(f);
+  PROFILE_ZONE("Save Gates");
+  // Writing needs every definition built. Once built they let go of the
+  // library they came from, which unmaps it, so the file can be replaced
+  // even where a mapped file can't be.
+  std::vector<GateDefinitionRef> definitions;
+  definitions.reserve(customGateDefinitions.size());
+  for (const LazyGateDefinition &def : customGateDefinitions)
+    definitions.push_back(def.Get());
+  WriteGateLibrary(filename, definitions);
 }
 
 void NodeEditor::LoadGates(const std::string &filename) {
+  PROFILE_ZONE("Load Gates");
   FILE *f = fopen(filename.c_str(), "rb");
   if (!f)
     return;
+  char magic[4] = {};
+  bool isLibrary =
+      fread(magic, 1, 4, f) == 4 && IsGateLibraryFile({magic, sizeof(magic)});
+  std::shared_ptr<const GateLibraryFile> library;
+  if (isLibrary) {
+    fclose(f);
+    // Only the gate table is read; definitions are built as they are used
+    library = GateLibraryFile::Open(filename);
+    if (!library) {
+      debugMsg = "Gate library is damaged";
+      return;
+    }
+  }
+  LeaveToLevel(0);
 
   customGateDefinitions.clear();
-  availableGates = {
-      []() -> Gate * { return new AND(); },
-      []() -> Gate * { return new NOT(); },
-  };
+  availableGates = BuiltinGatePalette();
+
+  if (library) {
+    customGateDefinitions.reserve(library->Count());
+    availableGates.reserve(availableGates.size() + library->Count());
+    for (uint32_t i = 0; i < library->Count(); ++i) {
+      const LazyGateDefinition &registered = CustomGate::GateRegistry.Register(
+          LazyGateDefinition(library, i, library->Summary(i)));
+      customGateDefinitions.push_back(registered);
+      availableGates.push_back(MakeGatePaletteEntry(registered));
+    }
+  } else {
+    rewind(f);
+    LoadLegacyGates(f);
+    fclose(f);
+  }
 
+  // Try to upgrade any placeholder nodes that may now have their definitions
+  TryUpgradePlaceholders();
+}
+
+void NodeEditor::LoadLegacyGates(FILE *f) {
   size_t count = 0;
   fread(&count, sizeof(size_t), 1, f);
 
@@ -278,14 +278,11 @@ void NodeEditor::LoadGates(const std::string &filename) {
     }
 
     def.isTemporary = false; // Loaded gates are permanent
-    customGateDefinitions.push_back(def);
-    CustomGate::GateRegistry[def.name] = def;
-    availableGates.push_back([def]() -> Gate * { return new CustomGate(def); });
+    GateDefinitionRef registered =
+        CustomGate::GateRegistry.Register(std::move(def));
+    customGateDefinitions.push_back(registered);
+    availableGates.push_back(MakeGatePaletteEntry(registered));
   }
-  fclose(f);
-
-  // Try to upgrade any placeholder nodes that may now have their definitions
-  TryUpgradePlaceholders();
 }
 
 void NodeEditor::TryUpgradePlaceholders() {
@@ -296,49 +293,12 @@ void NodeEditor::TryUpgradePlaceholders() {
 
   for (auto *placeholder : placeholderNodes) {
     // Check if the gate definition is now available
-    if (CustomGate::GateRegistry.count(placeholder->missingTypeName)) {
+    if (const auto &def =
+            CustomGate::GateRegistry.Find(placeholder->missingTypeName)) {
       // Create the real gate
-      auto *realGate = new CustomGate(
-          CustomGate::GateRegistry[placeholder->missingTypeName]);
-
-      // Copy position and ID
-      realGate->pos = placeholder->pos;
-      realGate->id = placeholder->id;
-      realGate->selected = placeholder->selected;
-
-      // Transfer connections
-      for (auto &conn : placeholder->connections) {
-        // Update the connection's node pointers
-        if (conn.inputNode == placeholder) {
-          conn.inputNode = realGate;
-        }
-        if (conn.outputNode == placeholder) {
-          conn.outputNode = realGate;
-        }
-
-        // Add to real gate's connection list
-        realGate->connections.push_back(conn);
-
-        // Update the other node's reference to point to real gate
-        Node *otherNode = (conn.inputNode == realGate) ? (Node *)conn.outputNode
-                                                       : (Node *)conn.inputNode;
-
-        for (auto &otherConn : otherNode->connections) {
-          if (otherConn.inputNode == placeholder) {
-            otherConn.inputNode = realGate;
-          }
-          if (otherConn.outputNode == placeholder) {
-            otherConn.outputNode = realGate;
-          }
-        }
-      }
-
-      // Replace in nodes list
-      auto it = std::find(nodes.begin(), nodes.end(), (Node *)placeholder);
-      if (it != nodes.end()) {
-        *it = realGate;
-      }
+      auto *realGate = arena->Create<CustomGate>(def);
 
+      ReplaceNode(placeholder, realGate);
       upgraded.push_back(placeholder);
     }
   }
@@ -346,7 +306,7 @@ void NodeEditor::TryUpgradePlaceholders() {
   // Remove upgraded placeholders from tracking and delete them
   for (auto *p : upgraded) {
     placeholderNodes.erase(p);
-    delete p;
+    arena->Destroy(p);
   }
 
   // Update the missing types list and banner state
@@ -366,132 +326,245 @@ void NodeEditor::TryUpgradePlaceholders() {
 }
 
 void NodeEditor::SaveScene(const std::string &filename) {
-  FILE *f = fopen(filename.c_str(), "wb");
-  if (!f)
-    return;
-
-  // Build node ID map
-  std::map<Node *, int> nodePtrToId;
-  int idCounter = 0;
-
-  // Write magic number for scene files (BPS2 format)
-  const char magic[4] = {'B', 'P', 'S', '2'}; // Logicarium Scene v2
-  fwrite(magic, 1, 4, f);
+  PROFILE_ZONE("Save Scene");
+  // Always the scene, even while looking inside a gate
+  LeaveToLevel(0);
+
+  SceneFile scene;
+  StringTable strings;
+  // Titles are interned, so the pointer identifies the name and each one is
+  // hashed once rather than once per node or wire
+  std::unordered_map<const char *, uint32_t> titles;
+  auto title = [&](const char *text) {
+    auto [it, added] = titles.emplace(text, 0);
+    if (added)
+      it->second = strings.Add(text);
+    return it->second;
+  };
 
-  // Collect custom gate types used in the scene
+  std::unordered_map<Node *, uint32_t> nodeIndex;
+  nodeIndex.reserve(nodes.size());
   std::set<std::string> customTypesUsed;
+  scene.nodes.reserve(nodes.size());
   for (auto *node : nodes) {
-    std::string type = node->title;
-    // For PlaceholderGate, use the original missing type name
-    if (auto *placeholder = dynamic_cast<PlaceholderGate *>(node)) {
-      type = placeholder->missingTypeName;
-    }
-    if (!IsBuiltInType(type)) {
-      customTypesUsed.insert(type);
-    }
-  }
-
-  // Write custom gate dependency section
-  size_t customTypeCount = customTypesUsed.size();
-  fwrite(&customTypeCount, sizeof(size_t), 1, f);
-  for (const auto &typeName : customTypesUsed) {
-    size_t len = typeName.size();
-    fwrite(&len, sizeof(size_t), 1, f);
-    fwrite(typeName.c_str(), 1, len, f);
-  }
-
-  // Write node count
-  size_t nodeCount = nodes.size();
-  fwrite(&nodeCount, sizeof(size_t), 1, f);
-
-  // Write nodes
-  for (auto *node : nodes) {
-    nodePtrToId[node] = idCounter++;
-
+    nodeIndex[node] = (uint32_t)scene.nodes.size();
+    SceneFile::Node record;
     // Node type (use original type name for placeholders)
-    std::string type = node->title;
     if (auto *placeholder = dynamic_cast<PlaceholderGate *>(node)) {
-      type = placeholder->missingTypeName;
+      customTypesUsed.insert(placeholder->missingTypeName);
+      record.type = strings.Add(placeholder->missingTypeName);
+    } else {
+      if (!IsBuiltInType(node->title))
+        customTypesUsed.insert(node->title);
+      record.type = title(node->title);
     }
-    size_t typeLen = type.size();
-    fwrite(&typeLen, sizeof(size_t), 1, f);
-    fwrite(type.c_str(), 1, typeLen, f);
-
-    // Node position
-    fwrite(&node->pos, sizeof(ImVec2), 1, f);
-
-    // Slot counts (new in BPS2 - needed for placeholder reconstruction)
-    int inputCount = node->inputSlotCount;
-    int outputCount = node->outputSlotCount;
-    fwrite(&inputCount, sizeof(int), 1, f);
-    fwrite(&outputCount, sizeof(int), 1, f);
+    record.id = strings.Add(node->id);
+    record.x = node->pos.x;
+    record.y = node->pos.y;
+    // Slot counts are needed for placeholder reconstruction
+    record.inputs = node->inputSlotCount;
+    record.outputs = node->outputSlotCount;
+    if (node->type == Sym::In && ((PinIn *)node)->isMomentary)
+      record.flags |= SceneFile::Momentary;
+    scene.nodes.push_back(record);
   }
-
-  // Collect unique connections (only from output side to avoid duplicates)
-  std::vector<ConnectionDefinition> connections;
+  for (const auto &typeName : customTypesUsed)
+    scene.dependencies.push_back(strings.Add(typeName));
+
+  // The script's imports, relative to the scene file so it still finds them
+  // when loaded from another directory
+  ScriptAst definitions;
+  ParseScript(scriptDefinitions, definitions);
+  std::filesystem::path sceneDirectory =
+      std::filesystem::path(filename).parent_path();
+  for (const ScriptImport &import : definitions.imports)
+    scene.imports.push_back(strings.Add(
+        RebaseImport(import.path, currentPath, sceneDirectory)));
+
+  // Each wire lives once, in its source's fanout
   for (auto *node : nodes) {
-    for (const auto &conn : node->connections) {
-      if (conn.outputNode == node) {
-        ConnectionDefinition cd;
-        cd.inputNodeId = nodePtrToId[(Node *)conn.inputNode];
-        cd.inputSlot = conn.inputSlot;
-        cd.outputNodeId = nodePtrToId[(Node *)conn.outputNode];
-        cd.outputSlot = conn.outputSlot;
-        connections.push_back(cd);
-      }
+    for (const auto &conn : node->fanout) {
+      SceneFile::Wire wire;
+      wire.outputNode = nodeIndex[node];
+      wire.outputSlot = title(node->outputSlots[conn.outputSlot].title);
+      wire.inputNode = nodeIndex[conn.inputNode];
+      wire.inputSlot =
+          title(conn.inputNode->inputSlots[conn.inputSlot].title);
+      scene.wires.push_back(wire);
     }
   }
 
-  // Write connection count
-  size_t connCount = connections.size();
-  fwrite(&connCount, sizeof(size_t), 1, f);
-
-  // Write connections
-  for (const auto &conn : connections) {
-    fwrite(&conn.inputNodeId, sizeof(int), 1, f);
-
-    size_t inSlotLen = conn.inputSlot.size();
-    fwrite(&inSlotLen, sizeof(size_t), 1, f);
-    fwrite(conn.inputSlot.c_str(), 1, inSlotLen, f);
-
-    fwrite(&conn.outputNodeId, sizeof(int), 1, f);
+  scene.strings.reserve(strings.Strings().size());
+  for (const std::string *text : strings.Strings())
+    scene.strings.push_back(*text);
+  if (!WriteSceneFile(filename, scene))
+    debugMsg = "Could not save scene";
+}
 
-    size_t outSlotLen = conn.outputSlot.size();
-    fwrite(&outSlotLen, sizeof(size_t), 1, f);
-    fwrite(conn.outputSlot.c_str(), 1, outSlotLen, f);
+Node *NodeEditor::CreateSceneNode(std::string_view type, int inputCount,
+                                  int outputCount) {
+  Node *node = CreateNodeByType(*arena, type);
+  if (!node && !IsBuiltInType(type)) {
+    // Missing custom gate - create placeholder
+    node = arena->Create<PlaceholderGate>(std::string(type), inputCount,
+                                          outputCount);
+    placeholderNodes.insert(static_cast<PlaceholderGate *>(node));
   }
+  return node;
+}
 
-  fclose(f);
+void NodeEditor::NoteSceneDependency(std::string_view typeName) {
+  // Check if this custom type is available
+  if (!CustomGate::GateRegistry.Find(typeName)) {
+    // Type is missing - add to missing list if not already there
+    if (std::find(missingGateTypes.begin(), missingGateTypes.end(),
+                  typeName) == missingGateTypes.end()) {
+      missingGateTypes.emplace_back(typeName);
+    }
+  }
 }
 
 void NodeEditor::LoadScene(const std::string &filename) {
+  PROFILE_ZONE("Load Scene");
   FILE *f = fopen(filename.c_str(), "rb");
   if (!f)
     return;
 
   // Verify magic number
-  char magic[4];
+  char magic[4] = {};
   fread(magic, 1, 4, f);
 
   bool isV1 = (magic[0] == 'B' && magic[1] == 'P' && magic[2] == 'S' &&
                magic[3] == '1');
   bool isV2 = (magic[0] == 'B' && magic[1] == 'P' && magic[2] == 'S' &&
                magic[3] == '2');
+  bool isV3 = IsSceneFile(std::string_view(magic, 4));
 
-  if (!isV1 && !isV2) {
+  if (!isV1 && !isV2 && !isV3) {
     fclose(f);
     return; // Invalid file format
   }
 
-  // Clear existing nodes and state
-  for (auto *node : nodes) {
-    delete node;
+  // BPS3 is read and checked whole before anything is cleared, so a damaged
+  // file leaves the current scene as it was
+  SceneFile scene;
+  if (isV3) {
+    fclose(f);
+    std::string bytes;
+    if (!ReadFileBytes(filename, bytes) ||
+        !ParseSceneFile(std::move(bytes), scene)) {
+      debugMsg = "Scene file is damaged";
+      return;
+    }
   }
+
+  // Clear existing nodes and state
+  LeaveToLevel(0);
+  arena->Clear();
   nodes.clear();
   missingGateTypes.clear();
   placeholderNodes.clear();
   showMissingGatesBanner = false;
 
+  if (isV3) {
+    LoadSceneImports(scene, std::filesystem::path(filename).parent_path());
+    LoadSceneFile(scene);
+  } else {
+    LoadLegacyScene(f, isV2);
+    fclose(f);
+  }
+
+  if (!missingGateTypes.empty()) {
+    showMissingGatesBanner = true;
+    debugMsg =
+        "Missing gates detected: " + std::to_string(missingGateTypes.size());
+  }
+
+  // Update script from loaded nodes
+  UpdateScriptFromNodes();
+  lastParsedScript = currentScript;
+}
+
+void NodeEditor::LoadSceneImports(const SceneFile &scene,
+                                  const std::filesystem::path &directory) {
+  // The script's define blocks stay; everything before them is imports
+  std::string_view blocks = scriptDefinitions;
+  ScriptAst old;
+  ParseScript(scriptDefinitions, old);
+  if (!old.imports.empty()) {
+    const SourceSpan &last = old.imports.back().span;
+    blocks.remove_prefix(last.offset + last.length);
+    blocks.remove_prefix(std::min(blocks.find_first_not_of('\n'),
+                                  blocks.size()));
+  }
+
+  std::string text;
+  for (uint32_t path : scene.imports)
+    text += "import \"" +
+            RebaseImport(scene.strings[path], directory, currentPath) + "\"\n";
+  size_t importsEnd = text.size();
+  if (!scene.imports.empty()) {
+    // A template instance is only built for a compile that places one
+    int placed = 0;
+    for (uint32_t type : scene.dependencies)
+      if (scene.strings[type].find('<') != std::string_view::npos)
+        text.append(scene.strings[type])
+            .append(" t" + std::to_string(placed++) + " @ 0, 0\n");
+    CompiledScript compiled;
+    CompileScript(text, CustomGate::GateRegistry, compiled,
+                  &scriptCompiler.Cache(), currentPath);
+    RegisterScriptDefinitions(compiled);
+    // The script starts with the same lines, so errors in them carry over
+    scriptErrors.clear();
+    for (const ScriptError &error : compiled.errors)
+      if (error.span.offset < importsEnd)
+        scriptErrors.push_back(error);
+    scriptLines = compiled.lines;
+    text.resize(importsEnd);
+    text += "\n";
+  }
+  scriptDefinitions = text.append(blocks);
+}
+
+void NodeEditor::LoadSceneFile(const SceneFile &scene) {
+  for (uint32_t type : scene.dependencies)
+    NoteSceneDependency(scene.strings[type]);
+
+  std::vector<Node *> created(scene.nodes.size(), nullptr);
+  nodes.reserve(scene.nodes.size());
+  for (size_t i = 0; i < scene.nodes.size(); i++) {
+    const SceneFile::Node &record = scene.nodes[i];
+    Node *node = CreateSceneNode(scene.strings[record.type], record.inputs,
+                                 record.outputs);
+    if (!node)
+      continue;
+    node->pos = ImVec2(record.x, record.y);
+    node->id = scene.strings[record.id];
+    if (node->type == Sym::In)
+      ((PinIn *)node)->isMomentary = record.flags & SceneFile::Momentary;
+    nodes.push_back(node);
+    created[i] = node;
+  }
+
+  // Slot names are looked up once each, not once per wire
+  const Symbol unresolved = ~(Symbol)0;
+  std::vector<Symbol> slotSymbols(scene.strings.size(), unresolved);
+  auto slotSymbol = [&](uint32_t name) {
+    if (slotSymbols[name] == unresolved)
+      slotSymbols[name] = SymbolTable::Find(scene.strings[name]);
+    return slotSymbols[name];
+  };
+  for (const SceneFile::Wire &wire : scene.wires) {
+    Node *outNode = created[wire.outputNode];
+    Node *inNode = created[wire.inputNode];
+    if (outNode && inNode)
+      Wires::Connect(outNode,
+                     outNode->FindOutputSlot(slotSymbol(wire.outputSlot)),
+                     inNode, inNode->FindInputSlot(slotSymbol(wire.inputSlot)));
+  }
+}
+
+void NodeEditor::LoadLegacyScene(FILE *f, bool isV2) {
   // Read custom gate dependency section (BPS2 only)
   if (isV2) {
     size_t customTypeCount = 0;
@@ -504,20 +577,7 @@ void NodeEditor::LoadScene(const std::string &filename) {
       typeName.resize(len);
       fread(&typeName[0], 1, len, f);
 
-      // Check if this custom type is available
-      if (!CustomGate::GateRegistry.count(typeName)) {
-        // Type is missing - add to missing list if not already there
-        if (std::find(missingGateTypes.begin(), missingGateTypes.end(),
-                      typeName) == missingGateTypes.end()) {
-          missingGateTypes.push_back(typeName);
-        }
-      }
-    }
-
-    if (!missingGateTypes.empty()) {
-      showMissingGatesBanner = true;
-      debugMsg =
-          "Missing gates detected: " + std::to_string(missingGateTypes.size());
+      NoteSceneDependency(typeName);
     }
   }
 
@@ -550,12 +610,7 @@ void NodeEditor::LoadScene(const std::string &filename) {
     }
 
     // Create node (use placeholder for missing custom gates)
-    Node *node = CreateNodeByType(type);
-    if (!node && !IsBuiltInType(type)) {
-      // Missing custom gate - create placeholder
-      node = new PlaceholderGate(type, inputCount, outputCount);
-      placeholderNodes.insert(static_cast<PlaceholderGate *>(node));
-    }
+    Node *node = CreateSceneNode(type, inputCount, outputCount);
 
     if (node) {
       node->pos = pos;
@@ -591,22 +646,12 @@ void NodeEditor::LoadScene(const std::string &filename) {
 
     // Create connection if both nodes exist
     if (idToNode.count(inputNodeId) && idToNode.count(outputNodeId)) {
-      Connection conn;
-      conn.inputNode = idToNode[inputNodeId];
-      conn.inputSlot = inputSlot;
-      conn.outputNode = idToNode[outputNodeId];
-      conn.outputSlot = outputSlot;
-
-      ((Node *)conn.inputNode)->connections.push_back(conn);
-      ((Node *)conn.outputNode)->connections.push_back(conn);
+      Node *inNode = idToNode[inputNodeId];
+      Node *outNode = idToNode[outputNodeId];
+      Wires::Connect(outNode, outNode->FindOutputSlot(outputSlot.c_str()),
+                     inNode, inNode->FindInputSlot(inputSlot.c_str()));
     }
   }
-
-  fclose(f);
-
-  // Update script from loaded nodes
-  UpdateScriptFromNodes();
-  lastParsedScript = currentScript;
 }
 
 } // namespace Logicarium
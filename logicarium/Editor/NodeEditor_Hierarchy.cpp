@@ -0,0 +1,265 @@
+#include "../Nodes/Gates/CustomGate.hpp"
+#include "../Nodes/Gates/PlaceholderGate.hpp"
+#include "NodeEditor.hpp"
+#include <ImNodes.h>
+#include <ImNodesEz.h>
+#include <algorithm>
+#include <cstdint>
+#include <imgui.h>
+#include <map>
+
+namespace Logicarium {
+extern bool wiringLocked;
+
+// Custom gates nest through their definitions; this only guards against a
+// definition that (indirectly) contains itself
+static constexpr int MaxDefinitionDepth = 32;
+
+static bool DefinitionUses(const GateDefinition &def, const std::string &type,
+                           int depth = 0) {
+  if (def.name == type)
+    return true;
+  if (depth >= MaxDefinitionDepth)
+    return false;
+  for (const auto &nodeDef : def.nodes)
+    if (const auto &inner = CustomGate::GateRegistry.Find(nodeDef.type))
+      if (DefinitionUses(*inner, type, depth + 1))
+        return true;
+  return false;
+}
+
+void NodeEditor::PushLevel(HierarchyLevel level, NodeArena *levelArena,
+                           std::vector<Node *> levelNodes) {
+  DeselectAllNodes();
+  ImNodes::CanvasState &canvas = ImNodes::Ez::GetState();
+  level.parentArena = arena;
+  level.parentNodes = std::move(nodes);
+  level.parentOffset = canvas.Offset;
+  level.parentZoom = canvas.Zoom;
+  level.parentScript = currentScript;
+  level.parentParsedScript = lastParsedScript;
+  // A compile still pending for the parent would be dropped once it lands in
+  // this level; the edit is submitted again on the way out
+  scriptCompiler.Cancel();
+  level.parentPlaceholders = std::move(placeholderNodes);
+  placeholderNodes.clear();
+  hierarchy.push_back(std::move(level));
+
+  arena = levelArena;
+  nodes = std::move(levelNodes);
+  DeselectAllNodes();
+
+  // Handles and revisions are per arena, so nothing cached for the parent
+  // carries over
+  indexedArenaRevision = ~0ull;
+  interactiveWires.clear();
+  lastInteractiveWires.clear();
+  showCodeEditor = false;
+  gateBeingEdited = NullNodeHandle;
+  showConnectionDropMenu = false;
+  wiringLocked = StructureLocked();
+  frameAllPending = true;
+}
+
+void NodeEditor::EnterGate(CustomGate *gate) {
+  HierarchyLevel level;
+  level.label = gate->title;
+  if (!gate->id.empty())
+    level.label += " " + gate->id;
+  level.gate = gate;
+  PushLevel(std::move(level), &gate->internalArena, gate->internalNodes);
+  UpdateScriptFromNodes();
+}
+
+void NodeEditor::EditDefinition(const GateDefinitionRef &def) {
+  HierarchyLevel level;
+  level.label = def->name + " (definition)";
+  level.definitionName = def->name;
+  level.ownedArena = std::make_unique<NodeArena>();
+  NodeArena *scratch = level.ownedArena.get();
+
+  // Rebuild the definition's graph as editable nodes
+  std::vector<Node *> graph;
+  std::map<int, Node *> idToNode;
+  for (const auto &nodeDef : def->nodes) {
+    Node *n = CreateNodeByType(*scratch, nodeDef.type);
+    if (n) {
+      n->pos = nodeDef.pos;
+      n->id = "n" + std::to_string(nodeDef.id);
+      graph.push_back(n);
+      idToNode[nodeDef.id] = n;
+    }
+  }
+  for (const auto &connDef : def->connections) {
+    if (idToNode.count(connDef.inputNodeId) &&
+        idToNode.count(connDef.outputNodeId)) {
+      Node *inNode = idToNode[connDef.inputNodeId];
+      Node *outNode = idToNode[connDef.outputNodeId];
+      Wires::Connect(outNode,
+                     outNode->FindOutputSlot(connDef.outputSlot.c_str()),
+                     inNode, inNode->FindInputSlot(connDef.inputSlot.c_str()));
+    }
+  }
+
+  PushLevel(std::move(level), scratch, std::move(graph));
+  UpdateScriptFromNodes();
+  lastParsedScript = currentScript;
+}
+
+void NodeEditor::LeaveToLevel(size_t depth) {
+  if (depth >= hierarchy.size())
+    return;
+
+  DeselectAllNodes();
+  while (hierarchy.size() > depth) {
+    HierarchyLevel &level = hierarchy.back();
+    ImNodes::CanvasState &canvas = ImNodes::Ez::GetState();
+    arena = level.parentArena;
+    nodes = std::move(level.parentNodes);
+    canvas.Offset = level.parentOffset;
+    canvas.Zoom = level.parentZoom;
+    currentScript = level.parentScript;
+    lastParsedScript = level.parentParsedScript;
+    // Placeholders made inside the level die with its scratch arena
+    placeholderNodes = std::move(level.parentPlaceholders);
+    hierarchy.pop_back();
+  }
+
+  indexedArenaRevision = ~0ull;
+  interactiveWires.clear();
+  lastInteractiveWires.clear();
+  showCodeEditor = false;
+  gateBeingEdited = NullNodeHandle;
+  showConnectionDropMenu = false;
+  wiringLocked = StructureLocked();
+
+  // An edit made just before entering the level never reached the graph
+  if (currentScript != lastParsedScript)
+    QueueScriptCompile();
+}
+
+void NodeEditor::ReplaceNode(Node *node, Node *replacement) {
+  replacement->pos = node->pos;
+  replacement->id = node->id;
+  replacement->selected = node->selected;
+
+  // Transfer connections pin-by-pin (slots are matched by position;
+  // Connect() drops pins the replacement doesn't have)
+  for (int i = 0; i < (int)node->drivers.size(); ++i) {
+    Driver driver = node->drivers[i];
+    if (driver.node)
+      Wires::Connect(driver.node, driver.slot, replacement, i);
+  }
+  std::vector<Connection> outgoing = node->fanout;
+  for (const auto &conn : outgoing)
+    Wires::Connect(replacement, conn.outputSlot, conn.inputNode,
+                   conn.inputSlot);
+  Wires::DisconnectAll(node);
+
+  auto it = std::find(nodes.begin(), nodes.end(), node);
+  if (it != nodes.end())
+    *it = replacement;
+  // Stacks where the node it replaces did
+  auto order = drawOrder.find(node->handle);
+  if (order != drawOrder.end())
+    drawOrder[replacement->handle] = order->second;
+}
+
+void NodeEditor::RefreshInstances(const std::string &type) {
+  std::vector<Node *> stale;
+  for (Node *node : nodes) {
+    if (!CustomGate::GateRegistry.Find(node->type))
+      continue;
+    const auto &def = ((CustomGate *)node)->Definition();
+    if (DefinitionUses(*def, type))
+      stale.push_back(node);
+  }
+
+  for (Node *node : stale) {
+    if (Node *fresh = CreateNodeByType(*arena, node->type)) {
+      ReplaceNode(node, fresh);
+      arena->Destroy(node);
+    }
+  }
+}
+
+void NodeEditor::RenderHierarchyBanner() {
+  if (hierarchy.empty())
+    return;
+
+  const HierarchyLevel &current = hierarchy.back();
+  bool editing = current.gate == nullptr;
+  // A definition being edited somewhere up the stack has to be saved or
+  // discarded before anything pops past it
+  bool editPending = std::any_of(
+      hierarchy.begin(), hierarchy.end(),
+      [](const HierarchyLevel &level) { return level.gate == nullptr; });
+
+  // Deferred until the banner is done drawing, since they pop levels
+  size_t leaveTo = SIZE_MAX;
+  bool save = false;
+  GateDefinitionRef editDef;
+
+  ImGui::PushStyleColor(ImGuiCol_ChildBg, editing
+                                              ? IM_COL32(180, 100, 20, 200)
+                                              : IM_COL32(20, 110, 140, 200));
+  ImGui::BeginChild("HierarchyBanner", ImVec2(0, 40), true,
+                    ImGuiWindowFlags_NoScrollbar |
+                        ImGuiWindowFlags_NoScrollWithMouse);
+
+  // Breadcrumbs; ancestors are clickable
+  ImGui::AlignTextToFramePadding();
+  ImGui::BeginDisabled(editPending);
+  if (ImGui::SmallButton("Scene"))
+    leaveTo = 0;
+  for (size_t i = 0; i < hierarchy.size(); ++i) {
+    ImGui::SameLine(0, 4);
+    ImGui::TextUnformatted(">");
+    ImGui::SameLine(0, 4);
+    ImGui::PushID((int)i);
+    if (i + 1 == hierarchy.size()) {
+      ImGui::TextUnformatted(hierarchy[i].label.c_str());
+    } else if (ImGui::SmallButton(hierarchy[i].label.c_str())) {
+      leaveTo = i + 1;
+    }
+    ImGui::PopID();
+  }
+  ImGui::EndDisabled();
+
+  if (editing) {
+    ImGui::SameLine(ImGui::GetContentRegionAvail().x - 200);
+    if (ImGui::Button("Save and Close", ImVec2(120, 0)))
+      save = true;
+    ImGui::SameLine();
+    if (ImGui::Button("Discard", ImVec2(80, 0)))
+      leaveTo = hierarchy.size() - 1;
+  } else {
+    const GateDefinitionRef &def = current.gate->Definition();
+    bool canEdit = !def->isTemporary && !editPending;
+    ImGui::SameLine(ImGui::GetContentRegionAvail().x - (canEdit ? 200 : 80));
+    if (canEdit) {
+      if (ImGui::Button("Edit Definition", ImVec2(120, 0)))
+        editDef = def;
+      ImGui::SameLine();
+    }
+    if (ImGui::Button("Back", ImVec2(80, 0)))
+      leaveTo = hierarchy.size() - 1;
+  }
+
+  ImGui::EndChild();
+  ImGui::PopStyleColor();
+
+  if (save) {
+    std::string name = current.definitionName;
+    UpdateGateDefinitionFromCurrentScene(name);
+    LeaveToLevel(0);
+    // Only instances built from the old definition need rebuilding
+    RefreshInstances(name);
+  } else if (editDef) {
+    LeaveToLevel(0);
+    EditDefinition(editDef);
+  } else if (leaveTo != SIZE_MAX) {
+    LeaveToLevel(leaveTo);
+  }
+}
+} // namespace Logicarium
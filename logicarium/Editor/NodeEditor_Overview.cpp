@@ -0,0 +1,315 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "NodeEditor.hpp"
+#include "Profiler.hpp"
+#include "Repaint.hpp"
+#include <ImNodes.h>
+#include <algorithm>
+#include <cmath>
+#include <imgui.h>
+#include <imgui_internal.h>
+
+namespace Logicarium {
+extern bool nodeHoveredForContextMenu;
+
+// Below this zoom node text is too small to read
+static constexpr float FullDetailZoom = 0.5f;
+// Below this zoom individual boxes are a few pixels wide
+static constexpr float BoxDetailZoom = 0.15f;
+// Zoom levels the overview jumps to when a tile or box is clicked
+static constexpr float TileClickZoom = 0.3f;
+static constexpr float BoxClickZoom = 1.0f;
+
+// Edge length of a density tile, in canvas units
+static constexpr float DensityTileSize = 512.0f;
+
+NodeEditor::NodeDetail NodeEditor::DetailForZoom(float zoom) {
+  if (zoom >= FullDetailZoom)
+    return NodeDetail::Full;
+  if (zoom >= BoxDetailZoom)
+    return NodeDetail::Boxes;
+  return NodeDetail::Tiles;
+}
+
+void NodeEditor::CenterViewOn(ImVec2 point, float zoom) {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  canvas->Zoom = zoom;
+  canvas->Offset = ImGui::GetWindowSize() * 0.5f - point * zoom;
+}
+
+// Mid zoom: every node is a flat rectangle straight on the draw list, with
+// an invisible button behind it so nodes can still be selected and dragged.
+void NodeEditor::RenderNodeBoxes() {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  ImDrawList *drawList = ImGui::GetWindowDrawList();
+  const ImGuiIO &io = ImGui::GetIO();
+  ImVec2 origin = ImGui::GetWindowPos() + canvas->Offset;
+  float rounding = 8.0f * canvas->Zoom;
+
+  bool dragging = false;
+  bool zoomIn = false;
+  ImVec2 zoomTarget;
+
+  QueryNodes(viewRect, visibleNodes);
+  for (Node *node : visibleNodes) {
+    ImRect bounds = NodeBounds(node);
+    ImVec2 min = origin + bounds.Min * canvas->Zoom;
+    ImVec2 max = origin + bounds.Max * canvas->Zoom;
+
+    ImGui::PushID(node);
+    ImGui::SetCursorScreenPos(min);
+    ImGui::InvisibleButton("box", ImMax(max - min, ImVec2(1, 1)));
+    bool hovered = ImGui::IsItemHovered();
+    if (ImGui::IsItemClicked(0)) {
+      if (io.KeyCtrl) {
+        node->selected = !node->selected;
+      } else if (!node->selected) {
+        DeselectAllNodes();
+        node->selected = true;
+      }
+    }
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(0))
+      dragging = true;
+    if (hovered) {
+      nodeHoveredForContextMenu = true;
+      ImGui::SetTooltip("%s", node->id.empty() ? node->title : node->id.c_str());
+      if (ImGui::IsMouseDoubleClicked(0)) {
+        zoomIn = true;
+        zoomTarget = bounds.GetCenter();
+      }
+    }
+    ImGui::PopID();
+
+    ImU32 fill = (node->GetColor() & 0x00FFFFFF) | 0xFF000000;
+    ImU32 border = node->Evaluate() ? IM_COL32(50, 255, 150, 255)
+                                    : IM_COL32(100, 200, 255, 150);
+    if (node->selected)
+      border = IM_COL32(0, 200, 255, 255);
+    else if (hovered)
+      border = IM_COL32(255, 255, 255, 200);
+
+    drawList->AddRectFilled(min, max, fill, rounding);
+    drawList->AddRect(min, max, border, rounding);
+  }
+
+  if (dragging) {
+    anyNodeDragged = true;
+    ImVec2 delta = io.MouseDelta / canvas->Zoom;
+    for (Node *node : nodes)
+      if (node->selected) {
+        node->pos += delta;
+        UpdateNodeBounds(node);
+      }
+  } else if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(0) &&
+             !ImGui::IsAnyItemHovered() && !io.KeyCtrl && !io.KeyShift) {
+    DeselectAllNodes();
+  }
+
+  if (zoomIn)
+    CenterViewOn(zoomTarget, BoxClickZoom);
+}
+
+// Tile coordinates are packed as two 16-bit halves, which covers +-16M canvas
+// units at the current tile size.
+static uint32_t DensityTileKey(ImVec2 pos) {
+  int x = (int)floorf(pos.x / DensityTileSize);
+  int y = (int)floorf(pos.y / DensityTileSize);
+  x = ImClamp(x, -32768, 32767);
+  y = ImClamp(y, -32768, 32767);
+  return ((uint32_t)(uint16_t)x << 16) | (uint16_t)y;
+}
+
+static ImVec2 DensityTileOrigin(uint32_t key) {
+  return ImVec2((float)(int16_t)(key >> 16), (float)(int16_t)(key & 0xFFFF)) *
+         DensityTileSize;
+}
+
+// Far zoom: nodes are binned into fixed tiles shaded by how many nodes they
+// hold and how many of those are high, and wires collapse into one bundle per
+// pair of tiles, drawn thicker the more wires it carries.
+void NodeEditor::RenderDensityTiles() {
+  auto *canvas = ImNodes::GetCurrentCanvas();
+  ImDrawList *drawList = ImGui::GetWindowDrawList();
+  ImVec2 origin = ImGui::GetWindowPos() + canvas->Offset;
+  ImVec2 half(DensityTileSize * 0.5f, DensityTileSize * 0.5f);
+
+  densityTiles.clear();
+  wireBundles.clear();
+  int densest = 1;
+  for (Node *node : nodes) {
+    uint32_t key = DensityTileKey(node->pos);
+    DensityTile &tile = densityTiles[key];
+    tile.nodes++;
+    if (node->Evaluate())
+      tile.high++;
+    tile.selected |= node->selected;
+    densest = ImMax(densest, tile.nodes);
+
+    for (const auto &connection : node->fanout) {
+      uint32_t target = DensityTileKey(connection.inputNode->pos);
+      if (target != key)
+        wireBundles[((uint64_t)key << 32) | target]++;
+    }
+  }
+
+  bool hoverable = ImGui::IsWindowHovered();
+  ImVec2 mouse = ImGui::GetMousePos();
+  float gap = ImMin(2.0f, DensityTileSize * canvas->Zoom * 0.05f);
+  float densestLog = log2f(1.0f + densest);
+
+  for (const auto &[key, tile] : densityTiles) {
+    ImVec2 corner = DensityTileOrigin(key);
+    ImRect bounds(corner, corner + half * 2.0f);
+    if (!bounds.Overlaps(viewRect))
+      continue;
+
+    ImVec2 min = origin + bounds.Min * canvas->Zoom + ImVec2(gap, gap);
+    ImVec2 max = origin + bounds.Max * canvas->Zoom - ImVec2(gap, gap);
+
+    float density = log2f(1.0f + tile.nodes) / densestLog;
+    float activity = (float)tile.high / (float)tile.nodes;
+    ImVec4 idle(0.31f, 0.35f, 0.39f, 1.0f);
+    ImVec4 live(0.2f, 1.0f, 0.59f, 1.0f);
+    ImVec4 color = ImLerp(idle, live, activity);
+    color.w = 0.2f + 0.7f * density;
+    drawList->AddRectFilled(min, max, ImGui::ColorConvertFloat4ToU32(color),
+                            4.0f);
+    if (tile.selected)
+      drawList->AddRect(min, max, IM_COL32(0, 200, 255, 255), 4.0f);
+
+    if (hoverable && ImRect(min, max).Contains(mouse)) {
+      drawList->AddRect(min, max, IM_COL32(255, 255, 255, 200), 4.0f);
+      ImGui::SetTooltip("%d nodes, %d high", tile.nodes, tile.high);
+      if (ImGui::IsMouseClicked(0))
+        CenterViewOn(bounds.GetCenter(), TileClickZoom);
+    }
+  }
+
+  for (const auto &[pair, count] : wireBundles) {
+    ImVec2 from = DensityTileOrigin((uint32_t)(pair >> 32)) + half;
+    ImVec2 to = DensityTileOrigin((uint32_t)pair) + half;
+    ImRect bounds(ImMin(from, to), ImMax(from, to));
+    if (!bounds.Overlaps(viewRect))
+      continue;
+    drawList->AddLine(origin + from * canvas->Zoom, origin + to * canvas->Zoom,
+                      IM_COL32(80, 90, 100, 160), 1.0f + log2f((float)count));
+  }
+}
+
+// Minimap size and distance from the canvas' bottom-right corner, in pixels
+static constexpr float MinimapSize = 200.0f;
+static constexpr float MinimapMargin = 16.0f;
+// Nodes checked for state changes per frame. Larger scenes are swept over
+// several frames.
+static constexpr size_t MinimapSweepBudget = 16384;
+
+// Uses the value from the node's last evaluation rather than evaluating it
+// again; the simulation pass has already pulled everything that feeds an
+// output this frame
+static uint8_t MinimapState(const Node *node) {
+  return (uint8_t)((node->value ? 1 : 0) | (node->selected ? 2 : 0));
+}
+
+static ImU32 MinimapColor(uint8_t state) {
+  if (state & 2)
+    return IM_COL32(0, 200, 255, 255);
+  return state & 1 ? IM_COL32(50, 255, 150, 255) : IM_COL32(90, 100, 115, 255);
+}
+
+ImVec2 NodeEditor::MinimapPos() const {
+  return canvasRect.Max -
+         ImVec2(MinimapSize + MinimapMargin, MinimapSize + MinimapMargin);
+}
+
+void NodeEditor::HandleMinimapInput() {
+  if (!showMinimap)
+    return;
+  ImVec2 pos = MinimapPos();
+  ImVec2 cursor = ImGui::GetCursorScreenPos();
+  ImGui::SetCursorScreenPos(pos);
+  ImGui::InvisibleButton("##minimap", ImVec2(MinimapSize, MinimapSize));
+  if (ImGui::IsItemActive()) {
+    ImVec2 local = ImClamp(ImGui::GetMousePos() - pos, ImVec2(0, 0),
+                           ImVec2(MinimapSize, MinimapSize));
+    CenterViewOn(minimap.ToCanvas(local, MinimapSize),
+                 ImNodes::GetCurrentCanvas()->Zoom);
+  }
+  ImGui::SetCursorScreenPos(cursor);
+}
+
+void NodeEditor::SweepMinimap() {
+  if (nodes.empty())
+    return;
+  if (minimapSweepLeft == 0) {
+    minimapSweepLeft = nodes.size();
+    minimapSweepChanged = false;
+  }
+
+  size_t count = std::min(minimapSweepLeft, MinimapSweepBudget);
+  for (size_t k = 0; k < count; ++k) {
+    size_t i = minimapSweep++ % nodes.size();
+    uint8_t state = MinimapState(nodes[i]);
+    if (state != minimapDrawn[i]) {
+      minimapDrawn[i] = state;
+      minimap.MarkDirty(NodeBounds(nodes[i]));
+      minimapSweepChanged = true;
+    }
+  }
+  minimapSweepLeft -= count;
+
+  // A node already passed may have changed since, so a pass that found
+  // changes is followed by another. Frames keep coming until a pass is clean.
+  if (minimapSweepLeft == 0 && minimapSweepChanged) {
+    minimapSweepLeft = nodes.size();
+    minimapSweepChanged = false;
+  }
+  if (minimapSweepLeft > 0)
+    Repaint::Within(0.0);
+}
+
+void NodeEditor::RenderMinimap() {
+  if (!showMinimap) {
+    minimapStale = true;
+    return;
+  }
+  PROFILE_ZONE("Minimap");
+
+  if (minimapStale || minimapDrawn.size() != nodes.size()) {
+    // Fit the scene with room to grow before the next rebuild
+    ImRect area = viewRect;
+    if (!nodes.empty()) {
+      area = NodeBounds(nodes[0]);
+      for (Node *node : nodes)
+        area.Add(NodeBounds(node));
+    }
+    area.Expand(ImMax(area.GetWidth(), area.GetHeight()) * 0.25f);
+    minimap.Reset(area);
+
+    minimapDrawn.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+      minimapDrawn[i] = MinimapState(nodes[i]);
+    minimapSweepLeft = 0;
+    minimapStale = false;
+  } else {
+    SweepMinimap();
+  }
+
+  if (minimap.Dirty()) {
+    minimap.Redraw([&](const ImRect &area) {
+      nodeIndex.Query(area, [&](uint64_t id, const ImRect &rect) {
+        if (Node *node = arena->Get((NodeHandle)id))
+          minimap.Fill(rect, MinimapColor(MinimapState(node)));
+      });
+    });
+  }
+
+  // On the canvas window's own draw list, above the nodes drawn so far but
+  // under popups, menus and other windows
+  ImDrawList *drawList = ImGui::GetWindowDrawList();
+  drawList->PushClipRect(canvasRect.Min, canvasRect.Max, true);
+  minimap.Draw(drawList, MinimapPos(), MinimapSize, viewRect);
+  drawList->PopClipRect();
+}
+} // namespace Logicarium
@@ -1,566 +1,99 @@
 #include "../Nodes/Gates/CustomGate.hpp"
+#include "../Nodes/Gates/PlaceholderGate.hpp"
+#include "../Nodes/Gates/WordGate.hpp"
 #include "../Nodes/Special/PinIn.hpp"
 #include "NodeEditor.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Logicarium {
 
-// Helper to trim whitespace
-static void trimStr(std::string &s) {
-  if (s.empty())
-    return;
-  s.erase(0, s.find_first_not_of(" \t\n\r"));
-  size_t last = s.find_last_not_of(" \t\n\r");
-  if (last != std::string::npos)
-    s.erase(last + 1);
-}
-
-// Helper to split string by delimiter
-static std::vector<std::string> splitStr(const std::string &s, char delim) {
-  std::vector<std::string> result;
-  std::stringstream ss(s);
-  std::string item;
-  while (std::getline(ss, item, delim)) {
-    trimStr(item);
-    if (!item.empty())
-      result.push_back(item);
-  }
-  return result;
-}
-
-// Parse and register a custom gate definition from script
-// Syntax: define Name(in1, in2) -> (out1, out2):
-//           out1 = in1 OP in2
-//         end
-static bool ParseGateDefinition(const std::string &defBlock,
-                                std::string &errorOut) {
-  std::stringstream ss(defBlock);
-  std::string line;
-  std::string gateName;
-  std::vector<std::string> inputs;
-  std::vector<std::string> outputs;
-  std::vector<std::pair<std::string, std::string>> assignments; // output = expr
-
-  // Parse first line: define Name(in1, in2) -> (out1, out2):
-  if (!std::getline(ss, line)) {
-    errorOut = "Empty define block";
+// Compares the gate itself; whether it was saved to the library is ignored
+static bool SameDefinition(const GateDefinition &a, const GateDefinition &b) {
+  if (a.name != b.name || a.nodes.size() != b.nodes.size() ||
+      a.connections.size() != b.connections.size() ||
+      a.inputPinIndices != b.inputPinIndices ||
+      a.outputPinIndices != b.outputPinIndices ||
+      a.inputPinNames != b.inputPinNames ||
+      a.outputPinNames != b.outputPinNames || a.color != b.color)
     return false;
-  }
-  trimStr(line);
-
-  // Remove "define " prefix
-  if (line.substr(0, 7) != "define ") {
-    errorOut = "Block must start with 'define'";
-    return false;
-  }
-  line = line.substr(7);
-  trimStr(line);
-
-  // Extract gate name
-  size_t parenPos = line.find('(');
-  if (parenPos == std::string::npos) {
-    errorOut = "Missing '(' in define";
-    return false;
-  }
-  gateName = line.substr(0, parenPos);
-  trimStr(gateName);
-
-  // Extract inputs: between ( and )
-  size_t closeParenPos = line.find(')');
-  if (closeParenPos == std::string::npos || closeParenPos <= parenPos) {
-    errorOut = "Missing ')' for inputs";
-    return false;
-  }
-  std::string inputsStr =
-      line.substr(parenPos + 1, closeParenPos - parenPos - 1);
-  inputs = splitStr(inputsStr, ',');
-
-  // Find -> and outputs
-  size_t arrowPos = line.find("->");
-  if (arrowPos == std::string::npos) {
-    errorOut = "Missing '->' in define";
-    return false;
-  }
-
-  std::string afterArrow = line.substr(arrowPos + 2);
-  trimStr(afterArrow);
-
-  // Extract outputs: between ( and ):
-  size_t outOpenParen = afterArrow.find('(');
-  size_t outCloseParen = afterArrow.find(')');
-  if (outOpenParen == std::string::npos || outCloseParen == std::string::npos) {
-    errorOut = "Missing output parentheses";
-    return false;
-  }
-  std::string outputsStr =
-      afterArrow.substr(outOpenParen + 1, outCloseParen - outOpenParen - 1);
-  outputs = splitStr(outputsStr, ',');
-
-  if (gateName.empty() || inputs.empty() || outputs.empty()) {
-    errorOut = "Gate must have name, inputs, and outputs";
-    return false;
-  }
-
-  // Parse body: assignments like "out = in1 OP in2" or "out = NOT in1"
-  while (std::getline(ss, line)) {
-    trimStr(line);
-    if (line.empty() || line == "end")
-      continue;
-    if (line[0] == '/' && line.size() > 1 && line[1] == '/')
-      continue;
-
-    size_t eqPos = line.find('=');
-    if (eqPos == std::string::npos) {
-      errorOut = "Invalid assignment: " + line;
-      return false;
-    }
-    std::string lhs = line.substr(0, eqPos);
-    std::string rhs = line.substr(eqPos + 1);
-    trimStr(lhs);
-    trimStr(rhs);
-    assignments.push_back({lhs, rhs});
-  }
-
-  // Now build the GateDefinition
-  GateDefinition def;
-  def.name = gateName;
-  def.color = IM_COL32(60, 80, 120, 200); // Default blue-ish color
-  def.inputPinNames = inputs;   // Store original parameter names (a, b, etc.)
-  def.outputPinNames = outputs; // Store original output names (out, etc.)
-
-  // Signal tracking: maps signal name to (nodeId, outputSlotName)
-  // Allows accessing multi-output gates via signal.outputName
-  struct Signal {
-    int nodeId;
-    std::string slot; // output slot name
-  };
-  std::map<std::string, Signal> signals;
-  int nodeIdCounter = 0;
-  float yPos = 0;
-
-  // Create PinIn nodes for each input
-  for (const auto &inputName : inputs) {
-    NodeDefinition nd;
-    nd.type = "In";
-    nd.id = nodeIdCounter;
-    nd.pos = ImVec2(0, yPos);
-    yPos += 60;
-    def.nodes.push_back(nd);
-    def.inputPinIndices.push_back(nodeIdCounter);
-    signals[inputName] = {nodeIdCounter, "out"};
-    nodeIdCounter++;
-  }
-
-  // Create constant nodes for literals 0 and 1
-  // These are PinIn nodes that stay at a fixed value
-  int constLowId = -1; // Will be created on demand
-  int constHighId = -1;
-
-  // Helper lambdas for creating nodes and connections
-  auto createNode = [&](const std::string &type, float x, float y) -> int {
-    NodeDefinition nd;
-    nd.type = type;
-    nd.id = nodeIdCounter;
-    nd.pos = ImVec2(x, y);
-    def.nodes.push_back(nd);
-    return nodeIdCounter++;
-  };
-
-  auto connect = [&](int fromNode, const std::string &fromSlot, int toNode,
-                     const std::string &toSlot) {
-    ConnectionDefinition cd;
-    cd.outputNodeId = fromNode;
-    cd.outputSlot = fromSlot;
-    cd.inputNodeId = toNode;
-    cd.inputSlot = toSlot;
-    def.connections.push_back(cd);
-  };
-
-  // Process each assignment to create gate nodes
-  float gateX = 150;
-  float gateY = 0;
-
-  // Recursive expression parser that handles nested expressions like NOT (a AND
-  // b) Returns Signal (nodeId + output slot), or nodeId=-1 on error
-  std::function<Signal(const std::string &, std::string &)> parseExpr;
-  parseExpr = [&](const std::string &exprIn, std::string &err) -> Signal {
-    std::string expr = exprIn;
-    trimStr(expr);
-
-    // Handle literal 0 - create constant low PinIn
-    if (expr == "0") {
-      if (constLowId < 0) {
-        NodeDefinition nd;
-        nd.type = "In";
-        nd.id = nodeIdCounter;
-        nd.pos = ImVec2(-100, 0);
-        def.nodes.push_back(nd);
-        constLowId = nodeIdCounter++;
-      }
-      return {constLowId, "out"};
-    }
-
-    // Handle literal 1 - create constant high PinIn (will need special
-    // handling)
-    if (expr == "1") {
-      if (constHighId < 0) {
-        // Create a constant high: In -> NOT -> NOT (double invert stays high
-        // when In is low) Actually simpler: just create an In that we'll mark
-        // as initially on For now, use: In with value=true would require
-        // special node type Workaround: NOT(0) = 1
-        if (constLowId < 0) {
-          NodeDefinition nd;
-          nd.type = "In";
-          nd.id = nodeIdCounter;
-          nd.pos = ImVec2(-100, 0);
-          def.nodes.push_back(nd);
-          constLowId = nodeIdCounter++;
-        }
-        int notGate = createNode("NOT", -50, 0);
-        connect(constLowId, "out", notGate, "in");
-        constHighId = notGate;
-      }
-      return {constHighId, "out"};
-    }
-
-    // Check for dot notation: signal.outputName (accessing multi-output gate)
-    size_t dotPos = expr.find('.');
-    if (dotPos != std::string::npos) {
-      std::string baseName = expr.substr(0, dotPos);
-      std::string outputName = expr.substr(dotPos + 1);
-      trimStr(baseName);
-      trimStr(outputName);
-      if (signals.count(baseName)) {
-        // Return the same node but with the specified output slot
-        Signal base = signals[baseName];
-        return {base.nodeId, outputName};
-      }
-    }
-
-    // Remove outer parentheses if present: (a AND b) -> a AND b
-    while (expr.size() >= 2 && expr[0] == '(' && expr[expr.size() - 1] == ')') {
-      int depth = 0;
-      bool matched = true;
-      for (size_t i = 0; i < expr.size() - 1; ++i) {
-        if (expr[i] == '(')
-          depth++;
-        else if (expr[i] == ')')
-          depth--;
-        if (depth == 0 && i > 0) {
-          matched = false;
-          break;
-        }
-      }
-      if (matched) {
-        expr = expr.substr(1, expr.size() - 2);
-        trimStr(expr);
-      } else
-        break;
-    }
-
-    // Check for NOT (unary) - handles both "NOT a" and "NOT (a AND b)"
-    if (expr.size() > 4 && expr.substr(0, 4) == "NOT ") {
-      std::string inner = expr.substr(4);
-      trimStr(inner);
-      Signal innerSig = parseExpr(inner, err);
-      if (innerSig.nodeId < 0)
-        return {-1, ""};
-      int notGate = createNode("NOT", gateX, gateY);
-      gateY += 50;
-      connect(innerSig.nodeId, innerSig.slot, notGate, "in");
-      return {notGate, "out"};
-    }
-
-    // Check for AND (binary) - find AND not inside parentheses
-    {
-      int depth = 0;
-      for (size_t i = 0; i + 5 <= expr.size(); ++i) {
-        if (expr[i] == '(')
-          depth++;
-        else if (expr[i] == ')')
-          depth--;
-        else if (depth == 0 && expr.substr(i, 5) == " AND ") {
-          std::string left = expr.substr(0, i);
-          std::string right = expr.substr(i + 5);
-          trimStr(left);
-          trimStr(right);
-          Signal leftSig = parseExpr(left, err);
-          if (leftSig.nodeId < 0)
-            return {-1, ""};
-          Signal rightSig = parseExpr(right, err);
-          if (rightSig.nodeId < 0)
-            return {-1, ""};
-          int andGate = createNode("AND", gateX, gateY);
-          gateY += 50;
-          connect(leftSig.nodeId, leftSig.slot, andGate, "in0");
-          connect(rightSig.nodeId, rightSig.slot, andGate, "in1");
-          return {andGate, "out"};
-        }
-      }
-    }
-
-    // Check for OR (binary) - find OR not inside parentheses
-    {
-      int depth = 0;
-      for (size_t i = 0; i + 4 <= expr.size(); ++i) {
-        if (expr[i] == '(')
-          depth++;
-        else if (expr[i] == ')')
-          depth--;
-        else if (depth == 0 && expr.substr(i, 4) == " OR ") {
-          std::string left = expr.substr(0, i);
-          std::string right = expr.substr(i + 4);
-          trimStr(left);
-          trimStr(right);
-          Signal leftSig = parseExpr(left, err);
-          if (leftSig.nodeId < 0)
-            return {-1, ""};
-          Signal rightSig = parseExpr(right, err);
-          if (rightSig.nodeId < 0)
-            return {-1, ""};
-          // Check if OR is defined as custom gate
-          if (CustomGate::GateRegistry.count("OR")) {
-            int orGate = createNode("OR", gateX, gateY);
-            gateY += 60;
-            const auto &gateDef = CustomGate::GateRegistry["OR"];
-
-            std::string in0Slot = "in0";
-            if (!gateDef.inputPinNames.empty())
-              in0Slot = gateDef.inputPinNames[0];
-            else if (gateDef.inputPinIndices.size() == 1)
-              in0Slot = "in";
-
-            std::string in1Slot = "in1";
-            if (gateDef.inputPinNames.size() > 1)
-              in1Slot = gateDef.inputPinNames[1];
-            else if (gateDef.inputPinIndices.size() == 1)
-              in1Slot = "in";
-
-            connect(leftSig.nodeId, leftSig.slot, orGate, in0Slot);
-            connect(rightSig.nodeId, rightSig.slot, orGate, in1Slot);
-
-            std::string outSlot = "out";
-            if (!gateDef.outputPinNames.empty())
-              outSlot = gateDef.outputPinNames[0];
-
-            return {orGate, outSlot};
-          }
-          // Build OR from NOT and AND: OR(a,b) = NOT(NOT a AND NOT b)
-          int notLeft = createNode("NOT", gateX, gateY);
-          gateY += 50;
-          connect(leftSig.nodeId, leftSig.slot, notLeft, "in");
-          int notRight = createNode("NOT", gateX, gateY);
-          gateY += 50;
-          connect(rightSig.nodeId, rightSig.slot, notRight, "in");
-          int andGate = createNode("AND", gateX, gateY);
-          gateY += 50;
-          connect(notLeft, "out", andGate, "in0");
-          connect(notRight, "out", andGate, "in1");
-          int notResult = createNode("NOT", gateX, gateY);
-          gateY += 50;
-          connect(andGate, "out", notResult, "in");
-          return {notResult, "out"};
-        }
-      }
-    }
-
-    // Check for custom gate call: GateName(arg1, arg2, ...)
-    size_t parenPos = expr.find('(');
-    if (parenPos != std::string::npos && parenPos > 0) {
-      size_t closePos = expr.rfind(')');
-      if (closePos != std::string::npos && closePos > parenPos) {
-        std::string gateType = expr.substr(0, parenPos);
-        trimStr(gateType);
-        std::string argsStr =
-            expr.substr(parenPos + 1, closePos - parenPos - 1);
-        std::vector<std::string> callArgs = splitStr(argsStr, ',');
-
-        if (!CustomGate::GateRegistry.count(gateType)) {
-          err = "Unknown gate type: " + gateType;
-          return {-1, ""};
-        }
-
-        // Recursively parse each argument
-        std::vector<Signal> argSigs;
-        for (const auto &arg : callArgs) {
-          Signal argSig = parseExpr(arg, err);
-          if (argSig.nodeId < 0)
-            return {-1, ""};
-          argSigs.push_back(argSig);
-        }
-
-        int customGate = createNode(gateType, gateX, gateY);
-        gateY += 60;
-
-        const auto &gateDef = CustomGate::GateRegistry[gateType];
-        for (size_t i = 0;
-             i < argSigs.size() && i < gateDef.inputPinIndices.size(); ++i) {
-          std::string inSlot;
-          if (i < gateDef.inputPinNames.size()) {
-            inSlot = gateDef.inputPinNames[i];
-          } else {
-            inSlot = (gateDef.inputPinIndices.size() == 1)
-                         ? "in"
-                         : "in" + std::to_string(i);
-          }
-          connect(argSigs[i].nodeId, argSigs[i].slot, customGate, inSlot);
-        }
-
-        // Use first output name if available
-        std::string outSlot;
-        if (!gateDef.outputPinNames.empty()) {
-          outSlot = gateDef.outputPinNames[0];
-        } else {
-          outSlot = (gateDef.outputPinIndices.size() == 1) ? "out" : "out0";
-        }
-        return {customGate, outSlot};
-      }
-    }
-
-    // Must be a signal reference
-    if (signals.count(expr)) {
-      return signals[expr];
-    }
-
-    err = "Unknown signal: " + expr;
-    return {-1, ""};
-  };
-
-  for (const auto &[outSignal, expr] : assignments) {
-    std::string parseErr;
-    Signal resultSig = parseExpr(expr, parseErr);
-    if (resultSig.nodeId < 0) {
-      errorOut = parseErr;
+  for (size_t i = 0; i < a.nodes.size(); ++i) {
+    const NodeDefinition &x = a.nodes[i], &y = b.nodes[i];
+    if (x.type != y.type || x.id != y.id || x.pos.x != y.pos.x ||
+        x.pos.y != y.pos.y)
       return false;
-    }
-    signals[outSignal] = resultSig;
   }
-
-  // Create PinOut nodes for each output
-  float outX = 300;
-  float outY = 0;
-  for (const auto &outputName : outputs) {
-    NodeDefinition nd;
-    nd.type = "Out";
-    nd.id = nodeIdCounter;
-    nd.pos = ImVec2(outX, outY);
-    outY += 60;
-    def.nodes.push_back(nd);
-    def.outputPinIndices.push_back(nodeIdCounter);
-
-    // Connect the signal to this output
-    if (signals.count(outputName)) {
-      ConnectionDefinition cd;
-      cd.outputNodeId = signals[outputName].nodeId;
-      cd.outputSlot = signals[outputName].slot;
-      cd.inputNodeId = nodeIdCounter;
-      cd.inputSlot = "in";
-      def.connections.push_back(cd);
-    } else {
-      errorOut = "Output signal not defined: " + outputName;
+  for (size_t i = 0; i < a.connections.size(); ++i) {
+    const ConnectionDefinition &x = a.connections[i], &y = b.connections[i];
+    if (x.inputNodeId != y.inputNodeId || x.inputSlot != y.inputSlot ||
+        x.outputNodeId != y.outputNodeId || x.outputSlot != y.outputSlot)
       return false;
-    }
-    nodeIdCounter++;
-  }
-
-  // Register the gate (preserve isTemporary if already registered as permanent)
-  if (CustomGate::GateRegistry.count(def.name) &&
-      !CustomGate::GateRegistry[def.name].isTemporary) {
-    def.isTemporary = false;
   }
-  CustomGate::GateRegistry[def.name] = def;
-
   return true;
 }
 
-// Extract all define...end blocks from script and parse them
-// Returns the define blocks in 'definitions' for preservation
-static std::string ExtractAndParseDefinitions(const std::string &script,
-                                              std::string &remaining,
-                                              std::string &definitions,
-                                              std::string &errorOut) {
-  remaining = "";
-  definitions = "";
-  std::stringstream ss(script);
-  std::string line;
-  bool inDefine = false;
-  std::string currentDefine;
-  std::string outsideDefine;
-  std::string allDefinitions;
-
-  while (std::getline(ss, line)) {
-    std::string trimmed = line;
-    trimStr(trimmed);
-
-    if (!inDefine && trimmed.substr(0, 7) == "define ") {
-      inDefine = true;
-      currentDefine = line + "\n";
-    } else if (inDefine) {
-      currentDefine += line + "\n";
-      if (trimmed == "end") {
-        // Parse this definition
-        std::string err;
-        if (!ParseGateDefinition(currentDefine, err)) {
-          errorOut += "Define error: " + err + "\n";
-        } else {
-          // Successfully parsed, preserve the block
-          allDefinitions += currentDefine + "\n";
-        }
-        inDefine = false;
-        currentDefine = "";
-      }
-    } else {
-      outsideDefine += line + "\n";
+static uint64_t Mix(uint64_t hash, uint64_t value) {
+  return (hash ^ value) * 1099511628211ull;
+}
+
+void NodeEditor::UpdateScriptFromNodes() {
+  // First pass: Assign IDs
+  bool anyUnnamed = false;
+  for (Node *node : nodes)
+    anyUnnamed |= node->id.empty();
+  if (anyUnnamed) {
+    std::unordered_set<std::string> taken;
+    for (Node *node : nodes)
+      taken.insert(node->id);
+    int autoIdCounter = 0;
+    for (Node *node : nodes) {
+      if (!node->id.empty())
+        continue;
+      std::string candidate;
+      do
+        candidate = "n" + std::to_string(autoIdCounter++);
+      while (taken.count(candidate));
+      node->id = candidate;
+      taken.insert(candidate);
     }
   }
 
-  if (inDefine) {
-    errorOut += "Unclosed define block\n";
+  // Everything the text is built from. Wires and the node set are covered by
+  // their revision counters; positions, ids and pin modes change in place.
+  uint64_t fingerprint = 14695981039346656037ull;
+  fingerprint = Mix(fingerprint, (uint64_t)(uintptr_t)arena);
+  fingerprint = Mix(fingerprint, arena->Revision());
+  fingerprint = Mix(fingerprint, Wires::Revision());
+  fingerprint = Mix(fingerprint, std::hash<std::string>()(scriptDefinitions));
+  for (Node *node : nodes) {
+    fingerprint = Mix(fingerprint, (uint64_t)(uintptr_t)node);
+    fingerprint = Mix(fingerprint, std::hash<std::string>()(node->id));
+    fingerprint = Mix(fingerprint, (uint64_t)(int64_t)node->pos.x);
+    fingerprint = Mix(fingerprint, (uint64_t)(int64_t)node->pos.y);
+    if (node->type == Sym::In)
+      fingerprint = Mix(fingerprint, ((PinIn *)node)->isMomentary);
   }
+  if (fingerprint == scriptFingerprint && currentScript == generatedScript)
+    return;
 
-  remaining = outsideDefine;
-  definitions = allDefinitions;
-  return errorOut;
-}
-
-void NodeEditor::UpdateScriptFromNodes() {
+  PROFILE_ZONE("UpdateScriptFromNodes");
   std::stringstream ss;
-  std::map<Node *, std::string> nodeToId;
-  int autoIdCounter = 0;
 
   // Include any preserved gate definitions at the top
   if (!scriptDefinitions.empty()) {
     ss << scriptDefinitions;
   }
 
-  // First pass: Assign IDs
-  for (int i = 0; i < nodes.size(); ++i) {
-    if (nodes[i]->id.empty()) {
-      // Find a unique ID
-      while (true) {
-        std::string candidate = "n" + std::to_string(autoIdCounter++);
-        bool clash = false;
-        for (const auto &n : nodes) {
-          if (n->id == candidate) {
-            clash = true;
-            break;
-          }
-        }
-        if (!clash) {
-          nodes[i]->id = candidate;
-          break;
-        }
-      }
-    }
-    nodeToId[nodes[i]] = nodes[i]->id;
-  }
-
   for (int i = 0; i < nodes.size(); ++i) {
     std::string type = nodes[i]->title;
     ss << type << " " << nodes[i]->id << " @ " << (int)nodes[i]->pos.x << ", "
@@ -575,33 +108,83 @@ void NodeEditor::UpdateScriptFromNodes() {
     ss << "\n";
   }
   ss << "\n";
+  // Bits of one bus wired in order to bits of another are written as one
+  // wire, g1.s[3:0] -> g2.a[3:0], rather than a line per bit
+  struct BusWire {
+    Node *to;
+    std::string_view from, into;
+    int shift; // Input bit minus output bit
+    std::vector<int> bits;
+
+    BusWire(Node *to, std::string_view from, std::string_view into, int shift)
+        : to(to), from(from), into(into), shift(shift) {}
+  };
+  std::vector<BusWire> busWires;
+  auto range = [](int hi, int lo) {
+    return hi == lo ? "[" + std::to_string(hi) + "]"
+                    : "[" + std::to_string(hi) + ":" + std::to_string(lo) +
+                          "]";
+  };
   for (auto *node : nodes) {
-    for (const auto &conn : node->connections) {
-      if (conn.outputNode == node) {
-        ss << nodeToId[(Node *)conn.outputNode] << "." << conn.outputSlot
-           << " -> " << nodeToId[(Node *)conn.inputNode] << "."
-           << conn.inputSlot << "\n";
+    busWires.clear();
+    for (const auto &conn : node->fanout) {
+      const char *outTitle = node->outputSlots[conn.outputSlot].title;
+      const char *inTitle = conn.inputNode->inputSlots[conn.inputSlot].title;
+      std::string_view from, into;
+      int outBit, inBit;
+      if (SplitBusPin(outTitle, from, outBit) &&
+          SplitBusPin(inTitle, into, inBit)) {
+        auto bus = std::find_if(
+            busWires.begin(), busWires.end(), [&](const BusWire &wire) {
+              return wire.to == conn.inputNode && wire.from == from &&
+                     wire.into == into && wire.shift == inBit - outBit;
+            });
+        if (bus == busWires.end())
+          bus = busWires.emplace(busWires.end(), conn.inputNode, from, into,
+                                 inBit - outBit);
+        bus->bits.push_back(outBit);
+        continue;
+      }
+      ss << node->id << "." << outTitle << " -> " << conn.inputNode->id << "."
+         << inTitle << "\n";
+    }
+    for (BusWire &bus : busWires) {
+      std::sort(bus.bits.begin(), bus.bits.end());
+      for (size_t first = 0, last; first < bus.bits.size(); first = last) {
+        for (last = first + 1;
+             last < bus.bits.size() && bus.bits[last] == bus.bits[last - 1] + 1;
+             ++last)
+          ;
+        int lo = bus.bits[first], hi = bus.bits[last - 1];
+        ss << node->id << "." << bus.from << range(hi, lo) << " -> "
+           << bus.to->id << "." << bus.into
+           << range(hi + bus.shift, lo + bus.shift) << "\n";
       }
     }
   }
   currentScript = ss.str();
+  // The text describes the graph as it is, so there is nothing to parse back
+  lastParsedScript = currentScript;
+  generatedScript = currentScript;
+  scriptFingerprint = fingerprint;
 }
 
 // Helper to get the actual slot title for a custom gate given a slot reference
 // Accepts both named (a, b) and indexed (in0, in1), returns the actual slot
 // name
-static std::string ResolveSlotName(Node *node, const std::string &slotName,
+static std::string ResolveSlotName(Node *node, std::string_view slotName,
                                    bool isInput) {
-  if (!CustomGate::GateRegistry.count(node->title))
-    return slotName;
+  const auto &gateDef = CustomGate::GateRegistry.Find(node->type);
+  if (!gateDef)
+    return std::string(slotName);
 
-  const auto &def = CustomGate::GateRegistry[node->title];
+  const auto &def = *gateDef;
 
   if (isInput && !def.inputPinNames.empty()) {
     // Check if slotName is already a custom name
     for (const auto &name : def.inputPinNames) {
       if (name == slotName)
-        return slotName;
+        return std::string(slotName);
     }
     // Map indexed to custom name
     if (slotName == "in" && def.inputPinNames.size() == 1)
@@ -614,7 +197,7 @@ static std::string ResolveSlotName(Node *node, const std::string &slotName,
     // Check if slotName is already a custom name
     for (const auto &name : def.outputPinNames) {
       if (name == slotName)
-        return slotName;
+        return std::string(slotName);
     }
     // Map indexed to custom name
     if (slotName == "out" && def.outputPinNames.size() == 1)
@@ -625,149 +208,252 @@ static std::string ResolveSlotName(Node *node, const std::string &slotName,
     }
   }
 
-  return slotName;
+  return std::string(slotName);
 }
 
-void NodeEditor::UpdateNodesFromScript() {
-  if (currentScript == lastParsedScript)
+// Slots a wire end names, least significant first: the slot itself, or the
+// bits of the bus it names, narrowed to range if one was given. Empty if any
+// of them is missing.
+static void ResolveWireSlots(Node *node, std::string_view slotName,
+                             const ScriptRange &range, bool isInput,
+                             std::vector<int> &slots) {
+  auto find = [&](const std::string &name) {
+    return isInput ? node->FindInputSlot(name.c_str())
+                   : node->FindOutputSlot(name.c_str());
+  };
+  slots.clear();
+  if (range.Given()) {
+    for (int bit = range.lo; bit <= range.hi; ++bit) {
+      int slot = find(BusPinName(slotName, bit));
+      if (slot < 0) {
+        slots.clear();
+        return;
+      }
+      slots.push_back(slot);
+    }
     return;
-  lastParsedScript = currentScript;
-  scriptError = "";
-
-  auto trim = [](std::string &s) {
-    if (s.empty())
-      return;
-    s.erase(0, s.find_first_not_of(" \t\n\r"));
-    size_t last = s.find_last_not_of(" \t\n\r");
-    if (last != std::string::npos)
-      s.erase(last + 1);
+  }
+  int slot = find(ResolveSlotName(node, slotName, isInput));
+  if (slot >= 0) {
+    slots.push_back(slot);
+    return;
+  }
+  while ((slot = find(BusPinName(slotName, (int)slots.size()))) >= 0)
+    slots.push_back(slot);
+}
+
+void NodeEditor::ApplySceneScript(const ScriptAst &scene) {
+  // A node is kept when the script still lists its id with the same type, and
+  // for custom gates the same definition; anything else is rebuilt
+  auto reusable = [&](Node *node, std::string_view type) {
+    if (node->type != SymbolTable::Find(type))
+      return false;
+    if (placeholderNodes.count((PlaceholderGate *)node))
+      return false;
+    const auto &def = CustomGate::GateRegistry.Find(node->type);
+    return !def || ((CustomGate *)node)->Definition() == def;
   };
 
-  for (auto *n : nodes)
-    delete n;
-  nodes.clear();
-
-  // First pass: Extract and parse custom gate definitions
-  std::string remainingScript;
-  std::string defErrors;
-  ExtractAndParseDefinitions(currentScript, remainingScript, scriptDefinitions,
-                             defErrors);
-  if (!defErrors.empty()) {
-    scriptError += defErrors;
+  std::unordered_map<std::string_view, Node *> existing;
+  existing.reserve(nodes.size());
+  for (Node *node : nodes)
+    if (!node->id.empty())
+      existing.emplace(node->id, node);
+
+  std::vector<Node *> next;
+  next.reserve(scene.nodes.size());
+  std::unordered_map<std::string_view, Node *> idToNode;
+  idToNode.reserve(scene.nodes.size());
+  std::unordered_set<Node *> kept;
+  kept.reserve(nodes.size());
+  std::vector<Node *> moved;
+
+  auto error = [&](const SourceSpan &span, std::string message) {
+    scriptErrors.push_back({span, std::move(message)});
+  };
+
+  for (const ScriptNodeDecl &scriptNode : scene.nodes) {
+    ImVec2 pos((float)scriptNode.x, (float)scriptNode.y);
+    if (idToNode.count(scriptNode.id)) {
+      error(scriptNode.span, "Duplicate id " + std::string(scriptNode.id));
+      continue;
+    }
+
+    Node *node = nullptr;
+    auto found = existing.find(scriptNode.id);
+    if (found != existing.end() && reusable(found->second, scriptNode.type)) {
+      node = found->second;
+      existing.erase(found);
+      kept.insert(node);
+      if (node->pos.x != pos.x || node->pos.y != pos.y)
+        moved.push_back(node);
+    } else {
+      node = CreateNodeByType(*arena, SymbolTable::Find(scriptNode.type));
+      if (!node) {
+        error(scriptNode.span, "Unknown type " + std::string(scriptNode.type));
+        continue;
+      }
+      node->id = std::string(scriptNode.id);
+    }
+
+    node->pos = pos;
+    if (node->type == Sym::In)
+      ((PinIn *)node)->isMomentary = scriptNode.momentary;
+    next.push_back(node);
+    idToNode[scriptNode.id] = node;
   }
 
-  // Second pass: Parse nodes and connections from remaining script
-  std::stringstream ss(remainingScript);
-  std::string line;
-  std::map<std::string, Node *> idToNode;
-  int lineNum = 0;
+  // Nodes the script no longer lists
+  for (Node *node : nodes) {
+    if (kept.count(node))
+      continue;
+    Wires::DisconnectAll(node);
+    placeholderNodes.erase((PlaceholderGate *)node);
+    arena->Destroy(node);
+  }
+  // The draw order is patched by giving new nodes the next places, which
+  // only holds if kept nodes keep their order and new ones come after them
+  bool reordered = false, added = false;
+  uint32_t lastOrder = 0;
+  for (Node *node : next) {
+    if (!kept.count(node)) {
+      added = true;
+      continue;
+    }
+    auto order = drawOrder.find(node->handle);
+    if (added || order == drawOrder.end() || order->second < lastOrder) {
+      reordered = true;
+      break;
+    }
+    lastOrder = order->second;
+  }
+  nodes = std::move(next);
 
-  while (std::getline(ss, line)) {
-    lineNum++;
-    trim(line);
-    if (line.empty() || (line.size() >= 2 && line[0] == '/' && line[1] == '/'))
+  // Wires: connect what differs, then drop inputs the script leaves undriven
+  std::unordered_set<uint64_t> wanted;
+  wanted.reserve(scene.wires.size());
+  auto wireKey = [](Node *node, int slot) {
+    return ((uint64_t)node->handle << 32) | (uint32_t)slot;
+  };
+  std::vector<int> outSlots, inSlots;
+  for (const ScriptWireDecl &wire : scene.wires) {
+    auto outIt = idToNode.find(wire.outId);
+    auto inIt = idToNode.find(wire.inId);
+    if (outIt == idToNode.end() || inIt == idToNode.end())
+      continue;
+    Node *outNode = outIt->second;
+    Node *inNode = inIt->second;
+
+    // Resolve slot names (maps in0->a if custom names exist, a to a[0],
+    // a[1], ... for a bus), then to pin indices; a bus wire connects bit by
+    // bit and is dropped if the widths differ
+    ResolveWireSlots(outNode, wire.outSlot, wire.outRange, false, outSlots);
+    ResolveWireSlots(inNode, wire.inSlot, wire.inRange, true, inSlots);
+    if (outSlots.empty() || outSlots.size() != inSlots.size())
       continue;
+    for (size_t bit = 0; bit < inSlots.size(); ++bit) {
+      int outSlot = outSlots[bit], inSlot = inSlots[bit];
+      wanted.insert(wireKey(inNode, inSlot));
+      const Driver &driver = inNode->drivers[inSlot];
+      if (driver.node != outNode || driver.slot != outSlot)
+        Wires::Connect(outNode, outSlot, inNode, inSlot);
+    }
+  }
+  for (Node *node : nodes)
+    for (int i = 0; i < (int)node->drivers.size(); ++i)
+      if (node->drivers[i].node && !wanted.count(wireKey(node, i)))
+        Wires::Disconnect(node, i);
+
+  // Moves patch the spatial index in place; added and removed nodes are
+  // patched in from the arena's log
+  for (Node *node : moved)
+    UpdateNodeBounds(node);
+  if (reordered)
+    drawOrderStale = true;
+}
 
-    try {
-      if (line.find("->") != std::string::npos) {
-        size_t arrowPos = line.find("->");
-        std::string left = line.substr(0, arrowPos);
-        std::string right = line.substr(arrowPos + 2);
-        trim(left);
-        trim(right);
-
-        auto parseSlot =
-            [&](std::string s,
-                bool isOutput) -> std::pair<std::string, std::string> {
-          size_t dot = s.find('.');
-          if (dot == std::string::npos) {
-            return {s, isOutput ? "out" : "in"};
-          }
-          std::string nodePart = s.substr(0, dot);
-          std::string slotPart = s.substr(dot + 1);
-          trim(nodePart);
-          trim(slotPart);
-          return {nodePart, slotPart};
-        };
-
-        auto outS = parseSlot(left, true);
-        auto inS = parseSlot(right, false);
-
-        if (outS.first.empty() || inS.first.empty() || outS.second.empty() ||
-            inS.second.empty())
-          continue;
-
-        if (idToNode.count(outS.first) && idToNode.count(inS.first)) {
-          Node *outNode = idToNode[outS.first];
-          Node *inNode = idToNode[inS.first];
-
-          // Resolve slot names for VALIDATION only (maps in0->a if custom names
-          // exist)
-          std::string resolvedOutSlot =
-              ResolveSlotName(outNode, outS.second, false);
-          std::string resolvedInSlot =
-              ResolveSlotName(inNode, inS.second, true);
-
-          bool outSlotValid = false;
-          if (resolvedOutSlot == "out" && std::string(outNode->title) == "In")
-            outSlotValid = true;
-          else {
-            for (int i = 0; i < outNode->outputSlotCount; ++i)
-              if (std::string(outNode->outputSlots[i].title) == resolvedOutSlot)
-                outSlotValid = true;
-          }
-
-          bool inSlotValid = false;
-          if (resolvedInSlot == "in" && std::string(inNode->title) == "Out")
-            inSlotValid = true;
-          else {
-            for (int i = 0; i < inNode->inputSlotCount; ++i)
-              if (std::string(inNode->inputSlots[i].title) == resolvedInSlot)
-                inSlotValid = true;
-          }
-
-          if (outSlotValid && inSlotValid) {
-            Connection conn;
-            conn.outputNode = outNode;
-            conn.outputSlot = resolvedOutSlot;
-            conn.inputNode = inNode;
-            conn.inputSlot = resolvedInSlot;
-            outNode->connections.push_back(conn);
-            inNode->connections.push_back(conn);
-          }
-        }
-      } else if (line.find("@") != std::string::npos) {
-        std::stringstream lss(line);
-        std::string type, id, at;
-        int x, y;
-        char comma;
-        if (!(lss >> type >> id >> at >> x >> comma >> y)) {
-          scriptError +=
-              "Line " + std::to_string(lineNum) + ": Invalid node format\n";
-          continue;
-        }
-
-        Node *n = CreateNodeByType(type);
-        if (n) {
-          n->pos = {(float)x, (float)y};
-          n->id = id;
-          if (type == "In" && line.find("momentary") != std::string::npos) {
-            ((PinIn *)n)->isMomentary = true;
-          }
-          nodes.push_back(n);
-          idToNode[id] = n;
-        } else {
-          scriptError += "Line " + std::to_string(lineNum) + ": Unknown type " +
-                         type + "\n";
-        }
-      }
-    } catch (...) {
-      scriptError += "Line " + std::to_string(lineNum) + ": Unexpected error\n";
+int NodeEditor::ScriptInputCallback(ImGuiInputTextCallbackData *data) {
+  NodeEditor *editor = (NodeEditor *)data->UserData;
+  if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+    editor->currentScript.resize(data->BufTextLen);
+    data->Buf = editor->currentScript.data();
+    return 0;
+  }
+
+  if (editor->scriptJumpTo >= 0) {
+    if (editor->scriptJumpTo < (int)editor->scriptErrors.size()) {
+      const SourceSpan &span = editor->scriptErrors[editor->scriptJumpTo].span;
+      // By line and column rather than offset, so the jump still lands on
+      // the right line if text was added above since
+      size_t offset = editor->scriptLines.Offset(span.line, span.column);
+      int start = (int)std::min(offset, (size_t)data->BufTextLen);
+      int end = std::min(start + (int)span.length, data->BufTextLen);
+      data->SelectionStart = start;
+      data->SelectionEnd = end;
+      data->CursorPos = end;
     }
+    editor->scriptJumpTo = -1;
   }
+  return 0;
+}
 
-  // After parsing, regenerate script to normalize it and prevent re-parse loops
-  UpdateScriptFromNodes();
-  lastParsedScript = currentScript;
+void NodeEditor::UpdateNodesFromScript() {
+  // Inside a gate instance the script is a read-only view of its internals
+  if (StructureLocked() || currentScript == lastParsedScript)
+    return;
+  PROFILE_ZONE("UpdateNodesFromScript");
+  // Anything still compiling in the background is older than this
+  scriptCompiler.Cancel();
+  CompiledScript compiled;
+  CompileScript(currentScript, CustomGate::GateRegistry, compiled,
+                &scriptCompiler.Cache(), currentPath);
+  ApplyCompiledScript(compiled);
+}
+
+void NodeEditor::QueueScriptCompile() {
+  if (!StructureLocked())
+    scriptCompiler.Submit(currentScript, CustomGate::GateRegistry,
+                          currentPath);
+}
+
+void NodeEditor::ApplyCompiledScript(const CompiledScript &compiled) {
+  // The text moved on (more typing, or a different level) since this was
+  // submitted; a newer result replaces it
+  if (StructureLocked() || compiled.text != currentScript)
+    return;
+  PROFILE_ZONE("ApplyCompiledScript");
+  lastParsedScript = compiled.text;
+  scriptErrors = compiled.errors;
+  scriptLines = compiled.lines;
+  scriptDefinitions = compiled.definitionsText;
+
+  // Register definitions first so the scene can use them
+  RegisterScriptDefinitions(compiled);
+
+  // Then apply only the differences to the graph so untouched nodes keep
+  // their state and selection
+  ApplySceneScript(compiled.ast);
+
+  // The text is normalized by UpdateScriptFromNodes once the user stops
+  // typing; doing it here would format the whole scene on every keystroke
+}
+
+void NodeEditor::RegisterScriptDefinitions(const CompiledScript &compiled) {
+  for (const GateDefinitionRef &def : compiled.definitions) {
+    const auto &existing = CustomGate::GateRegistry.Find(def->name);
+    // Reparsing an unchanged block keeps the registered copy, so gates built
+    // from it are still current and survive the script sync. A block the
+    // compile took from its cache is the very definition registered.
+    if (existing && (existing == def || SameDefinition(*existing, *def)))
+      continue;
+    // Preserve isTemporary if already registered as permanent
+    if (existing && !existing->isTemporary) {
+      GateDefinition permanent = *def;
+      permanent.isTemporary = false;
+      CustomGate::GateRegistry.Register(std::move(permanent));
+    } else {
+      CustomGate::GateRegistry.Register(def);
+    }
+  }
 }
 } // namespace Logicarium
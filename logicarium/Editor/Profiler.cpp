@@ -0,0 +1,362 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "Profiler.hpp"
+#include "pch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Logicarium {
+namespace Profiler {
+namespace {
+struct Event {
+  const char *name;
+  uint64_t start, end;
+  uint32_t frame;
+  uint16_t depth;
+};
+
+// Zones kept per thread; the oldest are overwritten
+constexpr uint64_t RingSize = 1 << 14;
+// Frames the percentiles are taken over
+constexpr int HistoryFrames = 300;
+constexpr float TimelineRowHeight = 18.0f;
+
+// Written only by the thread that holds it. head counts every event ever
+// recorded, so the reader can tell which ones were overwritten before it got
+// to them.
+struct ThreadRing {
+  Event events[RingSize];
+  std::atomic<uint64_t> head{0};
+  std::atomic<bool> exited{false}; // Set by its thread on the way out
+  uint64_t drained = 0;            // Reader side
+  bool reusable = false; // Exited and drained; guarded by ringsMutex
+  int index = 0;
+};
+
+const auto epoch = std::chrono::steady_clock::now();
+
+// A thread's ring outlives the thread, so its last zones stay readable. Once
+// the main thread has drained them the ring goes to the next thread that
+// records, so rings are bounded by the threads alive at once rather than by
+// every thread ever started.
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<ThreadRing>> rings;
+struct LocalRingHolder {
+  ThreadRing *ring = nullptr;
+  ~LocalRingHolder() {
+    if (ring)
+      ring->exited.store(true, std::memory_order_release);
+  }
+};
+thread_local LocalRingHolder localRing;
+thread_local int localDepth = 0;
+std::atomic<uint32_t> currentFrame{0};
+
+ThreadRing &LocalRing() {
+  if (!localRing.ring) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (auto &ring : rings) {
+      if (ring->reusable) {
+        ring->reusable = false;
+        ring->exited.store(false, std::memory_order_relaxed);
+        localRing.ring = ring.get();
+        break;
+      }
+    }
+    if (!localRing.ring) {
+      rings.push_back(std::make_unique<ThreadRing>());
+      localRing.ring = rings.back().get();
+      localRing.ring->index = (int)rings.size() - 1;
+    }
+  }
+  return *localRing.ring;
+}
+
+// Copies every event still in the ring from index `from` on. Events the
+// writer lapped while they were being copied are dropped, and so is the one
+// whose slot it may be writing right now.
+void CopyEvents(const ThreadRing &ring, uint64_t from, std::vector<Event> &out,
+                uint64_t *head) {
+  uint64_t end = ring.head.load(std::memory_order_acquire);
+  from = std::max(from, end > RingSize ? end - RingSize : 0);
+  size_t first = out.size();
+  for (uint64_t i = from; i < end; ++i)
+    out.push_back(ring.events[i % RingSize]);
+
+  // The writer may be storing event `after`, over event `after - RingSize`
+  uint64_t after = ring.head.load(std::memory_order_acquire);
+  if (after + 1 > RingSize && after + 1 - RingSize > from) {
+    size_t lapped = (size_t)std::min(after + 1 - RingSize - from, end - from);
+    out.erase(out.begin() + first, out.begin() + first + lapped);
+  }
+  *head = end;
+}
+
+// Rolling window of per-frame milliseconds
+struct History {
+  float samples[HistoryFrames] = {};
+  int count = 0;
+  int next = 0;
+  float last = 0;
+  uint32_t frame = 0; // Of the last sample
+
+  void Push(float ms) {
+    samples[next] = ms;
+    next = (next + 1) % HistoryFrames;
+    count = std::min(count + 1, HistoryFrames);
+    last = ms;
+  }
+
+  float Percentile(float p) const {
+    if (count == 0)
+      return 0;
+    float sorted[HistoryFrames];
+    std::copy(samples, samples + count, sorted);
+    int k = std::min((int)(p * count), count - 1);
+    std::nth_element(sorted, sorted + k, sorted + count);
+    return sorted[k];
+  }
+};
+
+struct Span {
+  Event event;
+  int thread;
+};
+
+// Reader state, main thread only
+History frameHistory;
+std::map<std::string, History> zoneHistory;
+std::unordered_map<const char *, float> frameTotals;
+std::vector<Span> frameSpans;
+std::vector<Span> shownSpans; // Last complete frame, as drawn in the timeline
+uint64_t frameStart = 0;
+uint64_t shownStart = 0, shownEnd = 0;
+bool paused = false;
+std::string exportStatus;
+std::vector<Event> scratch;
+
+float Milliseconds(uint64_t ns) { return (float)((double)ns / 1e6); }
+
+void Drain() {
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  for (auto &ring : rings) {
+    if (ring->reusable)
+      continue;
+    // Read before copying, so the events copied include its thread's last
+    bool exited = ring->exited.load(std::memory_order_acquire);
+    scratch.clear();
+    CopyEvents(*ring, ring->drained, scratch, &ring->drained);
+    for (const Event &event : scratch) {
+      frameTotals[event.name] += Milliseconds(event.end - event.start);
+      frameSpans.push_back({event, ring->index});
+    }
+    if (exited)
+      ring->reusable = true;
+  }
+}
+
+ImU32 ZoneColor(const char *name) {
+  float hue = (float)(ImHashStr(name) % 360) / 360.0f;
+  float r, g, b;
+  ImGui::ColorConvertHSVtoRGB(hue, 0.55f, 0.75f, r, g, b);
+  return ImGui::ColorConvertFloat4ToU32(ImVec4(r, g, b, 1.0f));
+}
+
+void RenderTimeline() {
+  int threads = 1, depth = 1;
+  for (const Span &span : shownSpans) {
+    threads = std::max(threads, span.thread + 1);
+    depth = std::max(depth, span.event.depth + 1);
+  }
+
+  ImVec2 size(ImGui::GetContentRegionAvail().x,
+              threads * depth * TimelineRowHeight);
+  ImVec2 pos = ImGui::GetCursorScreenPos();
+  ImGui::InvisibleButton("timeline", ImMax(size, ImVec2(1, 1)));
+  bool hovered = ImGui::IsItemHovered();
+  ImVec2 mouse = ImGui::GetMousePos();
+
+  ImDrawList *drawList = ImGui::GetWindowDrawList();
+  drawList->AddRectFilled(pos, pos + size, IM_COL32(30, 30, 35, 255));
+  if (shownEnd <= shownStart)
+    return;
+
+  float scale = size.x / (float)(shownEnd - shownStart);
+  drawList->PushClipRect(pos, pos + size, true);
+  for (const Span &span : shownSpans) {
+    const Event &event = span.event;
+    float x0 = pos.x + (float)((int64_t)(event.start - shownStart)) * scale;
+    float x1 = pos.x + (float)((int64_t)(event.end - shownStart)) * scale;
+    x1 = std::max(x1, x0 + 1.0f);
+    float y0 = pos.y + (span.thread * depth + event.depth) * TimelineRowHeight;
+    ImVec2 min(x0, y0), max(x1, y0 + TimelineRowHeight - 1.0f);
+
+    drawList->AddRectFilled(min, max, ZoneColor(event.name));
+    if (x1 - x0 > 30.0f) {
+      drawList->PushClipRect(min, max, true);
+      drawList->AddText(min + ImVec2(3, 2), IM_COL32(0, 0, 0, 255), event.name);
+      drawList->PopClipRect();
+    }
+    if (hovered && ImRect(min, max).Contains(mouse))
+      ImGui::SetTooltip("%s\n%.3f ms", event.name,
+                        Milliseconds(event.end - event.start));
+  }
+  drawList->PopClipRect();
+}
+
+void WriteJsonString(std::ofstream &out, const char *text) {
+  out << '"';
+  for (const char *c = text; *c; ++c) {
+    if (*c == '"' || *c == '\\')
+      out << '\\';
+    out << *c;
+  }
+  out << '"';
+}
+} // namespace
+
+uint64_t Now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - epoch)
+      .count();
+}
+
+void Record(const char *name, uint64_t start, uint64_t end, int depth) {
+  ThreadRing &ring = LocalRing();
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  ring.events[head % RingSize] = {name, start, end, currentFrame.load(),
+                                  (uint16_t)depth};
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+Zone::Zone(const char *name) : name(name), start(Now()), depth(localDepth++) {}
+
+Zone::~Zone() {
+  --localDepth;
+  Record(name, start, Now(), depth);
+}
+
+void NewFrame() {
+  uint64_t now = Now();
+  Drain();
+
+  if (frameStart != 0) {
+    frameHistory.Push(Milliseconds(now - frameStart));
+    uint32_t frame = currentFrame.load();
+    for (const auto &[name, total] : frameTotals) {
+      History &history = zoneHistory[name];
+      history.Push(total);
+      history.frame = frame;
+    }
+    // A zone that didn't run this frame spent no time in it, so its
+    // percentiles are per frame rather than per occurrence
+    for (auto &[name, history] : zoneHistory)
+      if (history.frame != frame)
+        history.Push(0);
+    if (!paused) {
+      std::swap(shownSpans, frameSpans);
+      shownStart = frameStart;
+      shownEnd = now;
+    }
+  }
+  frameSpans.clear();
+  frameTotals.clear();
+  frameStart = now;
+  currentFrame++;
+}
+
+void ShowOverlay(bool *open) {
+  ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+  if (!ImGui::Begin("Profiler", open)) {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("Frame %.2f ms   p50 %.2f   p95 %.2f   p99 %.2f",
+              frameHistory.last, frameHistory.Percentile(0.5f),
+              frameHistory.Percentile(0.95f), frameHistory.Percentile(0.99f));
+  ImGui::Checkbox("Pause", &paused);
+  ImGui::SameLine();
+  if (ImGui::Button("Export Chrome Trace")) {
+    const char *path = "logicarium_trace.json";
+    exportStatus = ExportChromeTrace(path) ? std::string("Saved ") + path
+                                           : std::string("Could not write ") +
+                                                 path;
+  }
+  if (!exportStatus.empty()) {
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", exportStatus.c_str());
+  }
+
+  ImGui::Separator();
+  RenderTimeline();
+  ImGui::Separator();
+
+  if (ImGui::BeginTable("Zones", 5,
+                        ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+                            ImGuiTableFlags_ScrollY)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+    ImGui::TableSetupColumn("Last ms");
+    ImGui::TableSetupColumn("p50");
+    ImGui::TableSetupColumn("p95");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableHeadersRow();
+    for (const auto &[name, history] : zoneHistory) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(ZoneColor(name.c_str())),
+                         "%s", name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", history.last);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", history.Percentile(0.5f));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", history.Percentile(0.95f));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", history.Percentile(0.99f));
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+bool ExportChromeTrace(const std::string &path) {
+  std::ofstream out(path);
+  if (!out)
+    return false;
+
+  // Microseconds, with nanosecond precision
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  std::vector<Event> events;
+  std::lock_guard<std::mutex> lock(ringsMutex);
+  for (const auto &ring : rings) {
+    events.clear();
+    uint64_t head;
+    CopyEvents(*ring, 0, events, &head);
+    for (const Event &event : events) {
+      out << (first ? "\n" : ",\n") << "{\"name\":";
+      WriteJsonString(out, event.name);
+      out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->index
+          << ",\"ts\":" << (double)event.start / 1000.0
+          << ",\"dur\":" << (double)(event.end - event.start) / 1000.0
+          << ",\"args\":{\"frame\":" << event.frame << "}}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+  return (bool)out;
+}
+} // namespace Profiler
+} // namespace Logicarium
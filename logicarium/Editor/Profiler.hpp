@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Logicarium {
+// Frame profiler. PROFILE_ZONE times the rest of the enclosing scope; every
+// thread records its zones into a ring of its own, which only that thread
+// writes, so recording takes no locks. The main thread drains the rings once
+// per frame for the overlay, which shows the last frame as a timeline and
+// rolling percentiles of each zone's time per frame.
+namespace Profiler {
+// Nanoseconds since the profiler started
+uint64_t Now();
+// Records a finished zone on the calling thread. name must be a string
+// literal (or otherwise live for the whole run).
+void Record(const char *name, uint64_t start, uint64_t end, int depth);
+// Ends the current frame and starts the next one. Main loop only.
+void NewFrame();
+
+// Profiler window; clears open when closed
+void ShowOverlay(bool *open);
+// Writes every zone still in the rings as Chrome trace JSON
+// (chrome://tracing, Perfetto). Returns false if the file can't be written.
+bool ExportChromeTrace(const std::string &path);
+
+class Zone {
+public:
+  explicit Zone(const char *name);
+  ~Zone();
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+private:
+  const char *name;
+  uint64_t start;
+  int depth;
+};
+} // namespace Profiler
+} // namespace Logicarium
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name)                                                     \
+  ::Logicarium::Profiler::Zone PROFILE_CONCAT(profileZone, __COUNTER__)(name)
@@ -0,0 +1,75 @@
+#include "Repaint.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace Logicarium {
+namespace Repaint {
+using Clock = std::chrono::steady_clock;
+
+// Frames drawn after each request
+static constexpr int SettleFrames = 3;
+
+static std::atomic<int> framesLeft{SettleFrames};
+static std::atomic<bool> powerSaving{true};
+static std::atomic<void (*)()> wakeHandler{nullptr};
+
+static std::mutex deadlineMutex;
+static bool hasDeadline = false;
+static Clock::time_point deadline;
+
+void Request() {
+  framesLeft = SettleFrames;
+  if (auto wake = wakeHandler.load())
+    wake();
+}
+
+void Within(double seconds) {
+  auto due = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(seconds));
+  std::lock_guard<std::mutex> lock(deadlineMutex);
+  if (!hasDeadline || due < deadline) {
+    deadline = due;
+    hasDeadline = true;
+  }
+}
+
+void SetPowerSaving(bool enabled) {
+  powerSaving = enabled;
+  Request();
+}
+
+bool PowerSaving() { return powerSaving; }
+
+void SetWakeHandler(void (*wake)()) { wakeHandler = wake; }
+
+double TimeUntilDue() {
+  if (!powerSaving || framesLeft > 0)
+    return 0.0;
+  std::lock_guard<std::mutex> lock(deadlineMutex);
+  if (!hasDeadline)
+    return -1.0;
+  std::chrono::duration<double> left = deadline - Clock::now();
+  return std::max(left.count(), 0.0);
+}
+
+bool BeginFrame() {
+  if (!powerSaving)
+    return true;
+
+  int left = framesLeft;
+  while (left > 0 && !framesLeft.compare_exchange_weak(left, left - 1)) {
+  }
+  if (left > 0)
+    return true;
+
+  std::lock_guard<std::mutex> lock(deadlineMutex);
+  if (hasDeadline && Clock::now() >= deadline) {
+    hasDeadline = false;
+    return true;
+  }
+  return false;
+}
+} // namespace Repaint
+} // namespace Logicarium
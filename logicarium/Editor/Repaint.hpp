@@ -0,0 +1,29 @@
+#pragma once
+
+namespace Logicarium {
+// Frame invalidation for the power saving main loop. Anything that changes
+// what is on screen without going through input (background work finishing,
+// timed animations) asks for a repaint here; with power saving on, the main
+// loop sleeps until input arrives or a repaint is due.
+namespace Repaint {
+// Draws the next few frames, enough for ImGui to settle (hover states, popups
+// and auto-sized windows take a frame or two to catch up). Safe to call from
+// any thread; wakes the main loop if it is waiting for events.
+void Request();
+// Makes sure a frame is drawn at most `seconds` from now. For animations
+// driven from inside a frame; main thread only.
+void Within(double seconds);
+
+void SetPowerSaving(bool enabled);
+bool PowerSaving();
+
+// Main loop side
+// Installs the function that wakes the main loop from another thread
+void SetWakeHandler(void (*wake)());
+// Seconds until a frame is due: 0 if one is due now, negative if none is
+// scheduled at all.
+double TimeUntilDue();
+// Consumes the due frame. Returns false if this frame can be skipped.
+bool BeginFrame();
+} // namespace Repaint
+} // namespace Logicarium
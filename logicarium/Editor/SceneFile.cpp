@@ -0,0 +1,172 @@
+#include "SceneFile.hpp"
+#include "BinaryIO.hpp"
+
+namespace Logicarium {
+static constexpr std::string_view Magic = "BPS3";
+
+static constexpr uint32_t StringsSection = SectionId("STRS");
+static constexpr uint32_t DependenciesSection = SectionId("DEPS");
+static constexpr uint32_t ImportsSection = SectionId("IMPT");
+static constexpr uint32_t NodesSection = SectionId("NODE");
+static constexpr uint32_t WiresSection = SectionId("WIRE");
+
+static constexpr size_t NodeSize = 28;
+static constexpr size_t WireSize = 16;
+
+bool IsSceneFile(std::string_view bytes) {
+  return bytes.substr(0, Magic.size()) == Magic;
+}
+
+// Count of fixed-size records, checked against the bytes that follow it
+static bool ReadCount(ByteReader &in, size_t recordSize, uint32_t &count) {
+  count = in.U32();
+  return in.Ok() && in.Remaining() == (size_t)count * recordSize;
+}
+
+// A section that is a list of strings; an empty one is an empty list
+static bool ReadStringList(std::string_view data, uint32_t stringCount,
+                           std::vector<uint32_t> &list) {
+  if (data.empty())
+    return true;
+  ByteReader in(data);
+  uint32_t count;
+  if (!ReadCount(in, 4, count))
+    return false;
+  list.resize(count);
+  for (uint32_t &string : list)
+    if ((string = in.U32()) >= stringCount)
+      return false;
+  return true;
+}
+
+static std::string WriteStringList(const std::vector<uint32_t> &list) {
+  ByteWriter out;
+  out.U32((uint32_t)list.size());
+  for (uint32_t string : list)
+    out.U32(string);
+  return out.Bytes();
+}
+
+static bool ParseStrings(std::string_view data,
+                         std::vector<std::string_view> &strings) {
+  ByteReader in(data);
+  uint32_t count = in.U32();
+  if (!in.Ok() || count > in.Remaining() / 4)
+    return false;
+  std::string_view ends = in.Raw((size_t)count * 4);
+  std::string_view text = data.substr(4 + ends.size());
+  ByteReader endReader(ends);
+  strings.reserve(count);
+  size_t start = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    size_t end = endReader.U32();
+    if (end <= start || end > text.size() || text[end - 1] != '\0')
+      return false;
+    strings.push_back(text.substr(start, end - 1 - start));
+    start = end;
+  }
+  return start == text.size();
+}
+
+bool ParseSceneFile(std::string bytes, SceneFile &scene) {
+  scene = SceneFile();
+  scene.bytes = std::move(bytes);
+  std::string_view file = scene.bytes;
+  if (!IsSceneFile(file))
+    return false;
+
+  std::vector<FileSection> table;
+  if (!ReadSections(file, table))
+    return false;
+  std::string_view sections[5];
+  const uint32_t ids[5] = {StringsSection, DependenciesSection, NodesSection,
+                           WiresSection, ImportsSection};
+  for (const FileSection &section : table) {
+    if (Crc32(section.data) != section.crc)
+      return false;
+    for (int k = 0; k < 5; ++k)
+      if (section.id == ids[k])
+        sections[k] = section.data;
+  }
+  if (sections[0].empty() || sections[2].empty() || sections[3].empty() ||
+      !ParseStrings(sections[0], scene.strings))
+    return false;
+  uint32_t stringCount = (uint32_t)scene.strings.size();
+
+  if (!ReadStringList(sections[1], stringCount, scene.dependencies) ||
+      !ReadStringList(sections[4], stringCount, scene.imports))
+    return false;
+
+  uint32_t count;
+
+  ByteReader nodes(sections[2]);
+  if (!ReadCount(nodes, NodeSize, count))
+    return false;
+  scene.nodes.resize(count);
+  for (SceneFile::Node &node : scene.nodes) {
+    node.type = nodes.U32();
+    node.id = nodes.U32();
+    node.x = nodes.F32();
+    node.y = nodes.F32();
+    node.inputs = nodes.I32();
+    node.outputs = nodes.I32();
+    node.flags = nodes.U32();
+    if (node.type >= stringCount || node.id >= stringCount ||
+        node.inputs < 0 || node.outputs < 0)
+      return false;
+  }
+
+  ByteReader wires(sections[3]);
+  if (!ReadCount(wires, WireSize, count))
+    return false;
+  scene.wires.resize(count);
+  uint32_t nodeCount = (uint32_t)scene.nodes.size();
+  for (SceneFile::Wire &wire : scene.wires) {
+    wire.outputNode = wires.U32();
+    wire.outputSlot = wires.U32();
+    wire.inputNode = wires.U32();
+    wire.inputSlot = wires.U32();
+    if (wire.outputNode >= nodeCount || wire.inputNode >= nodeCount ||
+        wire.outputSlot >= stringCount || wire.inputSlot >= stringCount)
+      return false;
+  }
+  return true;
+}
+
+bool WriteSceneFile(const std::string &path, const SceneFile &scene) {
+  ByteWriter strings;
+  WriteStringSection(strings, scene.strings);
+
+  ByteWriter nodes;
+  nodes.Reserve(4 + scene.nodes.size() * NodeSize);
+  nodes.U32((uint32_t)scene.nodes.size());
+  for (const SceneFile::Node &node : scene.nodes) {
+    nodes.U32(node.type);
+    nodes.U32(node.id);
+    nodes.F32(node.x);
+    nodes.F32(node.y);
+    nodes.I32(node.inputs);
+    nodes.I32(node.outputs);
+    nodes.U32(node.flags);
+  }
+
+  ByteWriter wires;
+  wires.Reserve(4 + scene.wires.size() * WireSize);
+  wires.U32((uint32_t)scene.wires.size());
+  for (const SceneFile::Wire &wire : scene.wires) {
+    wires.U32(wire.outputNode);
+    wires.U32(wire.outputSlot);
+    wires.U32(wire.inputNode);
+    wires.U32(wire.inputSlot);
+  }
+
+  return WriteSectionedFile(path, Magic,
+                            {{StringsSection, 0, strings.Bytes()},
+                             {DependenciesSection, 0,
+                              WriteStringList(scene.dependencies)},
+                             {ImportsSection, 0,
+                              WriteStringList(scene.imports)},
+                             {NodesSection, 0, nodes.Bytes()},
+                             {WiresSection, 0, wires.Bytes()}});
+}
+} // namespace Logicarium
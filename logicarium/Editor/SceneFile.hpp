@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Logicarium {
+// A scene in the BPS3 file format. Every string (gate types, node ids, slot
+// names) is stored once, in a string table, and referred to by index; nodes
+// and wires are packed fixed-size records. Loading a scene is one read of the
+// file and one pass over each array.
+//
+// Layout, all integers little-endian:
+//
+//   "BPS3", u32 section count
+//   Section table, per section: u32 id, u32 CRC-32 of its bytes, u64 offset
+//     from the start of the file, u64 size
+//   Sections, in any order; readers skip ids they don't know:
+//     "STRS"  u32 count, u32 end of each string relative to the text that
+//             follows the ends, then the strings, each followed by a 0 byte
+//     "DEPS"  u32 count, then a u32 string per custom gate type used
+//     "IMPT"  u32 count, then a u32 string per library the script imports,
+//             its path relative to the scene file's directory. Optional.
+//     "NODE"  u32 count, then per node: u32 type, u32 id, f32 x, f32 y,
+//             i32 input count, i32 output count, u32 flags
+//     "WIRE"  u32 count, then per wire: u32 output node, u32 output slot,
+//             u32 input node, u32 input slot. Nodes are indices into NODE,
+//             slots are slot names.
+//
+// BPS1 and BPS2, which came before, are read by NodeEditor::LoadScene.
+struct SceneFile {
+  static constexpr uint32_t Momentary = 1; // Node flag: an In that's a button
+
+  struct Node {
+    uint32_t type = 0, id = 0;
+    float x = 0, y = 0;
+    int32_t inputs = 0, outputs = 0;
+    uint32_t flags = 0;
+  };
+  struct Wire {
+    uint32_t outputNode = 0, outputSlot = 0;
+    uint32_t inputNode = 0, inputSlot = 0;
+  };
+
+  // After ParseSceneFile these view into bytes, each followed by a 0, so
+  // data() works as a C string. Parse into the SceneFile that is used; a
+  // moved one may leave its strings dangling.
+  std::vector<std::string_view> strings;
+  std::vector<uint32_t> dependencies;
+  std::vector<uint32_t> imports;
+  std::vector<Node> nodes;
+  std::vector<Wire> wires;
+  std::string bytes;
+};
+
+// Whether bytes start like a BPS3 file
+bool IsSceneFile(std::string_view bytes);
+// Takes the contents of a file. False if they are not a BPS3 scene, are
+// truncated, fail a section's CRC or refer to a string or node that isn't
+// there.
+bool ParseSceneFile(std::string bytes, SceneFile &scene);
+bool WriteSceneFile(const std::string &path, const SceneFile &scene);
+} // namespace Logicarium
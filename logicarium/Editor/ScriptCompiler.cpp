@@ -0,0 +1,1540 @@
+#include "ScriptCompiler.hpp"
+#include "../Nodes/Gates/WordGate.hpp"
+#include "BinaryIO.hpp"
+#include "Profiler.hpp"
+#include "Repaint.hpp"
+#include "ScriptLibrary.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <deque>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Logicarium {
+// Drops nodes nothing reaches the outputs through: intermediate signals that
+// were never used, and gates folding made redundant. Input pins stay, since
+// they are the gate's interface.
+static void RemoveDeadNodes(GateDefinition &def) {
+  std::unordered_map<int, std::vector<int>> drivers; // Node -> nodes feeding it
+  for (const ConnectionDefinition &conn : def.connections)
+    drivers[conn.inputNodeId].push_back(conn.outputNodeId);
+
+  std::unordered_set<int> live(def.inputPinIndices.begin(),
+                               def.inputPinIndices.end());
+  live.insert(def.outputPinIndices.begin(), def.outputPinIndices.end());
+  std::vector<int> stack(def.outputPinIndices.begin(),
+                         def.outputPinIndices.end());
+  while (!stack.empty()) {
+    auto it = drivers.find(stack.back());
+    stack.pop_back();
+    if (it == drivers.end())
+      continue;
+    for (int driver : it->second)
+      if (live.insert(driver).second)
+        stack.push_back(driver);
+  }
+
+  auto dead = [&](int id) { return !live.count(id); };
+  def.nodes.erase(std::remove_if(def.nodes.begin(), def.nodes.end(),
+                                 [&](const NodeDefinition &node) {
+                                   return dead(node.id);
+                                 }),
+                  def.nodes.end());
+  def.connections.erase(
+      std::remove_if(def.connections.begin(), def.connections.end(),
+                     [&](const ConnectionDefinition &conn) {
+                       return dead(conn.inputNodeId) ||
+                              dead(conn.outputNodeId);
+                     }),
+      def.connections.end());
+}
+
+// A gate's pins grouped back into the ports they were declared as: bus bits
+// x[0], x[1], ... in a row are one port. Pins without names get the default
+// ones, "in" or in0, in1, ...
+struct PinGroup {
+  std::string name;
+  std::vector<std::string> pins; // Each bit's slot, least significant first
+};
+
+static std::vector<PinGroup> GroupPins(const std::vector<std::string> &names,
+                                       size_t count, const char *fallback) {
+  std::vector<PinGroup> groups;
+  for (size_t i = 0; i < count;) {
+    PinGroup group;
+    std::string_view base;
+    int bit;
+    if (i < names.size() && SplitBusPin(names[i], base, bit) && bit == 0) {
+      group.name = std::string(base);
+      do
+        group.pins.push_back(names[i++]);
+      while (i < count && i < names.size() &&
+             names[i] == BusPinName(base, (int)group.pins.size()));
+    } else {
+      if (i < names.size())
+        group.name = names[i];
+      else
+        group.name = count == 1 ? fallback : fallback + std::to_string(i);
+      group.pins.push_back(group.name);
+      ++i;
+    }
+    groups.push_back(std::move(group));
+  }
+  return groups;
+}
+
+// Values of the parameters and loop variables in scope, innermost last
+using Bindings = std::vector<std::pair<std::string_view, int>>;
+
+// Evaluates the integer expressions of a define (ScriptIndex) by recursive
+// descent over their text:
+//   expr   = term {("+" | "-") term}
+//   term   = factor {("*" | "/" | "%") factor}
+//   factor = number | name | "-" factor | "(" expr ")"
+class IndexEvaluator {
+public:
+  IndexEvaluator(std::string_view text, const Bindings &bindings)
+      : text(text), bindings(bindings) {}
+
+  bool Evaluate(int &value, std::string &message) {
+    long long result = 0;
+    if (Expr(result, 0)) {
+      SkipSpace();
+      if (pos == text.size()) {
+        value = (int)result;
+        return true;
+      }
+      Fail("Unexpected '" + std::string(1, text[pos]) + "'");
+    }
+    message = std::move(error);
+    return false;
+  }
+
+private:
+  // Far enough from overflow that one more * or + can be checked after
+  static constexpr long long Limit = 1 << 30;
+  static constexpr int MaxDepth = 64;
+
+  std::string_view text;
+  const Bindings &bindings;
+  size_t pos = 0;
+  std::string error;
+
+  bool Fail(std::string message) {
+    if (error.empty())
+      error = std::move(message);
+    return false;
+  }
+
+  void SkipSpace() {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+      ++pos;
+  }
+
+  bool Take(char c) {
+    SkipSpace();
+    if (pos < text.size() && text[pos] == c) {
+      ++pos;
+      return true;
+    }
+    return false;
+  }
+
+  bool InRange(long long value) {
+    return value > -Limit && value < Limit ? true : Fail("Number too large");
+  }
+
+  bool Expr(long long &value, int depth) {
+    if (!Term(value, depth))
+      return false;
+    for (;;) {
+      bool add = Take('+');
+      if (!add && !Take('-'))
+        return true;
+      long long right;
+      if (!Term(right, depth))
+        return false;
+      value = add ? value + right : value - right;
+      if (!InRange(value))
+        return false;
+    }
+  }
+
+  bool Term(long long &value, int depth) {
+    if (!Factor(value, depth))
+      return false;
+    for (;;) {
+      char op = Take('*') ? '*' : Take('/') ? '/' : Take('%') ? '%' : 0;
+      if (!op)
+        return true;
+      long long right;
+      if (!Factor(right, depth))
+        return false;
+      if (op != '*' && right == 0)
+        return Fail("Division by zero");
+      value = op == '*' ? value * right : op == '/' ? value / right
+                                                    : value % right;
+      if (!InRange(value))
+        return false;
+    }
+  }
+
+  bool Factor(long long &value, int depth) {
+    if (depth >= MaxDepth)
+      return Fail("Expression nested too deeply");
+    if (Take('-')) {
+      if (!Factor(value, depth + 1))
+        return false;
+      value = -value;
+      return true;
+    }
+    if (Take('('))
+      return Expr(value, depth + 1) && (Take(')') || Fail("Expected ')'"));
+
+    SkipSpace();
+    size_t start = pos;
+    while (pos < text.size() && (isalnum((unsigned char)text[pos]) ||
+                                 text[pos] == '_'))
+      ++pos;
+    std::string_view word = text.substr(start, pos - start);
+    if (word.empty())
+      return Fail(pos < text.size()
+                      ? "Unexpected '" + std::string(1, text[pos]) + "'"
+                      : "Expected a number");
+    if (isdigit((unsigned char)word[0])) {
+      auto result =
+          std::from_chars(word.data(), word.data() + word.size(), value);
+      if (result.ec != std::errc() || !InRange(value))
+        return Fail("Number too large");
+      if (result.ptr != word.data() + word.size())
+        return Fail("Bad number '" + std::string(word) + "'");
+      return true;
+    }
+    for (auto it = bindings.rbegin(); it != bindings.rend(); ++it) {
+      if (it->first == word) {
+        value = it->second;
+        return true;
+      }
+    }
+    return Fail("Unknown parameter: " + std::string(word));
+  }
+};
+
+// Widest bus a define may declare or build
+static constexpr int MaxBusWidth = 1 << 16;
+// Statements a define may run, counting every pass of its generate loops
+static constexpr int MaxGeneratedStatements = 1 << 20;
+// Template instances inside template instances
+static constexpr int MaxInstanceDepth = 64;
+
+struct Elaboration;
+static GateDefinitionRef
+LowerDefinition(const ScriptDefine &block, const std::vector<int> &params,
+                Elaboration &context,
+                std::vector<DefinitionCache::Dependency> &dependencies);
+
+// What the defines of one compile share: the registry that gate calls
+// resolve against, and the templates (defines with parameters) with their
+// instances so far. An instance is elaborated the first time its parameter
+// values are used and shared by every later use.
+struct Elaboration {
+  GateTable &registry;
+  std::vector<ScriptError> &errors;
+  std::vector<GateDefinitionRef> &definitions; // Everything lowered, in order
+  DefinitionCache *cache;                      // May be null
+  std::unordered_map<std::string_view, const ScriptDefine *> templates;
+  // Null for an instance that failed, its errors already reported
+  std::unordered_map<std::string, GateDefinitionRef> instances;
+  std::unordered_set<std::string> elaborating; // To catch a template in itself
+
+  Elaboration(GateTable &registry, std::vector<ScriptError> &errors,
+              std::vector<GateDefinitionRef> &definitions,
+              DefinitionCache *cache)
+      : registry(registry), errors(errors), definitions(definitions),
+        cache(cache) {}
+
+  GateDefinitionRef Instance(std::string_view name,
+                             const std::vector<int> &params,
+                             const SourceSpan &span) {
+    std::string type = InstanceName(name, params);
+    auto cached = instances.find(type);
+    if (cached != instances.end())
+      return cached->second;
+
+    auto error = [&](std::string message) {
+      errors.push_back({span, std::move(message)});
+      return nullptr;
+    };
+    auto it = templates.find(name);
+    if (it == templates.end())
+      return error(registry.Find(name)
+                       ? std::string(name) + " takes no parameters"
+                       : "Unknown gate type: " + std::string(name));
+    const ScriptDefine &block = *it->second;
+    if (params.size() != block.params.size())
+      return error(std::string(name) + " takes " +
+                   std::to_string(block.params.size()) + " parameters, not " +
+                   std::to_string(params.size()));
+    if (elaborating.count(type))
+      return error(type + " contains itself");
+    if (elaborating.size() >= MaxInstanceDepth)
+      return error("Instances nested too deeply at " + type);
+
+    elaborating.insert(type);
+    GateDefinitionRef def = Lower(block, params);
+    elaborating.erase(type);
+    if (def) {
+      registry.Register(def);
+      definitions.push_back(def);
+    }
+    return instances[type] = def;
+  }
+
+  // Lowers block with params, or takes what an earlier compile lowered from
+  // the same text if everything it depended on still resolves the same
+  GateDefinitionRef Lower(const ScriptDefine &block,
+                          const std::vector<int> &params) {
+    std::string key;
+    DefinitionCache::Entry entry;
+    if (cache) {
+      key = DefinitionCache::Normalize(block.text);
+      if (!block.params.empty())
+        key += InstanceName("", params);
+      if (cache->Find(key, entry) && Current(entry.dependencies, block.span))
+        return entry.definition;
+      entry.dependencies.clear();
+    }
+
+    GateDefinitionRef def =
+        LowerDefinition(block, params, *this, entry.dependencies);
+    if (cache && def) {
+      entry.definition = def;
+      cache->Store(key, std::move(entry));
+    }
+    return def;
+  }
+
+  bool Current(const std::vector<DefinitionCache::Dependency> &dependencies,
+               const SourceSpan &span) {
+    for (const DefinitionCache::Dependency &dependency : dependencies) {
+      GateDefinitionRef now;
+      if (dependency.params.empty()) {
+        now = registry.Find(dependency.name);
+      } else {
+        // Elaborating the instance now, if it still can be, is no waste:
+        // the block would need it anyway
+        auto it = templates.find(dependency.name);
+        if (it == templates.end() ||
+            it->second->params.size() != dependency.params.size())
+          return false;
+        now = Instance(dependency.name, dependency.params, span);
+      }
+      if (now != dependency.definition)
+        return false;
+    }
+    return true;
+  }
+};
+
+// Whether instances of def are pure functions of their inputs: no feedback
+// loop in it or in any gate it uses, so two instances fed the same signals
+// always agree. A latch or flip-flop keeps state of its own and isn't. Types
+// lookup can't find count as stateful. known memoizes by definition.
+static bool IsCombinational(
+    const GateDefinition &def,
+    const std::function<GateDefinitionRef(std::string_view)> &lookup,
+    std::unordered_map<const GateDefinition *, bool> &known) {
+  auto [entry, added] = known.try_emplace(&def, false);
+  if (!added)
+    return entry->second; // Also ends recursion through def itself as false
+
+  std::unordered_map<int, size_t> index;
+  for (size_t i = 0; i < def.nodes.size(); ++i) {
+    const std::string &type = def.nodes[i].type;
+    index[def.nodes[i].id] = i;
+    WordGate::Op op;
+    int width;
+    if (type == "AND" || type == "NOT" || type == "In" || type == "Out" ||
+        WordGate::ParseTypeName(type, op, width))
+      continue;
+    GateDefinitionRef inner = lookup(type);
+    if (!inner || !IsCombinational(*inner, lookup, known))
+      return false;
+  }
+
+  // Any cycle through the wiring is feedback
+  std::vector<std::vector<size_t>> fanout(def.nodes.size());
+  for (const ConnectionDefinition &conn : def.connections) {
+    auto from = index.find(conn.outputNodeId);
+    auto to = index.find(conn.inputNodeId);
+    if (from != index.end() && to != index.end())
+      fanout[from->second].push_back(to->second);
+  }
+  enum { Unvisited, OnPath, Done };
+  std::vector<char> state(def.nodes.size(), Unvisited);
+  std::vector<std::pair<size_t, size_t>> stack; // Node, next fanout entry
+  for (size_t root = 0; root < def.nodes.size(); ++root) {
+    if (state[root] != Unvisited)
+      continue;
+    state[root] = OnPath;
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+      auto &[node, next] = stack.back();
+      if (next == fanout[node].size()) {
+        state[node] = Done;
+        stack.pop_back();
+        continue;
+      }
+      size_t to = fanout[node][next++];
+      if (state[to] == OnPath)
+        return false;
+      if (state[to] == Unvisited) {
+        state[to] = OnPath;
+        stack.push_back({to, 0});
+      }
+    }
+  }
+  return known[&def] = true;
+}
+
+// Builds the custom gate a parsed define block describes, with params as the
+// values of a template's parameters, resolving gate calls against the
+// registry. Unknown names are reported at their position; the result is null
+// unless the whole block resolved. Every gate resolved is added to
+// dependencies.
+static GateDefinitionRef
+LowerDefinition(const ScriptDefine &block, const std::vector<int> &params,
+                Elaboration &context,
+                std::vector<DefinitionCache::Dependency> &dependencies) {
+  const GateTable &registry = context.registry;
+  auto depend = [&](std::string_view name, const std::vector<int> &values,
+                    const GateDefinitionRef &definition) {
+    for (const DefinitionCache::Dependency &dependency : dependencies)
+      if (dependency.name == name && dependency.params == values)
+        return;
+    dependencies.push_back({std::string(name), values, definition});
+  };
+  // Registry lookup that records the result as a dependency
+  auto resolve = [&](std::string_view name) {
+    GateDefinitionRef found = registry.Find(name);
+    depend(name, {}, found);
+    return found;
+  };
+  GateDefinition def;
+  def.name = block.params.empty() ? std::string(block.name)
+                                  : InstanceName(block.name, params);
+  def.color = IM_COL32(60, 80, 120, 200); // Default blue-ish color
+
+  // Signal tracking: maps signal name to (nodeId, outputSlotName)
+  // Allows accessing multi-output gates via signal.outputName
+  struct Signal {
+    int nodeId;
+    std::string slot; // output slot name
+  };
+  // A signal's bits, least significant first; a plain signal is one bit.
+  // Empty marks a failed expression.
+  using Bus = std::vector<Signal>;
+  std::unordered_map<std::string_view, Bus> signals;
+  int nodeIdCounter = 0;
+  float yPos = 0;
+  bool ok = true;
+
+  // Errors in an instance say which one, since each instance can fail in
+  // its own way
+  std::string where =
+      block.params.empty() ? std::string() : " (in " + def.name + ")";
+  auto error = [&](const SourceSpan &span, std::string message) {
+    context.errors.push_back({span, std::move(message) + where});
+    ok = false;
+  };
+
+  Bindings bindings;
+  for (size_t i = 0; i < block.params.size() && i < params.size(); ++i)
+    bindings.emplace_back(block.params[i], params[i]);
+  auto evaluate = [&](const ScriptIndex &index, int &value) {
+    std::string message;
+    if (IndexEvaluator(index.text, bindings).Evaluate(value, message))
+      return true;
+    error(index.span, message);
+    return false;
+  };
+  // Width of a port: 0 for a single signal, else from [width] or [msb:0]
+  auto portWidth = [&](const ScriptPort &port, int &width) {
+    width = 0;
+    if (port.hi.text.empty())
+      return true;
+    if (!evaluate(port.hi, width))
+      return false;
+    if (!port.lo.text.empty()) {
+      int lo;
+      if (!evaluate(port.lo, lo))
+        return false;
+      if (lo != 0) {
+        error(port.lo.span, "Bus must be declared as [msb:0]");
+        return false;
+      }
+      ++width;
+    }
+    if (width < 1 || width > MaxBusWidth) {
+      error(port.hi.span, "Bus width must be between 1 and " +
+                              std::to_string(MaxBusWidth));
+      return false;
+    }
+    return true;
+  };
+
+  // Create PinIn nodes for each input, one per bit of a bus. Pin names are
+  // the parameter names (a, b, etc.), or a[0], a[1], ... for a bus
+  for (const ScriptPort &input : block.inputs) {
+    int width;
+    if (!portWidth(input, width))
+      continue;
+    Bus &bus = signals[input.name];
+    for (int bit = 0; bit < std::max(width, 1); ++bit) {
+      NodeDefinition nd;
+      nd.type = "In";
+      nd.id = nodeIdCounter;
+      nd.pos = ImVec2(0, yPos);
+      yPos += 60;
+      def.nodes.push_back(nd);
+      def.inputPinIndices.push_back(nodeIdCounter);
+      def.inputPinNames.push_back(width ? BusPinName(input.name, bit)
+                                        : std::string(input.name));
+      bus.push_back({nodeIdCounter, "out"});
+      nodeIdCounter++;
+    }
+  }
+
+  // Helper lambdas for creating nodes and connections
+  auto createNode = [&](const std::string &type, float x, float y) -> int {
+    NodeDefinition nd;
+    nd.type = type;
+    nd.id = nodeIdCounter;
+    nd.pos = ImVec2(x, y);
+    def.nodes.push_back(nd);
+    return nodeIdCounter++;
+  };
+
+  auto connect = [&](int fromNode, const std::string &fromSlot, int toNode,
+                     const std::string &toSlot) {
+    ConnectionDefinition cd;
+    cd.outputNodeId = fromNode;
+    cd.outputSlot = fromSlot;
+    cd.inputNodeId = toNode;
+    cd.inputSlot = toSlot;
+    def.connections.push_back(cd);
+  };
+
+  // Process each assignment to create gate nodes
+  float gateX = 150;
+  float gateY = 0;
+
+  // Gates are hash-consed: one with the same type and operands as an earlier
+  // one is that gate, so repeated subexpressions are built once. Keys are the
+  // type followed by the operands' (node, slot) pairs.
+  std::unordered_map<std::string, int> built;
+  auto appendKey = [](std::string &k, const Signal &arg) {
+    k.append("|").append(std::to_string(arg.nodeId)).append(".").append(
+        arg.slot);
+  };
+  auto key = [&](const char *type,
+                 std::initializer_list<const Signal *> args) {
+    std::string k = type;
+    for (const Signal *arg : args)
+      appendKey(k, *arg);
+    return k;
+  };
+  // What each NOT gate inverts, so NOT NOT x folds back to x; for a word NOT
+  // gate, the bus it inverts
+  std::unordered_map<int, Signal> inverted;
+  std::unordered_map<int, Bus> invertedWords;
+
+  // Literal 0 is an In that is never driven; 1 is NOT of it. Both are
+  // created on first use.
+  int constLowId = -1;
+  int constHighId = -1;
+  auto constant = [&](bool value) -> Signal {
+    if (constLowId < 0) {
+      NodeDefinition nd;
+      nd.type = "In";
+      nd.id = nodeIdCounter;
+      nd.pos = ImVec2(-100, 0);
+      def.nodes.push_back(nd);
+      constLowId = nodeIdCounter++;
+    }
+    if (!value)
+      return {constLowId, "out"};
+    if (constHighId < 0) {
+      constHighId = createNode("NOT", -50, 0);
+      connect(constLowId, "out", constHighId, "in");
+      inverted[constHighId] = {constLowId, "out"};
+    }
+    return {constHighId, "out"};
+  };
+  // Value of s if it is one of the constants
+  auto constantValue = [&](const Signal &s) -> int {
+    if (s.nodeId >= 0 && s.nodeId == constLowId)
+      return 0;
+    if (s.nodeId >= 0 && s.nodeId == constHighId)
+      return 1;
+    return -1;
+  };
+  // The signal s inverts, if it is the output of a NOT
+  auto inverse = [&](const Signal &s) -> const Signal * {
+    auto it = inverted.find(s.nodeId);
+    return it != inverted.end() && s.slot == "out" ? &it->second : nullptr;
+  };
+  auto same = [](const Signal &a, const Signal &b) {
+    return a.nodeId == b.nodeId && a.slot == b.slot;
+  };
+  auto sameBus = [&](const Bus &a, const Bus &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), same);
+  };
+  auto less = [](const Signal &a, const Signal &b) {
+    return std::tie(a.nodeId, a.slot) < std::tie(b.nodeId, b.slot);
+  };
+
+  auto makeNot = [&](const Signal &in) -> Signal {
+    int value = constantValue(in);
+    if (value >= 0)
+      return constant(!value);
+    if (const Signal *original = inverse(in))
+      return *original;
+    int &gate = built.try_emplace(key("NOT", {&in}), -1).first->second;
+    if (gate < 0) {
+      gate = createNode("NOT", gateX, gateY);
+      gateY += 50;
+      connect(in.nodeId, in.slot, gate, "in");
+      inverted[gate] = in;
+    }
+    return {gate, "out"};
+  };
+
+  auto makeAnd = [&](Signal left, Signal right) -> Signal {
+    int l = constantValue(left), r = constantValue(right);
+    if (l == 0 || r == 0)
+      return constant(false);
+    if (l == 1)
+      return right;
+    if (r == 1)
+      return left;
+    if (same(left, right))
+      return left;
+    const Signal *notLeft = inverse(left), *notRight = inverse(right);
+    if ((notLeft && same(*notLeft, right)) ||
+        (notRight && same(*notRight, left)))
+      return constant(false);
+    // AND is commutative; order the operands so a AND b and b AND a match
+    if (less(right, left))
+      std::swap(left, right);
+    int &gate =
+        built.try_emplace(key("AND", {&left, &right}), -1).first->second;
+    if (gate < 0) {
+      gate = createNode("AND", gateX, gateY);
+      gateY += 50;
+      connect(left.nodeId, left.slot, gate, "in0");
+      connect(right.nodeId, right.slot, gate, "in1");
+    }
+    return {gate, "out"};
+  };
+
+  // Instance of a custom gate fed by args, one bus per input port; the
+  // result is its first output port. A combinational gate is a function of
+  // its inputs, so two instances with the same inputs always agree and one
+  // is enough. A gate with state of its own gets an instance per call.
+  std::unordered_map<const GateDefinition *, bool> combinational;
+  auto makeCall = [&](const std::string &type, const GateDefinition &gateDef,
+                      const std::vector<const Bus *> &args) -> Bus {
+    int unshared = -1;
+    int *slot = &unshared;
+    if (IsCombinational(gateDef, resolve, combinational)) {
+      std::string callKey = type;
+      for (const Bus *arg : args)
+        for (const Signal &bit : *arg)
+          appendKey(callKey, bit);
+      slot = &built.try_emplace(callKey, -1).first->second;
+    }
+    int &gate = *slot;
+    if (gate < 0) {
+      gate = createNode(type, gateX, gateY);
+      gateY += 60;
+      std::vector<PinGroup> inputs = GroupPins(
+          gateDef.inputPinNames, gateDef.inputPinIndices.size(), "in");
+      for (size_t i = 0; i < args.size() && i < inputs.size(); ++i)
+        for (size_t bit = 0;
+             bit < args[i]->size() && bit < inputs[i].pins.size(); ++bit)
+          connect((*args[i])[bit].nodeId, (*args[i])[bit].slot, gate,
+                  inputs[i].pins[bit]);
+    }
+
+    std::vector<PinGroup> outputs = GroupPins(
+        gateDef.outputPinNames, gateDef.outputPinIndices.size(), "out");
+    Bus result;
+    if (!outputs.empty())
+      for (const std::string &pin : outputs[0].pins)
+        result.push_back({gate, pin});
+    return result;
+  };
+
+  auto makeOr = [&](const Signal &left, const Signal &right) -> Signal {
+    // Check if OR is defined as custom gate
+    if (GateDefinitionRef orDef = resolve("OR")) {
+      Bus l{left}, r{right};
+      Bus result = makeCall("OR", *orDef, {&l, &r});
+      if (!result.empty())
+        return result[0];
+    }
+    // Build OR from NOT and AND: OR(a,b) = NOT(NOT a AND NOT b)
+    return makeNot(makeAnd(makeNot(left), makeNot(right)));
+  };
+
+  // Word gates for an operator over whole buses, one per 64 bits; any bit
+  // left over on its own gets a scalar gate
+  auto makeWord = [&](WordGate::Op op, const Bus &a, const Bus *b) -> Bus {
+    Bus out;
+    for (size_t first = 0; first < a.size(); first += WordGate::MaxWidth) {
+      int width = (int)std::min(a.size() - first, (size_t)WordGate::MaxWidth);
+      if (width == 1) {
+        const Signal &x = a[first];
+        out.push_back(op == WordGate::Op::Not ? makeNot(x)
+                      : op == WordGate::Op::And ? makeAnd(x, (*b)[first])
+                                                : makeOr(x, (*b)[first]));
+        continue;
+      }
+      std::string type = WordGate::TypeName(op, width);
+      std::string k = type;
+      for (int i = 0; i < width; ++i)
+        appendKey(k, a[first + i]);
+      for (int i = 0; b && i < width; ++i)
+        appendKey(k, (*b)[first + i]);
+      int &gate = built.try_emplace(k, -1).first->second;
+      if (gate < 0) {
+        gate = createNode(type, gateX, gateY);
+        gateY += 40 + 20 * width;
+        for (int i = 0; i < width; ++i) {
+          connect(a[first + i].nodeId, a[first + i].slot, gate,
+                  BusPinName("a", i));
+          if (b)
+            connect((*b)[first + i].nodeId, (*b)[first + i].slot, gate,
+                    BusPinName("b", i));
+        }
+        if (op == WordGate::Op::Not)
+          invertedWords[gate] =
+              Bus(a.begin() + first, a.begin() + first + width);
+      }
+      for (int i = 0; i < width; ++i)
+        out.push_back({gate, BusPinName("out", i)});
+    }
+    return out;
+  };
+
+  auto allConstant = [&](const Bus &bus) {
+    return std::all_of(bus.begin(), bus.end(), [&](const Signal &s) {
+      return constantValue(s) >= 0;
+    });
+  };
+
+  auto makeNotBus = [&](const Bus &in) -> Bus {
+    if (in.size() == 1 || allConstant(in)) {
+      Bus out;
+      for (const Signal &bit : in)
+        out.push_back(makeNot(bit));
+      return out;
+    }
+    // All of a word NOT's outputs in order are the bus it inverts
+    auto it = invertedWords.find(in[0].nodeId);
+    if (it != invertedWords.end() && in.size() == it->second.size()) {
+      bool whole = true;
+      for (size_t i = 0; i < in.size() && whole; ++i)
+        whole = same(in[i], {it->first, BusPinName("out", (int)i)});
+      if (whole)
+        return it->second;
+    }
+    return makeWord(WordGate::Op::Not, in, nullptr);
+  };
+
+  // AND or OR of two buses of the same width, or of a bus and a constant bit
+  auto makeBinaryBus = [&](WordGate::Op op, Bus left, Bus right,
+                           const SourceSpan &span) -> Bus {
+    bool isAnd = op == WordGate::Op::And;
+    if (left.size() == 1 && right.size() > 1)
+      std::swap(left, right);
+    if (right.size() == 1 && left.size() > 1) {
+      int value = constantValue(right[0]);
+      if (value < 0) {
+        error(span, "A single bit can only be combined with a bus if it is "
+                    "0 or 1");
+        return {};
+      }
+      // x AND 1 and x OR 0 are x; x AND 0 and x OR 1 are constant
+      if (value == (isAnd ? 1 : 0))
+        return left;
+      return Bus(left.size(), constant(value));
+    }
+    if (left.size() != right.size()) {
+      error(span, "Width mismatch: " + std::to_string(left.size()) +
+                      " bits " + (isAnd ? "AND " : "OR ") +
+                      std::to_string(right.size()) + " bits");
+      return {};
+    }
+    if (left.size() == 1)
+      return {isAnd ? makeAnd(left[0], right[0]) : makeOr(left[0], right[0])};
+    if (sameBus(left, right))
+      return left;
+    // Both are commutative; order the operands so a AND b and b AND a match
+    if (std::lexicographical_compare(right.begin(), right.end(), left.begin(),
+                                     left.end(), less))
+      std::swap(left, right);
+    return makeWord(op, left, &right);
+  };
+
+  // A bit of a bus that was never assigned, as in carry[3] before the loop
+  // pass that sets it; a bus holding one is only usable through a slice
+  // that avoids it
+  auto firstHole = [](const Bus &bus) -> int {
+    for (size_t bit = 0; bit < bus.size(); ++bit)
+      if (bus[bit].nodeId < 0)
+        return (int)bit;
+    return -1;
+  };
+  auto holeError = [&](const ScriptExpr &expr, int bit) {
+    error(expr.span, std::string(expr.name) + "[" + std::to_string(bit) +
+                         "] is used before it is assigned");
+  };
+  // Bits [hi:lo], or [hi] if lo is empty, of a width-bit bus
+  auto bitRange = [&](const ScriptIndex &hi, const ScriptIndex &lo, int width,
+                      int &low, int &high) {
+    if (!evaluate(hi, high))
+      return false;
+    low = high;
+    if (!lo.text.empty() && !evaluate(lo, low))
+      return false;
+    if (low < 0 || high < low) {
+      error(hi.span, "Bit range must run from high bit down to low");
+      return false;
+    }
+    if (high >= width) {
+      error(hi.span, "Bit " + std::to_string(high) +
+                         " is out of range for a " + std::to_string(width) +
+                         "-bit signal");
+      return false;
+    }
+    return true;
+  };
+
+  // Each assignment's expressions come after the previous one's, operands
+  // before the expressions using them, so evaluating an assignment's range
+  // of them in index order builds every operand first. A loop evaluates the
+  // range once per pass. An empty bus marks a failed expression; whatever
+  // uses it fails silently, the cause already reported.
+  std::vector<Bus> results(block.exprs.size());
+  auto lower = [&](const ScriptExpr &expr) -> Bus {
+    for (int arg : expr.args) {
+      if (results[arg].empty())
+        return {};
+      // A slice may pick out the assigned part of a bus
+      int hole = expr.kind == ScriptExpr::Slice ? -1 : firstHole(results[arg]);
+      if (hole >= 0) {
+        holeError(block.exprs[arg], hole);
+        return {};
+      }
+    }
+
+    switch (expr.kind) {
+    case ScriptExpr::Literal:
+      return {constant(expr.value)};
+
+    case ScriptExpr::Signal: {
+      auto it = signals.find(expr.name);
+      if (it != signals.end())
+        return it->second;
+      error(expr.span, "Unknown signal: " + std::string(expr.name));
+      return {};
+    }
+
+    case ScriptExpr::Member: {
+      // Same node as the signal, but the named output, which may be a bus
+      auto it = signals.find(expr.name);
+      if (it == signals.end()) {
+        error(expr.span, "Unknown signal: " + std::string(expr.name));
+        return {};
+      }
+      int nodeId = it->second[0].nodeId;
+      if (nodeId < 0) {
+        holeError(expr, 0);
+        return {};
+      }
+      if (const auto &callDef = registry.Find(def.nodes[nodeId].type)) {
+        for (const PinGroup &port :
+             GroupPins(callDef->outputPinNames,
+                       callDef->outputPinIndices.size(), "out")) {
+          if (port.name != expr.member)
+            continue;
+          Bus bus;
+          for (const std::string &pin : port.pins)
+            bus.push_back({nodeId, pin});
+          return bus;
+        }
+      }
+      return {{nodeId, std::string(expr.member)}};
+    }
+
+    case ScriptExpr::Not:
+      return makeNotBus(results[expr.args[0]]);
+
+    case ScriptExpr::And:
+      return makeBinaryBus(WordGate::Op::And, results[expr.args[0]],
+                           results[expr.args[1]], expr.span);
+
+    case ScriptExpr::Or:
+      return makeBinaryBus(WordGate::Op::Or, results[expr.args[0]],
+                           results[expr.args[1]], expr.span);
+
+    case ScriptExpr::Slice: {
+      const Bus &bus = results[expr.args[0]];
+      int lo, hi;
+      if (!bitRange(expr.hi, expr.lo, (int)bus.size(), lo, hi))
+        return {};
+      Bus slice(bus.begin() + lo, bus.begin() + hi + 1);
+      int hole = firstHole(slice);
+      if (hole >= 0) {
+        holeError(block.exprs[expr.args[0]], lo + hole);
+        return {};
+      }
+      return slice;
+    }
+
+    case ScriptExpr::Concat: {
+      // Written most significant first; buses are stored the other way
+      Bus bus;
+      for (auto arg = expr.args.rbegin(); arg != expr.args.rend(); ++arg)
+        bus.insert(bus.end(), results[*arg].begin(), results[*arg].end());
+      if ((int)bus.size() > MaxBusWidth) {
+        error(expr.span, "Bus wider than " + std::to_string(MaxBusWidth) +
+                             " bits");
+        return {};
+      }
+      return bus;
+    }
+
+    case ScriptExpr::Call: {
+      GateDefinitionRef callDef;
+      if (!expr.params.empty()) {
+        std::vector<int> values(expr.params.size());
+        for (size_t i = 0; i < values.size(); ++i)
+          if (!evaluate(expr.params[i], values[i]))
+            return {};
+        callDef = context.Instance(expr.name, values, expr.span);
+        if (!callDef) {
+          ok = false;
+          return {};
+        }
+        depend(expr.name, values, callDef);
+      } else if (!(callDef = resolve(expr.name))) {
+        error(expr.span, context.templates.count(expr.name)
+                             ? std::string(expr.name) + " needs parameters"
+                             : "Unknown gate type: " + std::string(expr.name));
+        return {};
+      }
+      std::vector<PinGroup> inputs = GroupPins(
+          callDef->inputPinNames, callDef->inputPinIndices.size(), "in");
+      std::vector<const Bus *> args;
+      for (size_t i = 0; i < expr.args.size(); ++i) {
+        const Bus &arg = results[expr.args[i]];
+        if (i < inputs.size() && arg.size() != inputs[i].pins.size()) {
+          error(block.exprs[expr.args[i]].span,
+                "Input " + inputs[i].name + " of " + callDef->name + " is " +
+                    std::to_string(inputs[i].pins.size()) +
+                    " bits wide, not " + std::to_string(arg.size()));
+          return {};
+        }
+        args.push_back(&arg);
+      }
+      Bus result = makeCall(callDef->name, *callDef, args);
+      if (result.empty())
+        error(expr.span, callDef->name + " has no outputs");
+      return result;
+    }
+    }
+    return {};
+  };
+
+  auto assign = [&](const ScriptAssignment &assignment) {
+    for (int i = assignment.firstExpr; i <= assignment.expr; ++i)
+      results[i] = lower(block.exprs[i]);
+    const Bus &value = results[assignment.expr];
+    if (value.empty())
+      return;
+    if (assignment.hi.text.empty()) {
+      int hole = firstHole(value);
+      if (hole >= 0)
+        holeError(block.exprs[assignment.expr], hole);
+      else
+        signals[assignment.target] = value;
+      return;
+    }
+
+    // Setting bits of a bus, which grows to fit
+    int lo, hi;
+    if (!bitRange(assignment.hi, assignment.lo, MaxBusWidth, lo, hi))
+      return;
+    if ((int)value.size() != hi - lo + 1) {
+      error(assignment.span, std::to_string(value.size()) +
+                                 "-bit value assigned to " +
+                                 std::to_string(hi - lo + 1) + " bits");
+      return;
+    }
+    Bus &bus = signals[assignment.target];
+    if ((int)bus.size() <= hi)
+      bus.resize(hi + 1, {-1, ""});
+    std::copy(value.begin(), value.end(), bus.begin() + lo);
+  };
+
+  // Runs statements [first, end), repeating loop bodies once per value of
+  // their variable
+  int generated = 0;
+  std::function<void(int, int)> run = [&](int first, int end) {
+    for (int i = first; i < end;) {
+      const ScriptStatement &statement = block.statements[i];
+      if (statement.kind == ScriptStatement::Assign) {
+        if (++generated > MaxGeneratedStatements) {
+          if (generated == MaxGeneratedStatements + 1)
+            error(statement.span, "Define generates more than " +
+                                      std::to_string(MaxGeneratedStatements) +
+                                      " statements");
+          return;
+        }
+        assign(statement.assignment);
+        ++i;
+        continue;
+      }
+      // A pass that fails stops the loop rather than failing once per pass
+      int from, to;
+      size_t errorCount = context.errors.size();
+      if (evaluate(statement.from, from) && evaluate(statement.to, to)) {
+        bindings.emplace_back(statement.var, 0);
+        for (int value = from;
+             value < to && context.errors.size() == errorCount; ++value) {
+          bindings.back().second = value;
+          run(i + 1, statement.end);
+        }
+        bindings.pop_back();
+      }
+      i = statement.end;
+    }
+  };
+  run(0, (int)block.statements.size());
+
+  // Create PinOut nodes for each output, one per bit of a bus
+  float outX = 300;
+  float outY = 0;
+  for (const ScriptPort &output : block.outputs) {
+    int width;
+    if (!portWidth(output, width))
+      continue;
+    auto it = signals.find(output.name);
+    if (it == signals.end()) {
+      if (ok)
+        error(block.span,
+              "Output signal not defined: " + std::string(output.name));
+    } else if ((int)it->second.size() != std::max(width, 1)) {
+      error(block.span, "Output " + std::string(output.name) + " is " +
+                            std::to_string(std::max(width, 1)) +
+                            " bits wide, but its signal is " +
+                            std::to_string(it->second.size()));
+    } else if (int hole = firstHole(it->second); hole >= 0) {
+      error(block.span, "Output bit " + BusPinName(output.name, hole) +
+                            " is never assigned");
+    }
+
+    for (int bit = 0; bit < std::max(width, 1); ++bit) {
+      NodeDefinition nd;
+      nd.type = "Out";
+      nd.id = nodeIdCounter;
+      nd.pos = ImVec2(outX, outY);
+      outY += 60;
+      def.nodes.push_back(nd);
+      def.outputPinIndices.push_back(nodeIdCounter);
+      def.outputPinNames.push_back(width ? BusPinName(output.name, bit)
+                                         : std::string(output.name));
+
+      // Connect the signal to this output
+      if (ok)
+        connect(it->second[bit].nodeId, it->second[bit].slot, nodeIdCounter,
+                "in");
+      nodeIdCounter++;
+    }
+  }
+  if (!ok)
+    return nullptr;
+
+  RemoveDeadNodes(def);
+  return std::make_shared<const GateDefinition>(std::move(def));
+}
+
+void DefinitionCache::BeginCompile() {
+  std::lock_guard<std::mutex> lock(mutex);
+  compiles++;
+}
+
+template <typename Map, typename T>
+static bool FindSlot(Map &map, const std::string &key, uint64_t now,
+                     T &value) {
+  auto it = map.find(key);
+  if (it == map.end())
+    return false;
+  it->second.lastUsed = now;
+  value = it->second.value;
+  return true;
+}
+
+template <typename Map>
+static void PruneSlots(Map &map, uint64_t now, uint64_t keep) {
+  for (auto it = map.begin(); it != map.end();) {
+    if (now - it->second.lastUsed >= keep)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+}
+
+bool DefinitionCache::Find(const std::string &key, Entry &entry) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return FindSlot(slots, key, compiles, entry);
+}
+
+void DefinitionCache::Store(const std::string &key, Entry entry) {
+  std::lock_guard<std::mutex> lock(mutex);
+  slots[key] = {std::move(entry), compiles};
+}
+
+bool DefinitionCache::FindLibrary(const std::string &path, Library &library) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return FindSlot(libraries, path, compiles, library);
+}
+
+void DefinitionCache::StoreLibrary(const std::string &path, Library library) {
+  std::lock_guard<std::mutex> lock(mutex);
+  libraries[path] = {std::move(library), compiles};
+}
+
+void DefinitionCache::Prune() {
+  std::lock_guard<std::mutex> lock(mutex);
+  PruneSlots(slots, compiles, KeepCompiles);
+  PruneSlots(libraries, compiles, KeepCompiles);
+}
+
+size_t DefinitionCache::Size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return slots.size();
+}
+
+std::string DefinitionCache::Normalize(std::string_view text) {
+  // Comments dropped, each run of spacing made one space, and blank lines
+  // and the spacing around lines removed
+  std::string result;
+  result.reserve(text.size());
+  bool space = false;
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (c == '/' && i + 1 < text.size() && text[i + 1] == '/') {
+      while (i + 1 < text.size() && text[i + 1] != '\n')
+        i++;
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\r') {
+      space = true;
+      continue;
+    }
+    if (c == '\n') {
+      space = false;
+      if (!result.empty() && result.back() != '\n')
+        result += '\n';
+      continue;
+    }
+    if (space && !result.empty() && result.back() != '\n')
+      result += ' ';
+    space = false;
+    result += c;
+  }
+  return result;
+}
+
+// Makes the templates of ast available for instancing and lowers its other
+// blocks, registering each one that lowers. text, if given, gets the source
+// of both.
+static void CompileDefines(const ScriptAst &ast, Elaboration &elaboration,
+                           std::string *text) {
+  for (const ScriptDefine &block : ast.defines)
+    if (block.valid && !block.params.empty())
+      elaboration.templates[block.name] = &block;
+
+  for (const ScriptDefine &block : ast.defines) {
+    if (!block.valid)
+      continue;
+    // Templates only become gates once instantiated
+    if (!block.params.empty()) {
+      if (text)
+        text->append(block.text).append("\n\n");
+      continue;
+    }
+    if (GateDefinitionRef def = elaboration.Lower(block, {})) {
+      elaboration.registry.Register(def);
+      elaboration.definitions.push_back(std::move(def));
+      if (text)
+        text->append(block.text).append("\n\n");
+    }
+  }
+}
+
+// Identifies what a library compiles to: its text, and through their keys
+// the text of everything it imports
+static uint64_t
+LibraryKey(uint64_t sourceHash,
+           const std::vector<LibraryCacheFile::Import> &imports) {
+  ByteWriter keys;
+  for (const LibraryCacheFile::Import &import : imports)
+    keys.U64(import.key);
+  return Fnv1a(keys.Bytes(), sourceHash);
+}
+
+// Size and modification time of a file; false if it isn't one
+static bool FileStamp(const std::filesystem::path &path, uint64_t &stamp) {
+  std::error_code error;
+  if (!std::filesystem::is_regular_file(path, error))
+    return false;
+  uint64_t size = std::filesystem::file_size(path, error);
+  auto time = std::filesystem::last_write_time(path, error);
+  if (error)
+    return false;
+  stamp = Fnv1a(std::to_string(size) + ":" +
+                std::to_string(time.time_since_epoch().count()));
+  return true;
+}
+
+// Loads the libraries a compile imports, and the ones they import, into its
+// registry and templates. Each library is loaded once per compile however
+// often it is imported: from the compile cache while its file is unchanged,
+// else from its cache file while that is current, else by compiling it and
+// writing a new cache file. Imports are transitive: what a library imports
+// is visible to whatever imports it.
+class Importer {
+public:
+  explicit Importer(Elaboration &elaboration) : elaboration(elaboration) {}
+
+  // On failure error says why
+  bool Import(const std::filesystem::path &path, uint64_t &key,
+              std::string &error) {
+    std::error_code ignored;
+    std::filesystem::path resolved =
+        std::filesystem::weakly_canonical(path, ignored);
+    if (resolved.empty())
+      resolved = path;
+    std::string name = resolved.string();
+    auto done = loaded.find(name);
+    if (done != loaded.end()) {
+      key = done->second;
+      return true;
+    }
+    auto cycle = std::find(loading.begin(), loading.end(), name);
+    if (cycle != loading.end()) {
+      error = "Library imports itself: ";
+      for (; cycle != loading.end(); ++cycle)
+        error += std::filesystem::path(*cycle).filename().string() + " -> ";
+      error += resolved.filename().string();
+      return false;
+    }
+    uint64_t stamp;
+    if (!FileStamp(resolved, stamp)) {
+      error = "Cannot find library " + path.generic_string();
+      return false;
+    }
+
+    loading.push_back(name);
+    bool ok = FromMemory(name, stamp, key) ||
+              FromDisk(resolved, name, stamp, key, error);
+    loading.pop_back();
+    if (ok)
+      loaded[name] = key;
+    return ok;
+  }
+
+private:
+  // Text of a library or of its templates, with its parse; templates made
+  // available point into it
+  struct Source {
+    std::string text;
+    ScriptAst ast;
+  };
+
+  Elaboration &elaboration;
+  std::deque<Source> sources;
+  std::unordered_map<std::string, uint64_t> loaded; // Resolved path to key
+  std::vector<std::string> loading; // The chain of imports being loaded
+
+  bool FromMemory(const std::string &name, uint64_t stamp, uint64_t &key) {
+    DefinitionCache::Library library;
+    if (!elaboration.cache || !elaboration.cache->FindLibrary(name, library) ||
+        library.stamp != stamp)
+      return false;
+    for (const auto &[path, importKey] : library.imports) {
+      uint64_t current;
+      std::string ignored;
+      if (!Import(path, current, ignored) || current != importKey)
+        return false;
+    }
+    Use(library.templates, library.definitions);
+    key = library.key;
+    return true;
+  }
+
+  bool FromDisk(const std::filesystem::path &path, const std::string &name,
+                uint64_t stamp, uint64_t &key, std::string &error) {
+    std::string text;
+    if (!ReadFileBytes(path.string(), text)) {
+      error = "Cannot read library " + path.generic_string();
+      return false;
+    }
+    uint64_t sourceHash = Fnv1a(text);
+    std::filesystem::path directory = path.parent_path();
+    std::string cachePath = name + ".cache";
+
+    DefinitionCache::Library library;
+    library.stamp = stamp;
+    LibraryCacheFile file;
+    if (ReadLibraryCache(cachePath, file) && file.sourceHash == sourceHash &&
+        CurrentImports(file, directory, library)) {
+      library.templates = std::move(file.templates);
+      library.definitions = std::move(file.definitions);
+      Use(library.templates, library.definitions);
+    } else {
+      file = LibraryCacheFile();
+      file.sourceHash = sourceHash;
+      library.imports.clear();
+      if (!Compile(std::move(text), path, directory, library, file, error))
+        return false;
+      // Not being able to write it only costs the next load a compile
+      WriteLibraryCache(cachePath, file);
+    }
+
+    key = library.key = LibraryKey(sourceHash, file.imports);
+    if (elaboration.cache)
+      elaboration.cache->StoreLibrary(name, std::move(library));
+    return true;
+  }
+
+  // Loads the imports a cache file lists; false if any fails or no longer
+  // has the key it had when the file was written
+  bool CurrentImports(const LibraryCacheFile &file,
+                      const std::filesystem::path &directory,
+                      DefinitionCache::Library &library) {
+    for (const LibraryCacheFile::Import &import : file.imports) {
+      std::filesystem::path path = directory / import.path;
+      uint64_t key;
+      std::string ignored;
+      if (!Import(path, key, ignored) || key != import.key)
+        return false;
+      library.imports.emplace_back(path.string(), key);
+    }
+    return true;
+  }
+
+  bool Compile(std::string text, const std::filesystem::path &path,
+               const std::filesystem::path &directory,
+               DefinitionCache::Library &library, LibraryCacheFile &file,
+               std::string &error) {
+    Source &source = sources.emplace_back();
+    source.text = std::move(text);
+    ParseScript(source.text, source.ast);
+    std::vector<ScriptError> errors = std::move(source.ast.errors);
+
+    for (const ScriptImport &import : source.ast.imports) {
+      std::filesystem::path importPath =
+          directory / std::string(import.path);
+      uint64_t key;
+      std::string importError;
+      if (!Import(importPath, key, importError)) {
+        errors.push_back({import.span, std::move(importError)});
+        continue;
+      }
+      file.imports.push_back({std::string(import.path), key});
+      library.imports.emplace_back(importPath.string(), key);
+    }
+
+    // The library's errors are its own, not the importing script's
+    size_t first = elaboration.definitions.size();
+    std::swap(errors, elaboration.errors);
+    CompileDefines(source.ast, elaboration, nullptr);
+    std::swap(errors, elaboration.errors);
+    if (!errors.empty()) {
+      std::stable_sort(errors.begin(), errors.end(),
+                       [](const ScriptError &a, const ScriptError &b) {
+                         return a.span.offset < b.span.offset;
+                       });
+      error = "In " + path.filename().string() + ": " +
+              FormatScriptError(errors[0]);
+      if (errors.size() > 1)
+        error += " (and " + std::to_string(errors.size() - 1) + " more)";
+      return false;
+    }
+
+    for (const ScriptDefine &block : source.ast.defines)
+      if (!block.params.empty())
+        library.templates.append(block.text).append("\n");
+    // Includes instances its blocks used, which other libraries may not
+    // have elaborated by the time this one is next loaded
+    library.definitions.assign(elaboration.definitions.begin() + first,
+                               elaboration.definitions.end());
+    file.templates = library.templates;
+    file.definitions = library.definitions;
+    return true;
+  }
+
+  // Makes a loaded library's templates and definitions available
+  void Use(const std::string &templates,
+           const std::vector<GateDefinitionRef> &definitions) {
+    if (!templates.empty()) {
+      Source &source = sources.emplace_back();
+      source.text = templates;
+      ParseScript(source.text, source.ast);
+      for (const ScriptDefine &block : source.ast.defines)
+        if (block.valid && !block.params.empty())
+          elaboration.templates[block.name] = &block;
+    }
+    for (const GateDefinitionRef &def : definitions) {
+      elaboration.registry.Register(def);
+      elaboration.definitions.push_back(def);
+      if (def->name.find('<') != std::string::npos)
+        elaboration.instances.emplace(def->name, def);
+    }
+  }
+};
+
+void CompileScript(std::string text, GateTable registry, CompiledScript &out,
+                   DefinitionCache *cache,
+                   const std::filesystem::path &directory) {
+  out.text = std::move(text);
+  out.definitions.clear();
+  out.definitionsText.clear();
+  ParseScript(out.text, out.ast);
+
+  std::vector<ScriptError> errors = std::move(out.ast.errors);
+  out.ast.errors.clear();
+  if (cache)
+    cache->BeginCompile();
+  Elaboration elaboration(registry, errors, out.definitions, cache);
+  Importer importer(elaboration);
+  for (const ScriptImport &import : out.ast.imports) {
+    uint64_t key;
+    std::string error;
+    if (!importer.Import(directory / std::string(import.path), key, error))
+      errors.push_back({import.span, std::move(error)});
+    out.definitionsText.append(import.text).append("\n");
+  }
+  if (!out.ast.imports.empty())
+    out.definitionsText += "\n";
+  CompileDefines(out.ast, elaboration, &out.definitionsText);
+  // Instances the scene places; a type that is no template, or has the wrong
+  // number of parameters, is left for the scene to report as unknown
+  for (const ScriptNodeDecl &node : out.ast.nodes) {
+    auto it = elaboration.templates.find(node.base);
+    if (!node.params.empty() && it != elaboration.templates.end() &&
+        it->second->params.size() == node.params.size())
+      elaboration.Instance(node.base, node.params, node.span);
+  }
+
+  std::stable_sort(errors.begin(), errors.end(),
+                   [](const ScriptError &a, const ScriptError &b) {
+                     return a.span.offset < b.span.offset;
+                   });
+  out.errors = std::move(errors);
+  out.lines.Build(out.text);
+  if (cache)
+    cache->Prune();
+}
+
+ScriptCompiler::ScriptCompiler() : worker([this] { Run(); }) {}
+
+ScriptCompiler::~ScriptCompiler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  worker.join();
+}
+
+void ScriptCompiler::Submit(std::string text, const GateTable &registry,
+                            std::filesystem::path directory) {
+  auto job = std::make_unique<Job>();
+  job->text = std::move(text);
+  job->registry = registry;
+  job->directory = std::move(directory);
+  job->due = std::chrono::steady_clock::now() +
+             std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                 std::chrono::duration<double>(DebounceSeconds));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job->generation = ++generation;
+    queued = std::move(job);
+    finished.reset();
+  }
+  wake.notify_one();
+}
+
+void ScriptCompiler::Cancel() {
+  std::lock_guard<std::mutex> lock(mutex);
+  ++generation;
+  queued.reset();
+  finished.reset();
+}
+
+std::unique_ptr<CompiledScript> ScriptCompiler::Take() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return std::move(finished);
+}
+
+bool ScriptCompiler::Pending() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queued || compiling || finished;
+}
+
+void ScriptCompiler::Run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    wake.wait(lock, [&] { return stopping || queued; });
+    if (stopping)
+      return;
+
+    // Debounce: each new submission replaces the job and restarts the wait
+    auto due = queued->due;
+    if (wake.wait_until(lock, due, [&] {
+          return stopping || !queued || queued->due != due;
+        }))
+      continue;
+
+    std::unique_ptr<Job> job = std::move(queued);
+    compiling = true;
+    lock.unlock();
+
+    auto result = std::make_unique<CompiledScript>();
+    result->generation = job->generation;
+    {
+      PROFILE_ZONE("Background Compile");
+      CompileScript(std::move(job->text), std::move(job->registry), *result,
+                    &cache, job->directory);
+    }
+
+    lock.lock();
+    compiling = false;
+    // Dropped if something newer was submitted or cancelled meanwhile
+    if (result->generation == generation) {
+      finished = std::move(result);
+      Repaint::Request();
+    }
+  }
+}
+} // namespace Logicarium
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../Nodes/Gates/CustomGate.hpp"
+#include "ScriptParser.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Logicarium {
+// One version of the script, parsed and with its define blocks lowered to
+// gate definitions, ready to be applied to the graph. Applying it (registering
+// the definitions and diffing the scene) is left to the UI thread, which owns
+// the registry and the arena.
+struct CompiledScript {
+  uint64_t generation = 0;
+  std::string text; // The AST's names point into this
+  ScriptAst ast;
+  // Blocks that lowered, in order, after the definitions of the libraries
+  // the script imports
+  std::vector<GateDefinitionRef> definitions;
+  std::string definitionsText; // Imports and blocks' source, for preserving
+  std::vector<ScriptError> errors; // By position
+  LineIndex lines;
+};
+
+// Define blocks lowered by earlier compiles, keyed by their text with
+// comments and spacing normalized away (plus the parameter values, for a
+// template instance). An entry is only reused while every gate it resolved
+// while lowering still resolves to the same definition, so editing a block
+// invalidates it and the blocks built on it, and nothing else. Blocks that
+// failed to lower are not kept. Imported libraries are remembered as well, so
+// a compile only rereads a library whose file changed. Safe to share between
+// threads.
+class DefinitionCache {
+public:
+  // A gate the block resolved: by name, or for a template instance by
+  // template name and parameter values. definition is null if the name
+  // resolved to nothing.
+  struct Dependency {
+    std::string name;
+    std::vector<int> params;
+    GateDefinitionRef definition;
+  };
+  struct Entry {
+    GateDefinitionRef definition;
+    std::vector<Dependency> dependencies;
+  };
+
+  // A library as an earlier compile imported it
+  struct Library {
+    uint64_t stamp = 0; // Size and modification time of its file
+    uint64_t key = 0;   // See LibraryKey in ScriptCompiler.cpp
+    // Resolved path and key of each library it imports
+    std::vector<std::pair<std::string, uint64_t>> imports;
+    std::string templates; // Source of its template blocks
+    std::vector<GateDefinitionRef> definitions;
+  };
+
+  // Compiles that may pass without using an entry before it is dropped
+  static constexpr uint64_t KeepCompiles = 4;
+
+  // Call once per compile, before looking anything up
+  void BeginCompile();
+  // Copies out the entry for key, if there is one
+  bool Find(const std::string &key, Entry &entry);
+  void Store(const std::string &key, Entry entry);
+  bool FindLibrary(const std::string &path, Library &library);
+  void StoreLibrary(const std::string &path, Library library);
+  // Drops entries unused for KeepCompiles compiles
+  void Prune();
+  size_t Size() const;
+
+  // Block text reduced to what lowering depends on
+  static std::string Normalize(std::string_view text);
+
+private:
+  template <typename T> struct Slot {
+    T value;
+    uint64_t lastUsed = 0;
+  };
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Slot<Entry>> slots;
+  std::unordered_map<std::string, Slot<Library>> libraries; // By path
+  uint64_t compiles = 0;
+};
+
+// Parses and lowers text. registry is a snapshot of the gate registry to
+// resolve gate calls against; definitions from the script are added to it as
+// they lower, so later blocks can use earlier ones. Imports are loaded first,
+// with paths relative to directory, from each library's cache file where it
+// is current; a library compiled here gets its cache file written. Blocks
+// found unchanged in cache, if one is given, are not lowered again. Touches
+// no global state besides those files, so it is safe on any thread.
+void CompileScript(std::string text, GateTable registry, CompiledScript &out,
+                   DefinitionCache *cache = nullptr,
+                   const std::filesystem::path &directory = {});
+
+// Compiles the script on a worker thread once it has been left alone for a
+// moment, so typing never waits on a parse. Only the newest submission is
+// compiled; anything older still queued or in flight is dropped.
+class ScriptCompiler {
+public:
+  static constexpr double DebounceSeconds = 0.15;
+
+  ScriptCompiler();
+  ~ScriptCompiler();
+  ScriptCompiler(const ScriptCompiler &) = delete;
+  ScriptCompiler &operator=(const ScriptCompiler &) = delete;
+
+  // Queues text for compiling against a snapshot of registry, with imports
+  // relative to directory
+  void Submit(std::string text, const GateTable &registry,
+              std::filesystem::path directory);
+  // Forgets whatever is queued, in flight or finished but not taken
+  void Cancel();
+  // The newest finished result, if it hasn't been taken yet
+  std::unique_ptr<CompiledScript> Take();
+  // Something submitted has not been taken yet
+  bool Pending() const;
+  // Shared by the worker's compiles and any made directly, so they reuse
+  // each other's definitions
+  DefinitionCache &Cache() { return cache; }
+
+private:
+  struct Job {
+    uint64_t generation = 0;
+    std::string text;
+    GateTable registry;
+    std::filesystem::path directory;
+    std::chrono::steady_clock::time_point due;
+  };
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::unique_ptr<Job> queued;
+  std::unique_ptr<CompiledScript> finished;
+  uint64_t generation = 0; // Of the newest submission
+  bool compiling = false;
+  bool stopping = false;
+  DefinitionCache cache;
+  std::thread worker; // Last, so everything it uses exists before it starts
+
+  void Run();
+};
+} // namespace Logicarium
@@ -0,0 +1,161 @@
+#include "ScriptLibrary.hpp"
+#include "BinaryIO.hpp"
+
+namespace Logicarium {
+static constexpr std::string_view Magic = "LGCL";
+
+static void WriteDefinition(ByteWriter &out, const GateDefinition &def,
+                            StringTable &strings) {
+  out.U32(strings.Add(def.name));
+  out.U32(def.color);
+  out.U32((uint32_t)def.nodes.size());
+  for (const NodeDefinition &node : def.nodes) {
+    out.U32(strings.Add(node.type));
+    out.F32(node.pos.x);
+    out.F32(node.pos.y);
+    out.I32(node.id);
+  }
+  out.U32((uint32_t)def.connections.size());
+  for (const ConnectionDefinition &conn : def.connections) {
+    out.I32(conn.inputNodeId);
+    out.U32(strings.Add(conn.inputSlot));
+    out.I32(conn.outputNodeId);
+    out.U32(strings.Add(conn.outputSlot));
+  }
+  for (const std::vector<int> *pins :
+       {&def.inputPinIndices, &def.outputPinIndices}) {
+    out.U32((uint32_t)pins->size());
+    for (int pin : *pins)
+      out.I32(pin);
+  }
+  for (const std::vector<std::string> *names :
+       {&def.inputPinNames, &def.outputPinNames}) {
+    out.U32((uint32_t)names->size());
+    for (const std::string &name : *names)
+      out.U32(strings.Add(name));
+  }
+}
+
+// False if the data runs out or names a string the table doesn't have
+static bool ReadDefinition(ByteReader &in,
+                           const std::vector<std::string_view> &strings,
+                           GateDefinition &def) {
+  bool ok = true;
+  auto string = [&]() {
+    uint32_t index = in.U32();
+    if (index < strings.size())
+      return std::string(strings[index]);
+    ok = false;
+    return std::string();
+  };
+  // Counts come from the file, so bound them by what is left of it before
+  // reserving for them
+  auto count = [&](size_t minSize) {
+    uint32_t n = in.U32();
+    if (n > in.Remaining() / minSize) {
+      ok = false;
+      return (uint32_t)0;
+    }
+    return n;
+  };
+
+  def.name = string();
+  def.color = in.U32();
+  uint32_t nodeCount = count(16);
+  def.nodes.resize(nodeCount);
+  for (NodeDefinition &node : def.nodes) {
+    node.type = string();
+    node.pos.x = in.F32();
+    node.pos.y = in.F32();
+    node.id = in.I32();
+  }
+  uint32_t connCount = count(16);
+  def.connections.resize(connCount);
+  for (ConnectionDefinition &conn : def.connections) {
+    conn.inputNodeId = in.I32();
+    conn.inputSlot = string();
+    conn.outputNodeId = in.I32();
+    conn.outputSlot = string();
+  }
+  for (std::vector<int> *pins : {&def.inputPinIndices, &def.outputPinIndices}) {
+    pins->resize(count(4));
+    for (int &pin : *pins)
+      pin = in.I32();
+  }
+  for (std::vector<std::string> *names :
+       {&def.inputPinNames, &def.outputPinNames}) {
+    names->resize(count(4));
+    for (std::string &name : *names)
+      name = string();
+  }
+  return ok && in.Ok();
+}
+
+bool ReadLibraryCache(const std::string &path, LibraryCacheFile &file) {
+  // One read for the whole file; everything after is parsing memory
+  std::string bytes;
+  const size_t checksumSize = 8;
+  if (!ReadFileBytes(path, bytes) ||
+      bytes.size() < Magic.size() + 4 + checksumSize)
+    return false;
+  std::string_view body(bytes.data(), bytes.size() - checksumSize);
+  ByteReader checksum(std::string_view(bytes).substr(body.size()));
+  if (checksum.U64() != Fnv1a(body))
+    return false;
+
+  ByteReader in(body);
+  if (in.Raw(Magic.size()) != Magic || in.U32() != LibraryCacheFile::Version)
+    return false;
+  file = LibraryCacheFile();
+  file.sourceHash = in.U64();
+  uint32_t importCount = in.U32();
+  for (uint32_t i = 0; i < importCount && in.Ok(); ++i) {
+    LibraryCacheFile::Import import;
+    import.path = in.String();
+    import.key = in.U64();
+    file.imports.push_back(std::move(import));
+  }
+  file.templates = in.String();
+
+  std::vector<std::string_view> strings;
+  uint32_t stringCount = in.U32();
+  for (uint32_t i = 0; i < stringCount && in.Ok(); ++i)
+    strings.push_back(in.String());
+  uint32_t definitionCount = in.U32();
+  for (uint32_t i = 0; i < definitionCount && in.Ok(); ++i) {
+    GateDefinition def;
+    if (!ReadDefinition(in, strings, def))
+      return false;
+    file.definitions.push_back(
+        std::make_shared<const GateDefinition>(std::move(def)));
+  }
+  return in.Ok() && in.Remaining() == 0;
+}
+
+bool WriteLibraryCache(const std::string &path, const LibraryCacheFile &file) {
+  // Definitions go first into their own buffer, since the string table they
+  // fill has to precede them in the file
+  StringTable strings;
+  ByteWriter definitions;
+  definitions.U32((uint32_t)file.definitions.size());
+  for (const GateDefinitionRef &def : file.definitions)
+    WriteDefinition(definitions, *def, strings);
+
+  ByteWriter out;
+  out.Raw(Magic);
+  out.U32(LibraryCacheFile::Version);
+  out.U64(file.sourceHash);
+  out.U32((uint32_t)file.imports.size());
+  for (const LibraryCacheFile::Import &import : file.imports) {
+    out.String(import.path);
+    out.U64(import.key);
+  }
+  out.String(file.templates);
+  out.U32((uint32_t)strings.Strings().size());
+  for (const std::string *text : strings.Strings())
+    out.String(*text);
+  out.Raw(definitions.Bytes());
+  out.U64(Fnv1a(out.Bytes()));
+  return WriteFileBytes(path, out.Bytes());
+}
+} // namespace Logicarium
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "../Nodes/Gates/CustomGate.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Logicarium {
+// Compiled form of a script library (a file of define blocks that scripts
+// import), kept next to it as "<library>.cache" so later imports skip the
+// parse and lowering. It stays valid while sourceHash matches the library's
+// text and each import still compiles to the key recorded for it; the
+// importer checks both before using it.
+//
+// Layout, all integers little-endian:
+//
+//   "LGCL", u32 version
+//   u64 source hash
+//   u32 import count, then per import: string path, u64 key
+//   string template source
+//   u32 string count, then the strings
+//   u32 definition count, then per definition, strings as indices into the
+//     string table: name, u32 color, nodes (type, f32 x, f32 y, i32 id),
+//     connections (i32 input node, input slot, i32 output node, output
+//     slot), i32 input and output pin indices, input and output pin names,
+//     each list preceded by its u32 count
+//   u64 FNV-1a of everything before it
+//
+// A string is a u32 length and its bytes.
+struct LibraryCacheFile {
+  static constexpr uint32_t Version = 1;
+
+  struct Import {
+    std::string path; // As written in the library
+    uint64_t key = 0;
+  };
+
+  uint64_t sourceHash = 0;
+  std::vector<Import> imports;
+  // The library's template blocks, which only become gates once a script
+  // instantiates them
+  std::string templates;
+  std::vector<GateDefinitionRef> definitions;
+};
+
+// False if path is missing, truncated, of another version or fails its
+// checksum
+bool ReadLibraryCache(const std::string &path, LibraryCacheFile &file);
+// Replaces the file at path in one step, so a reader never sees half a cache
+bool WriteLibraryCache(const std::string &path, const LibraryCacheFile &file);
+} // namespace Logicarium
@@ -0,0 +1,847 @@
+#include "ScriptParser.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace Logicarium {
+namespace {
+enum class Tok : uint8_t {
+  Word,   // Names, keywords and numbers
+  String, // "text" with its quotes; the closing one is missing if unterminated
+  LParen,
+  RParen,
+  LBracket,
+  RBracket,
+  LBrace,
+  RBrace,
+  LAngle,
+  RAngle,
+  Comma,
+  Dot,
+  Arrow,
+  At,
+  Equals,
+  Colon,
+  Newline,
+  End,
+};
+
+struct Token {
+  Tok kind = Tok::End;
+  std::string_view text;
+  SourceSpan span;
+};
+
+// Words run until whitespace or punctuation, so gate names saved from the
+// editor ("Half-Adder") lex as one word, as do numbers ("-200"). '-' and '/'
+// only end a word when they start "->" or "//".
+struct WordChars {
+  bool table[256];
+  constexpr WordChars() : table() {
+    for (int c = 0; c < 256; ++c)
+      table[c] = true;
+    for (unsigned char c : std::string_view(" \t\r\n()[]{}<>,.@=:-/"))
+      table[c] = false;
+  }
+};
+static constexpr WordChars wordChars;
+
+class Lexer {
+public:
+  explicit Lexer(std::string_view text) : text(text) {}
+
+  Token Next() {
+    while (pos < text.size()) {
+      char c = text[pos];
+      if (c == ' ' || c == '\t' || c == '\r') {
+        ++pos;
+      } else if (c == '/' && Peek(1) == '/') {
+        size_t end = text.find('\n', pos);
+        pos = end == std::string_view::npos ? text.size() : end;
+      } else {
+        break;
+      }
+    }
+
+    Token token;
+    size_t start = pos;
+    token.span.line = line;
+    token.span.column = (int)(start - lineStart) + 1;
+    if (pos >= text.size()) {
+      token.kind = Tok::End;
+    } else {
+      switch (text[pos]) {
+      case '\n':
+        token.kind = Tok::Newline;
+        ++pos;
+        ++line;
+        lineStart = pos;
+        break;
+      case '(':
+        token.kind = Tok::LParen;
+        ++pos;
+        break;
+      case ')':
+        token.kind = Tok::RParen;
+        ++pos;
+        break;
+      case '[':
+        token.kind = Tok::LBracket;
+        ++pos;
+        break;
+      case ']':
+        token.kind = Tok::RBracket;
+        ++pos;
+        break;
+      case '{':
+        token.kind = Tok::LBrace;
+        ++pos;
+        break;
+      case '}':
+        token.kind = Tok::RBrace;
+        ++pos;
+        break;
+      case '<':
+        token.kind = Tok::LAngle;
+        ++pos;
+        break;
+      case '>':
+        token.kind = Tok::RAngle;
+        ++pos;
+        break;
+      case ',':
+        token.kind = Tok::Comma;
+        ++pos;
+        break;
+      case '.':
+        token.kind = Tok::Dot;
+        ++pos;
+        break;
+      case '@':
+        token.kind = Tok::At;
+        ++pos;
+        break;
+      case '=':
+        token.kind = Tok::Equals;
+        ++pos;
+        break;
+      case ':':
+        token.kind = Tok::Colon;
+        ++pos;
+        break;
+      case '"':
+        // Strings stay on one line
+        token.kind = Tok::String;
+        ++pos;
+        while (pos < text.size() && text[pos] != '"' && text[pos] != '\n')
+          ++pos;
+        if (pos < text.size() && text[pos] == '"')
+          ++pos;
+        break;
+      default:
+        if (text[pos] == '-' && Peek(1) == '>') {
+          token.kind = Tok::Arrow;
+          pos += 2;
+        } else {
+          token.kind = Tok::Word;
+          while (pos < text.size()) {
+            char c = text[pos];
+            if (!wordChars.table[(unsigned char)c] &&
+                !(c == '-' && Peek(1) != '>') && !(c == '/' && Peek(1) != '/'))
+              break;
+            ++pos;
+          }
+        }
+      }
+    }
+    token.text = text.substr(start, pos - start);
+    token.span.offset = (uint32_t)start;
+    token.span.length = (uint32_t)(pos - start);
+    return token;
+  }
+
+private:
+  std::string_view text;
+  size_t pos = 0;
+  int line = 1;
+  size_t lineStart = 0;
+
+  char Peek(size_t ahead) const {
+    return pos + ahead < text.size() ? text[pos + ahead] : '\0';
+  }
+};
+
+static const char *Describe(const Token &token) {
+  switch (token.kind) {
+  case Tok::Newline:
+    return "end of line";
+  case Tok::End:
+    return "end of script";
+  default:
+    return nullptr;
+  }
+}
+
+// Bounds recursion on pathological input like ((((...
+static constexpr int MaxExpressionDepth = 256;
+// And on generate loops inside generate loops
+static constexpr int MaxLoopDepth = 64;
+
+class Parser {
+public:
+  Parser(std::string_view text, ScriptAst &ast)
+      : text(text), lexer(text), ast(ast) {
+    Advance();
+  }
+
+  void Parse() {
+    while (tok.kind != Tok::End) {
+      if (tok.kind == Tok::Newline)
+        Advance();
+      else if (IsWord("define"))
+        ParseDefine();
+      else if (IsWord("import"))
+        ParseImport();
+      else
+        ParseSceneLine();
+    }
+  }
+
+private:
+  std::string_view text;
+  Lexer lexer;
+  ScriptAst &ast;
+  Token tok;
+  uint32_t prevEnd = 0; // End offset of the last consumed token
+
+  void Advance() {
+    prevEnd = tok.span.offset + tok.span.length;
+    tok = lexer.Next();
+  }
+
+  bool IsWord(std::string_view word) const {
+    return tok.kind == Tok::Word && tok.text == word;
+  }
+
+  // Span from start through the last consumed token
+  SourceSpan SpanFrom(const SourceSpan &start) const {
+    SourceSpan span = start;
+    span.length = prevEnd - start.offset;
+    return span;
+  }
+
+  void Error(const SourceSpan &span, std::string message) {
+    ast.errors.push_back({span, std::move(message)});
+  }
+
+  void ErrorAtToken(const std::string &expected) {
+    const char *what = Describe(tok);
+    Error(tok.span, "Expected " + expected + ", found " +
+                        (what ? std::string(what)
+                              : "'" + std::string(tok.text) + "'"));
+  }
+
+  // Drops the rest of the current line, including its newline
+  void SkipLine() {
+    while (tok.kind != Tok::Newline && tok.kind != Tok::End)
+      Advance();
+    if (tok.kind == Tok::Newline)
+      Advance();
+  }
+
+  bool Expect(Tok kind, const char *expected) {
+    if (tok.kind != kind) {
+      ErrorAtToken(expected);
+      return false;
+    }
+    Advance();
+    return true;
+  }
+
+  bool ExpectWord(std::string_view &out, const char *expected) {
+    if (tok.kind != Tok::Word) {
+      ErrorAtToken(expected);
+      return false;
+    }
+    out = tok.text;
+    Advance();
+    return true;
+  }
+
+  bool ExpectLineEnd() {
+    if (tok.kind == Tok::End)
+      return true;
+    return Expect(Tok::Newline, "end of line");
+  }
+
+  bool ParseInt(int &value) {
+    if (tok.kind == Tok::Word) {
+      const char *first = tok.text.data();
+      const char *last = first + tok.text.size();
+      auto result = std::from_chars(first, last, value);
+      if (result.ec == std::errc() && result.ptr == last) {
+        Advance();
+        return true;
+      }
+    }
+    ErrorAtToken("integer");
+    return false;
+  }
+
+  // [hi:lo] or [bit]
+  bool ParseRange(ScriptRange &range) {
+    SourceSpan start = tok.span;
+    if (!Expect(Tok::LBracket, "'['") || !ParseInt(range.hi))
+      return false;
+    range.lo = range.hi;
+    if (tok.kind == Tok::Colon) {
+      Advance();
+      if (!ParseInt(range.lo))
+        return false;
+    }
+    if (!Expect(Tok::RBracket, "']'"))
+      return false;
+    if (range.lo < 0 || range.hi < range.lo) {
+      Error(SpanFrom(start), "Bit range must run from high bit down to low");
+      return false;
+    }
+    return true;
+  }
+
+  // Integer expression in a define, up to the ',', ':', ']', '>' or '..'
+  // that ends it; evaluated when the define is elaborated
+  bool ParseIndex(ScriptIndex &index) {
+    SourceSpan start = tok.span;
+    int depth = 0;
+    while (tok.kind == Tok::Word || tok.kind == Tok::LParen ||
+           (tok.kind == Tok::RParen && depth > 0)) {
+      depth += tok.kind == Tok::LParen ? 1 : tok.kind == Tok::RParen ? -1 : 0;
+      Advance();
+    }
+    if (tok.span.offset == start.offset) {
+      ErrorAtToken("number");
+      return false;
+    }
+    index.span = SpanFrom(start);
+    index.text = text.substr(index.span.offset, index.span.length);
+    return true;
+  }
+
+  // [hi:lo] or [hi], in a define
+  bool ParseIndexRange(ScriptIndex &hi, ScriptIndex &lo) {
+    if (!Expect(Tok::LBracket, "'['") || !ParseIndex(hi))
+      return false;
+    if (tok.kind == Tok::Colon) {
+      Advance();
+      if (!ParseIndex(lo))
+        return false;
+    }
+    return Expect(Tok::RBracket, "']'");
+  }
+
+  // <index, ...>
+  bool ParseParams(std::vector<ScriptIndex> &params) {
+    Advance(); // <
+    for (;;) {
+      ScriptIndex param;
+      if (!ParseIndex(param))
+        return false;
+      params.push_back(param);
+      if (tok.kind != Tok::Comma)
+        break;
+      Advance();
+    }
+    return Expect(Tok::RAngle, "'>'");
+  }
+
+  // --- Scene ---
+
+  // import "path"
+  void ParseImport() {
+    SourceSpan start = tok.span;
+    Advance();
+    if (tok.kind != Tok::String) {
+      ErrorAtToken("quoted library path");
+      SkipLine();
+      return;
+    }
+    if (tok.text.size() < 2 || tok.text.back() != '"') {
+      Error(tok.span, "Missing closing '\"'");
+      SkipLine();
+      return;
+    }
+    ScriptImport import;
+    import.path = tok.text.substr(1, tok.text.size() - 2);
+    Advance();
+    import.span = SpanFrom(start);
+    import.text = text.substr(import.span.offset, import.span.length);
+    if (import.path.empty())
+      Error(import.span, "Empty library path");
+    else
+      ast.imports.push_back(import);
+    if (!ExpectLineEnd())
+      SkipLine();
+  }
+
+  void ParseSceneLine() {
+    SourceSpan start = tok.span;
+    std::string_view first;
+    if (!ExpectWord(first, "node or wire")) {
+      SkipLine();
+      return;
+    }
+    bool ok = tok.kind == Tok::Word || tok.kind == Tok::LAngle
+                  ? ParseNode(first, start)
+                  : ParseWire(first, start);
+    if (!ok || !ExpectLineEnd())
+      SkipLine();
+  }
+
+  // Type[<params>] id @ x, y [momentary]
+  bool ParseNode(std::string_view type, const SourceSpan &start) {
+    ScriptNodeDecl node;
+    node.type = node.base = type;
+    if (tok.kind == Tok::LAngle) {
+      Advance();
+      for (;;) {
+        int param;
+        if (!ParseInt(param))
+          return false;
+        node.params.push_back(param);
+        if (tok.kind != Tok::Comma)
+          break;
+        Advance();
+      }
+      if (!Expect(Tok::RAngle, "'>'"))
+        return false;
+      // Refer to the text if it is spelled the canonical way, as it is when
+      // the editor wrote it
+      std::string name = InstanceName(type, node.params);
+      std::string_view written =
+          text.substr(start.offset, prevEnd - start.offset);
+      if (written == name)
+        node.type = written;
+      else
+        node.type = ast.names.emplace_back(std::move(name));
+    }
+    if (!ExpectWord(node.id, "node id"))
+      return false;
+    if (!Expect(Tok::At, "'@'") || !ParseInt(node.x) ||
+        !Expect(Tok::Comma, "','") || !ParseInt(node.y))
+      return false;
+    while (tok.kind == Tok::Word) {
+      if (tok.text != "momentary") {
+        Error(tok.span, "Unknown flag '" + std::string(tok.text) + "'");
+        return false;
+      }
+      node.momentary = true;
+      Advance();
+    }
+    node.span = SpanFrom(start);
+    ast.nodes.push_back(node);
+    return true;
+  }
+
+  // id[.slot][range] -> id[.slot][range]
+  bool ParseWire(std::string_view outId, const SourceSpan &start) {
+    ScriptWireDecl wire;
+    wire.outId = outId;
+    wire.outSlot = "out";
+    if (tok.kind == Tok::Dot) {
+      Advance();
+      if (!ExpectWord(wire.outSlot, "output name"))
+        return false;
+    }
+    if (tok.kind == Tok::LBracket && !ParseRange(wire.outRange))
+      return false;
+    if (!Expect(Tok::Arrow, "'->' or a node id"))
+      return false;
+    if (!ExpectWord(wire.inId, "node id"))
+      return false;
+    wire.inSlot = "in";
+    if (tok.kind == Tok::Dot) {
+      Advance();
+      if (!ExpectWord(wire.inSlot, "input name"))
+        return false;
+    }
+    if (tok.kind == Tok::LBracket && !ParseRange(wire.inRange))
+      return false;
+    if (wire.outRange.Given() && wire.inRange.Given() &&
+        wire.outRange.Width() != wire.inRange.Width()) {
+      Error(SpanFrom(start), "Wire joins " +
+                                 std::to_string(wire.outRange.Width()) +
+                                 " bits to " +
+                                 std::to_string(wire.inRange.Width()));
+      return false;
+    }
+    wire.span = SpanFrom(start);
+    ast.wires.push_back(wire);
+    return true;
+  }
+
+  // --- Definitions ---
+
+  // ( name, bus[width], bus[msb:0], ... )
+  bool ParsePortList(std::vector<ScriptPort> &ports) {
+    if (!Expect(Tok::LParen, "'('"))
+      return false;
+    if (tok.kind != Tok::RParen) {
+      for (;;) {
+        ScriptPort port;
+        if (!ExpectWord(port.name, "name"))
+          return false;
+        if (tok.kind == Tok::LBracket && !ParseIndexRange(port.hi, port.lo))
+          return false;
+        ports.push_back(port);
+        if (tok.kind != Tok::Comma)
+          break;
+        Advance();
+      }
+    }
+    return Expect(Tok::RParen, "')'");
+  }
+
+  // define Name[<param, ...>](in, ...) -> (out, ...):
+  bool ParseDefineHeader(ScriptDefine &def) {
+    Advance(); // define
+    if (!ExpectWord(def.name, "gate name"))
+      return false;
+    if (tok.kind == Tok::LAngle) {
+      Advance();
+      for (;;) {
+        std::string_view param;
+        if (!ExpectWord(param, "parameter name"))
+          return false;
+        def.params.push_back(param);
+        if (tok.kind != Tok::Comma)
+          break;
+        Advance();
+      }
+      if (!Expect(Tok::RAngle, "'>'"))
+        return false;
+    }
+    if (!ParsePortList(def.inputs) || !Expect(Tok::Arrow, "'->'") ||
+        !ParsePortList(def.outputs))
+      return false;
+    if (tok.kind == Tok::Colon)
+      Advance();
+    if (def.inputs.empty() || def.outputs.empty()) {
+      Error(def.span, "Gate must have name, inputs, and outputs");
+      return false;
+    }
+    return ExpectLineEnd();
+  }
+
+  void ParseDefine() {
+    ScriptDefine def;
+    SourceSpan start = tok.span;
+    def.span = start;
+    if (!ParseDefineHeader(def)) {
+      def.valid = false;
+      SkipLine();
+    }
+
+    bool closed = ParseBlock(def, 0);
+    def.span = SpanFrom(start);
+    def.text = text.substr(start.offset, def.span.length);
+    if (!closed) {
+      Error(start, "Unclosed define block");
+      def.valid = false;
+    } else if (!ExpectLineEnd()) {
+      def.valid = false;
+      SkipLine();
+    }
+    ast.defines.push_back(std::move(def));
+  }
+
+  // Statements through the "end" closing the block; false if the text ran
+  // out first
+  bool ParseBlock(ScriptDefine &def, int depth) {
+    while (tok.kind != Tok::End) {
+      if (tok.kind == Tok::Newline) {
+        Advance();
+      } else if (IsWord("end")) {
+        Advance();
+        return true;
+      } else if (IsWord("for")) {
+        if (!ParseFor(def, depth))
+          return false;
+      } else if (!ParseAssignment(def)) {
+        def.valid = false;
+        SkipLine();
+      }
+    }
+    return false;
+  }
+
+  // for var in from..to: statements end
+  bool ParseFor(ScriptDefine &def, int depth) {
+    SourceSpan start = tok.span;
+    ScriptStatement loop;
+    loop.kind = ScriptStatement::For;
+    Advance(); // for
+    bool ok = ExpectWord(loop.var, "loop variable");
+    if (ok && !IsWord("in")) {
+      ErrorAtToken("'in'");
+      ok = false;
+    } else if (ok) {
+      Advance();
+    }
+    ok = ok && ParseIndex(loop.from) && Expect(Tok::Dot, "'..'") &&
+         Expect(Tok::Dot, "'..'") && ParseIndex(loop.to);
+    if (ok && tok.kind == Tok::Colon)
+      Advance();
+    if (!ok || !ExpectLineEnd()) {
+      def.valid = false;
+      SkipLine();
+    }
+    if (depth >= MaxLoopDepth) {
+      Error(start, "Loops nested too deeply");
+      def.valid = false;
+      return false;
+    }
+
+    loop.span = SpanFrom(start);
+    size_t index = def.statements.size();
+    def.statements.push_back(loop);
+    bool closed = ParseBlock(def, depth + 1);
+    def.statements[index].end = (int)def.statements.size();
+    if (!closed) {
+      Error(start, "Unclosed for loop");
+      def.valid = false;
+      return false;
+    }
+    if (!ExpectLineEnd()) {
+      def.valid = false;
+      SkipLine();
+    }
+    return true;
+  }
+
+  // target[range] = expression
+  bool ParseAssignment(ScriptDefine &def) {
+    ScriptStatement statement;
+    ScriptAssignment &assignment = statement.assignment;
+    SourceSpan start = tok.span;
+    if (!ExpectWord(assignment.target, "signal name"))
+      return false;
+    if (tok.kind == Tok::LBracket &&
+        !ParseIndexRange(assignment.hi, assignment.lo))
+      return false;
+    if (!Expect(Tok::Equals, "'='"))
+      return false;
+    assignment.firstExpr = (int)def.exprs.size();
+    assignment.expr = ParseOr(def, 0);
+    if (assignment.expr < 0 || !ExpectLineEnd())
+      return false;
+    assignment.span = statement.span = SpanFrom(start);
+    def.statements.push_back(std::move(statement));
+    return true;
+  }
+
+  // --- Expressions: OR binds loosest, then AND, then NOT ---
+
+  int AddExpr(ScriptDefine &def, ScriptExpr expr) {
+    def.exprs.push_back(std::move(expr));
+    return (int)def.exprs.size() - 1;
+  }
+
+  int Binary(ScriptDefine &def, ScriptExpr::Kind kind, int left, int right,
+             const SourceSpan &start) {
+    ScriptExpr expr;
+    expr.kind = kind;
+    expr.args = {left, right};
+    expr.span = SpanFrom(start);
+    return AddExpr(def, std::move(expr));
+  }
+
+  int ParseOr(ScriptDefine &def, int depth) {
+    SourceSpan start = tok.span;
+    int left = ParseAnd(def, depth);
+    while (left >= 0 && IsWord("OR")) {
+      Advance();
+      int right = ParseAnd(def, depth);
+      if (right < 0)
+        return -1;
+      left = Binary(def, ScriptExpr::Or, left, right, start);
+    }
+    return left;
+  }
+
+  int ParseAnd(ScriptDefine &def, int depth) {
+    SourceSpan start = tok.span;
+    int left = ParseUnary(def, depth);
+    while (left >= 0 && IsWord("AND")) {
+      Advance();
+      int right = ParseUnary(def, depth);
+      if (right < 0)
+        return -1;
+      left = Binary(def, ScriptExpr::And, left, right, start);
+    }
+    return left;
+  }
+
+  int ParseUnary(ScriptDefine &def, int depth) {
+    if (depth >= MaxExpressionDepth) {
+      Error(tok.span, "Expression nested too deeply");
+      return -1;
+    }
+    if (!IsWord("NOT"))
+      return ParsePrimary(def, depth);
+
+    SourceSpan start = tok.span;
+    Advance();
+    int operand = ParseUnary(def, depth + 1);
+    if (operand < 0)
+      return -1;
+    ScriptExpr expr;
+    expr.kind = ScriptExpr::Not;
+    expr.args = {operand};
+    expr.span = SpanFrom(start);
+    return AddExpr(def, std::move(expr));
+  }
+
+  // An atom followed by any number of [hi:lo] slices
+  int ParsePrimary(ScriptDefine &def, int depth) {
+    SourceSpan start = tok.span;
+    int expr = ParseAtom(def, depth);
+    while (expr >= 0 && tok.kind == Tok::LBracket) {
+      ScriptExpr slice;
+      slice.kind = ScriptExpr::Slice;
+      slice.args = {expr};
+      if (!ParseIndexRange(slice.hi, slice.lo))
+        return -1;
+      slice.span = SpanFrom(start);
+      expr = AddExpr(def, std::move(slice));
+    }
+    return expr;
+  }
+
+  int ParseAtom(ScriptDefine &def, int depth) {
+    SourceSpan start = tok.span;
+    if (tok.kind == Tok::LParen) {
+      Advance();
+      int inner = ParseOr(def, depth + 1);
+      if (inner < 0 || !Expect(Tok::RParen, "')'"))
+        return -1;
+      return inner;
+    }
+    if (tok.kind == Tok::LBrace) {
+      Advance();
+      ScriptExpr concat;
+      concat.kind = ScriptExpr::Concat;
+      for (;;) {
+        int part = ParseOr(def, depth + 1);
+        if (part < 0)
+          return -1;
+        concat.args.push_back(part);
+        if (tok.kind != Tok::Comma)
+          break;
+        Advance();
+      }
+      if (!Expect(Tok::RBrace, "'}'"))
+        return -1;
+      concat.span = SpanFrom(start);
+      return AddExpr(def, std::move(concat));
+    }
+    if (tok.kind != Tok::Word || IsWord("AND") || IsWord("OR")) {
+      ErrorAtToken("expression");
+      return -1;
+    }
+
+    ScriptExpr expr;
+    expr.name = tok.text;
+    Advance();
+    if (expr.name == "0" || expr.name == "1") {
+      expr.kind = ScriptExpr::Literal;
+      expr.value = expr.name == "1";
+    } else if (tok.kind == Tok::Dot) {
+      Advance();
+      expr.kind = ScriptExpr::Member;
+      if (!ExpectWord(expr.member, "output name"))
+        return -1;
+    } else if (tok.kind == Tok::LParen || tok.kind == Tok::LAngle) {
+      if (tok.kind == Tok::LAngle && !ParseParams(expr.params))
+        return -1;
+      if (!Expect(Tok::LParen, "'('"))
+        return -1;
+      expr.kind = ScriptExpr::Call;
+      if (tok.kind != Tok::RParen) {
+        for (;;) {
+          int arg = ParseOr(def, depth + 1);
+          if (arg < 0)
+            return -1;
+          expr.args.push_back(arg);
+          if (tok.kind != Tok::Comma)
+            break;
+          Advance();
+        }
+      }
+      if (!Expect(Tok::RParen, "')'"))
+        return -1;
+    } else {
+      expr.kind = ScriptExpr::Signal;
+    }
+    expr.span = SpanFrom(start);
+    return AddExpr(def, std::move(expr));
+  }
+};
+} // namespace
+
+bool ParseScript(std::string_view text, ScriptAst &ast) {
+  ast.imports.clear();
+  ast.defines.clear();
+  ast.nodes.clear();
+  ast.wires.clear();
+  ast.errors.clear();
+  ast.names.clear();
+  Parser(text, ast).Parse();
+  return ast.errors.empty();
+}
+
+std::string FormatScriptError(const ScriptError &error) {
+  return "Line " + std::to_string(error.span.line) + ", col " +
+         std::to_string(error.span.column) + ": " + error.message;
+}
+
+std::string InstanceName(std::string_view name,
+                         const std::vector<int> &params) {
+  std::string instance(name);
+  instance += '<';
+  for (size_t i = 0; i < params.size(); ++i) {
+    if (i)
+      instance += ',';
+    instance += std::to_string(params[i]);
+  }
+  instance += '>';
+  return instance;
+}
+
+void LineIndex::Build(std::string_view text) {
+  starts.clear();
+  starts.push_back(0);
+  const char *begin = text.data();
+  const char *end = begin + text.size();
+  for (const char *p = begin; p < end;) {
+    const char *newline = (const char *)memchr(p, '\n', end - p);
+    if (!newline)
+      break;
+    p = newline + 1;
+    starts.push_back((uint32_t)(p - begin));
+  }
+  starts.push_back((uint32_t)text.size());
+}
+
+size_t LineIndex::Offset(int line, int column) const {
+  if (starts.size() < 2)
+    return 0;
+  size_t lines = starts.size() - 1;
+  size_t index = (size_t)std::clamp(line, 1, (int)lines) - 1;
+  size_t start = starts[index];
+  size_t end = starts[index + 1];
+  // Stay before the line's newline, unless it is the last line
+  if (index + 1 < lines && end > start)
+    --end;
+  return std::min(start + (size_t)std::max(column - 1, 0), end);
+}
+} // namespace Logicarium
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Logicarium {
+// Parser for the scene script language:
+//
+//   define Name(a, b) -> (out):     // custom gate, body until "end"
+//     out = NOT a AND (b OR 1)
+//   end
+//   AND g1 @ 150, 0                 // node: type id @ x, y [momentary]
+//   g1.out -> g2.in0                // wire; slots default to out / in
+//
+// Signals can be buses. A define declares one with its width, as in
+// "a[7:0]", which becomes pins a[0] through a[7]. In a body, x[3:0] and x[2]
+// slice a bus, {x, y} concatenates (x is the high part), and NOT, AND and OR
+// work bit by bit; a 0 or 1 against a bus applies to every bit. A wire can
+// join whole buses, "g1.s -> g2.a", or slices of them, "g1.s[3:0] -> g2.a".
+//
+// A define can take integer parameters, which widths, bit indices and the
+// bounds of generate loops can use; instances name their arguments:
+//
+//   define Adder<N>(a[N], b[N]) -> (s[N], c):   // a[N] is a[N-1:0]
+//     carry[0] = 0
+//     for i in 0..N:                             // i = 0 .. N-1
+//       f = FullAdder(a[i], b[i], carry[i])
+//       s[i] = f
+//       carry[i+1] = f.cout
+//     end
+//     c = carry[N]
+//   end
+//   Adder<32> add @ 0, 0
+//
+// import "stdlib/arith.lgc" makes the defines of a library, a file of define
+// blocks that may import others in turn, available to the script. The path
+// is relative to the importing file.
+//
+// The lexer and parser run in a single pass over the text without copying
+// it: every name in the tree is a view into the source, so the text must
+// outlive the ScriptAst. Errors do not stop the parse; each one is recorded
+// with its position and parsing resumes on the next line.
+
+// Position of a piece of source text; line and column are 1-based
+struct SourceSpan {
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  int line = 0;
+  int column = 0;
+};
+
+struct ScriptError {
+  SourceSpan span;
+  std::string message;
+};
+
+// Bits hi down to lo of a bus, as in [hi:lo] or [bit]
+struct ScriptRange {
+  int hi = -1, lo = -1; // -1 when no range was written
+  bool Given() const { return hi >= 0; }
+  int Width() const { return hi - lo + 1; }
+};
+
+// Integer in a define that may use parameters and loop variables: a number,
+// a name, or + - * / % over them with parentheses. Kept as source text until
+// the define is elaborated with values for its parameters.
+struct ScriptIndex {
+  std::string_view text; // Empty if none was written
+  SourceSpan span;
+};
+
+// Expression in a define body. Nodes live in ScriptDefine::exprs and refer
+// to their operands by index, so a body is one allocation, not one per node.
+struct ScriptExpr {
+  enum Kind : uint8_t {
+    Literal, // 0 or 1
+    Signal,  // name
+    Member,  // name.member, an output of a multi-output gate
+    Not,     // NOT args[0]
+    And,     // args[0] AND args[1]
+    Or,      // args[0] OR args[1]
+    Call,    // name(args...) or name<params>(args...)
+    Slice,   // args[0][hi:lo], or args[0][hi] if lo is empty
+    Concat,  // {args...}, the first one the most significant
+  };
+  Kind kind = Literal;
+  bool value = false;
+  std::string_view name, member;
+  std::vector<int> args;
+  std::vector<ScriptIndex> params; // Call
+  ScriptIndex hi, lo;              // Slice
+  SourceSpan span;
+};
+
+// target = expr, or target[hi:lo] = expr / target[hi] = expr to set bits of
+// a bus. The expression is exprs[firstExpr] through exprs[expr].
+struct ScriptAssignment {
+  std::string_view target;
+  ScriptIndex hi, lo;
+  int firstExpr = 0, expr = -1;
+  SourceSpan span;
+};
+
+// Statement in a define body: an assignment, or a generate loop that repeats
+// the statements after it, up to end, once for each value of var
+struct ScriptStatement {
+  enum Kind : uint8_t { Assign, For };
+  Kind kind = Assign;
+  ScriptAssignment assignment;
+  // for var in from..to, which stops before to; the loop's statements end
+  // before statements[end]
+  std::string_view var;
+  ScriptIndex from, to;
+  int end = 0;
+  SourceSpan span;
+};
+
+// Input or output of a define: a single signal, or a bus declared with its
+// width as name[width] or with its bits as name[msb:0]
+struct ScriptPort {
+  std::string_view name;
+  ScriptIndex hi, lo; // hi is empty for a single signal
+};
+
+struct ScriptImport {
+  std::string_view path; // Without the quotes
+  std::string_view text; // The whole directive, for preserving
+  SourceSpan span;
+};
+
+struct ScriptDefine {
+  std::string_view name;
+  std::vector<std::string_view> params; // A template if there are any
+  std::vector<ScriptPort> inputs, outputs;
+  std::vector<ScriptStatement> statements;
+  std::vector<ScriptExpr> exprs;
+  std::string_view text; // From "define" through "end", for preserving
+  SourceSpan span;
+  bool valid = true; // False if any line of the block failed to parse
+};
+
+struct ScriptNodeDecl {
+  std::string_view type, id; // type includes parameters: "Adder<8>"
+  std::string_view base;     // type without them: "Adder"
+  std::vector<int> params;
+  int x = 0, y = 0;
+  bool momentary = false;
+  SourceSpan span;
+};
+
+struct ScriptWireDecl {
+  std::string_view outId, outSlot;
+  std::string_view inId, inSlot;
+  ScriptRange outRange, inRange;
+  SourceSpan span;
+};
+
+struct ScriptAst {
+  std::vector<ScriptImport> imports;
+  std::vector<ScriptDefine> defines;
+  std::vector<ScriptNodeDecl> nodes;
+  std::vector<ScriptWireDecl> wires;
+  std::vector<ScriptError> errors;
+  // Instance types not spelled as InstanceName would, so not in the text
+  std::deque<std::string> names;
+};
+
+// Parses text into ast, which is cleared first. Returns false if any error
+// was recorded.
+bool ParseScript(std::string_view text, ScriptAst &ast);
+
+// "Line 3, col 7: message"
+std::string FormatScriptError(const ScriptError &error);
+
+// Type name of a template instance: "Adder<8>", "Mux<4,2>"
+std::string InstanceName(std::string_view name, const std::vector<int> &params);
+
+// Where each line of a text starts, for turning a line and column back into
+// a position in the text
+class LineIndex {
+public:
+  void Build(std::string_view text);
+  // Offset of line and column (both 1-based), clamped to the text
+  size_t Offset(int line, int column) const;
+
+private:
+  std::vector<uint32_t> starts; // Offset of each line, then the text's end
+};
+} // namespace Logicarium
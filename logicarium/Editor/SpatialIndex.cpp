@@ -0,0 +1,114 @@
+#include "SpatialIndex.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Logicarium {
+SpatialIndex::CellRange SpatialIndex::CellsFor(const ImRect &rect) const {
+  // Clamped so a stray huge rect can't overflow the packed cell key
+  auto cell = [&](float v) {
+    return (int)std::clamp(floorf(v / cellSize), -1e9f, 1e9f);
+  };
+  CellRange range;
+  range.minX = cell(rect.Min.x);
+  range.minY = cell(rect.Min.y);
+  range.maxX = cell(rect.Max.x);
+  range.maxY = cell(rect.Max.y);
+  return range;
+}
+
+void SpatialIndex::Link(uint32_t index) {
+  const CellRange &range = items[index].cells;
+  for (int y = range.minY; y <= range.maxY; ++y)
+    for (int x = range.minX; x <= range.maxX; ++x)
+      cells[CellKey(x, y)].push_back(index);
+}
+
+void SpatialIndex::Unlink(uint32_t index) {
+  const CellRange &range = items[index].cells;
+  for (int y = range.minY; y <= range.maxY; ++y)
+    for (int x = range.minX; x <= range.maxX; ++x) {
+      auto it = cells.find(CellKey(x, y));
+      if (it == cells.end())
+        continue;
+      std::vector<uint32_t> &cell = it->second;
+      auto pos = std::find(cell.begin(), cell.end(), index);
+      if (pos != cell.end()) {
+        *pos = cell.back();
+        cell.pop_back();
+      }
+      // Drop empty cells so they don't count towards a full scan
+      if (cell.empty())
+        cells.erase(it);
+    }
+}
+
+bool SpatialIndex::Update(uint64_t id, const ImRect &rect) {
+  auto found = lookup.find(id);
+  if (found == lookup.end()) {
+    uint32_t index;
+    if (!freeItems.empty()) {
+      index = freeItems.back();
+      freeItems.pop_back();
+    } else {
+      index = (uint32_t)items.size();
+      items.emplace_back();
+    }
+    Item &item = items[index];
+    item.id = id;
+    item.rect = rect;
+    item.cells = CellsFor(rect);
+    item.stamp = 0;
+    lookup.emplace(id, index);
+    Link(index);
+    return true;
+  }
+
+  uint32_t index = found->second;
+  Item &item = items[index];
+  if (item.rect.Min.x == rect.Min.x && item.rect.Min.y == rect.Min.y &&
+      item.rect.Max.x == rect.Max.x && item.rect.Max.y == rect.Max.y)
+    return false;
+
+  item.rect = rect;
+  CellRange range = CellsFor(rect);
+  if (!(range == item.cells)) {
+    Unlink(index);
+    item.cells = range;
+    Link(index);
+  }
+  return true;
+}
+
+bool SpatialIndex::Find(uint64_t id, ImRect *rect) const {
+  auto found = lookup.find(id);
+  if (found == lookup.end())
+    return false;
+  *rect = items[found->second].rect;
+  return true;
+}
+
+void SpatialIndex::Remove(uint64_t id) {
+  auto found = lookup.find(id);
+  if (found == lookup.end())
+    return;
+  Unlink(found->second);
+  freeItems.push_back(found->second);
+  lookup.erase(found);
+}
+
+void SpatialIndex::Clear() {
+  items.clear();
+  freeItems.clear();
+  lookup.clear();
+  cells.clear();
+}
+
+void SpatialIndex::NextQueryStamp() const {
+  if (++queryStamp == 0) {
+    // Wrapped around: old stamps could now collide with new queries
+    for (const Item &item : items)
+      item.stamp = 0;
+    queryStamp = 1;
+  }
+}
+} // namespace Logicarium
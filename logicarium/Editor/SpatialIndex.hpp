@@ -0,0 +1,91 @@
+#pragma once
+
+#include "pch.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Logicarium {
+// Uniform hash grid over canvas space. Every item is a rectangle filed under
+// each grid cell it overlaps, so a range query only visits the cells under
+// the query rectangle instead of every item on the canvas. Moving an item
+// within the cells it already covers just rewrites its rectangle.
+class SpatialIndex {
+public:
+  explicit SpatialIndex(float cellSize = 256.0f) : cellSize(cellSize) {}
+
+  // Inserts the item or moves it to rect. Returns false if it was already
+  // indexed with exactly that rect.
+  bool Update(uint64_t id, const ImRect &rect);
+  void Remove(uint64_t id);
+  void Clear();
+  // Rect the item is indexed with; false if it isn't indexed
+  bool Find(uint64_t id, ImRect *rect) const;
+  size_t Size() const { return lookup.size(); }
+
+  // Calls fn(id, rect) once for every item overlapping area
+  template <typename F> void Query(const ImRect &area, F &&fn) const {
+    CellRange range = CellsFor(area);
+    NextQueryStamp();
+
+    auto visit = [&](const std::vector<uint32_t> &cell) {
+      for (uint32_t index : cell) {
+        const Item &item = items[index];
+        if (item.stamp == queryStamp)
+          continue;
+        item.stamp = queryStamp;
+        if (item.rect.Overlaps(area))
+          fn(item.id, item.rect);
+      }
+    };
+
+    // A far zoomed-out view covers more cells than are occupied
+    if (range.Count() > cells.size()) {
+      for (const auto &entry : cells)
+        visit(entry.second);
+      return;
+    }
+    for (int y = range.minY; y <= range.maxY; ++y)
+      for (int x = range.minX; x <= range.maxX; ++x) {
+        auto it = cells.find(CellKey(x, y));
+        if (it != cells.end())
+          visit(it->second);
+      }
+  }
+
+private:
+  struct CellRange {
+    int minX = 0, minY = 0, maxX = -1, maxY = -1;
+    uint64_t Count() const {
+      return (uint64_t)(maxX - minX + 1) * (uint64_t)(maxY - minY + 1);
+    }
+    bool operator==(const CellRange &other) const {
+      return minX == other.minX && minY == other.minY && maxX == other.maxX &&
+             maxY == other.maxY;
+    }
+  };
+
+  struct Item {
+    uint64_t id = 0;
+    ImRect rect;
+    CellRange cells;
+    mutable uint32_t stamp = 0; // Last query that reported this item
+  };
+
+  float cellSize;
+  std::vector<Item> items;
+  std::vector<uint32_t> freeItems;
+  std::unordered_map<uint64_t, uint32_t> lookup; // id -> index into items
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+  mutable uint32_t queryStamp = 0;
+
+  CellRange CellsFor(const ImRect &rect) const;
+  void Link(uint32_t index);
+  void Unlink(uint32_t index);
+  void NextQueryStamp() const;
+
+  static uint64_t CellKey(int x, int y) {
+    return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+  }
+};
+} // namespace Logicarium
@@ -0,0 +1,180 @@
+#ifndef IMGUI_DEFINE_MATH_OPERATORS
+#define IMGUI_DEFINE_MATH_OPERATORS
+#endif
+
+#include "WireRenderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <imgui_internal.h>
+
+namespace Logicarium {
+// Cached curves not drawn for this many frames are dropped
+static constexpr int CurveRetainFrames = 120;
+
+static float Length(ImVec2 v) { return ImSqrt(ImLengthSqr(v)); }
+
+void WireRenderer::Begin(int currentFrame) {
+  frame = currentFrame;
+  batch.clear();
+
+  // Prune once in a while rather than every frame
+  if (frame % CurveRetainFrames == 0) {
+    for (auto it = cache.begin(); it != cache.end();) {
+      if (frame - it->second.lastUsed > CurveRetainFrames)
+        it = cache.erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
+// Same curve as ImNodes' RenderConnection: horizontal tangents at both ends,
+// pulled out by the curve strength but never past half the horizontal gap.
+void WireRenderer::Tessellate(Curve &curve) {
+  ImVec2 p0 = curve.input;
+  ImVec2 p3 = curve.output;
+  float strength = ImMin(curve.strength, ImFabs(p0.x - p3.x) * 0.5f);
+  ImVec2 p1 = p0 - ImVec2(strength, 0);
+  ImVec2 p2 = p3 + ImVec2(strength, 0);
+
+  // Control polygon length bounds the arc length
+  float length = Length(p1 - p0) + Length(p2 - p1) + Length(p3 - p2);
+  int segments = ImClamp((int)(length / 16.0f), 4, 64);
+
+  curve.points.resize(segments + 1);
+  curve.bounds = ImRect(p0, p0);
+  for (int i = 0; i <= segments; ++i) {
+    ImVec2 point = ImBezierCubicCalc(p0, p1, p2, p3, (float)i / segments);
+    curve.points[i] = point;
+    curve.bounds.Add(point);
+  }
+}
+
+void WireRenderer::Add(uint64_t key, ImVec2 output, ImVec2 input, ImU32 color,
+                       float curveStrength) {
+  Curve &curve = cache[key];
+  if (curve.points.empty() || curve.output.x != output.x ||
+      curve.output.y != output.y || curve.input.x != input.x ||
+      curve.input.y != input.y || curve.strength != curveStrength) {
+    curve.output = output;
+    curve.input = input;
+    curve.strength = curveStrength;
+    Tessellate(curve);
+  }
+  curve.lastUsed = frame;
+  batch.push_back({color, &curve, key});
+}
+
+void WireRenderer::Skip(uint64_t key) {
+  for (auto &queued : batch)
+    if (queued.key == key)
+      queued.curve = nullptr;
+}
+
+uint64_t WireRenderer::HitTest(ImVec2 point, float radius) const {
+  uint64_t best = 0;
+  float bestDistance = radius * radius;
+  ImRect area(point, point);
+  area.Expand(radius);
+
+  for (const auto &queued : batch) {
+    const Curve *curve = queued.curve;
+    if (!curve || !curve->bounds.Overlaps(area))
+      continue;
+    for (size_t i = 1; i < curve->points.size(); ++i) {
+      ImVec2 closest =
+          ImLineClosestPoint(curve->points[i - 1], curve->points[i], point);
+      float distance = ImLengthSqr(closest - point);
+      if (distance < bestDistance) {
+        best = queued.key;
+        bestDistance = distance;
+      }
+    }
+  }
+  return best;
+}
+
+// Thick polyline as a strip of quads with mitered joins. With anti-aliasing
+// on, each side gets a one pixel fringe fading to transparent, like ImGui's
+// own thick lines.
+void WireRenderer::EmitStrip(ImDrawList *drawList, const ImVec2 *points,
+                             int count, ImU32 color, float thickness) {
+  if (count < 2)
+    return;
+
+  bool antiAliased = (drawList->Flags & ImDrawListFlags_AntiAliasedLines) != 0;
+  float fringe = drawList->_FringeScale;
+  float half = antiAliased ? ImMax(thickness - fringe, 0.0f) * 0.5f
+                           : thickness * 0.5f;
+  ImU32 transparent = color & ~IM_COL32_A_MASK;
+  ImVec2 uv = drawList->_Data->TexUvWhitePixel;
+
+  int vertsPerPoint = antiAliased ? 4 : 2;
+  int idxPerSegment = antiAliased ? 18 : 6;
+  drawList->PrimReserve((count - 1) * idxPerSegment, count * vertsPerPoint);
+
+  ImDrawIdx base = (ImDrawIdx)drawList->_VtxCurrentIdx;
+  for (int i = 0; i < count; ++i) {
+    // Miter normal: average of the adjoining segment normals
+    ImVec2 prev = points[i > 0 ? i - 1 : i];
+    ImVec2 next = points[i < count - 1 ? i + 1 : i];
+    ImVec2 dir = next - prev;
+    float length = Length(dir);
+    ImVec2 normal =
+        length > 0 ? ImVec2(-dir.y / length, dir.x / length) : ImVec2(0, 1);
+
+    ImVec2 p = points[i];
+    auto write = [&](ImVec2 pos, ImU32 col) {
+      drawList->_VtxWritePtr->pos = pos;
+      drawList->_VtxWritePtr->uv = uv;
+      drawList->_VtxWritePtr->col = col;
+      drawList->_VtxWritePtr++;
+    };
+    if (antiAliased) {
+      write(p + normal * (half + fringe), transparent);
+      write(p + normal * half, color);
+      write(p - normal * half, color);
+      write(p - normal * (half + fringe), transparent);
+    } else {
+      write(p + normal * half, color);
+      write(p - normal * half, color);
+    }
+  }
+
+  for (int i = 0; i < count - 1; ++i) {
+    ImDrawIdx a = (ImDrawIdx)(base + i * vertsPerPoint);
+    ImDrawIdx b = (ImDrawIdx)(a + vertsPerPoint);
+    // One quad per band between adjacent vertex columns
+    for (int band = 0; band < vertsPerPoint - 1; ++band) {
+      ImDrawIdx *idx = drawList->_IdxWritePtr;
+      idx[0] = a + band;
+      idx[1] = a + band + 1;
+      idx[2] = b + band + 1;
+      idx[3] = a + band;
+      idx[4] = b + band + 1;
+      idx[5] = b + band;
+      drawList->_IdxWritePtr += 6;
+    }
+  }
+  drawList->_VtxCurrentIdx += count * vertsPerPoint;
+}
+
+void WireRenderer::Draw(ImDrawList *drawList, ImVec2 origin, float zoom,
+                        float thickness) {
+  std::stable_sort(batch.begin(), batch.end(),
+                   [](const Queued &a, const Queued &b) {
+                     return a.color < b.color;
+                   });
+
+  for (const auto &queued : batch) {
+    if (!queued.curve)
+      continue;
+    const auto &points = queued.curve->points;
+    screenPoints.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+      screenPoints[i] = origin + points[i] * zoom;
+    EmitStrip(drawList, screenPoints.data(), (int)screenPoints.size(),
+              queued.color, thickness);
+  }
+}
+} // namespace Logicarium
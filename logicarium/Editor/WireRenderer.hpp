@@ -0,0 +1,52 @@
+#pragma once
+
+#include "pch.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Logicarium {
+// Draws all visible wires in one pass. Each wire's bezier is tessellated once
+// in canvas space and cached until one of its endpoints moves; every frame the
+// cached points are only scaled and offset to the screen. Wires are emitted as
+// plain triangle strips straight into the draw list, grouped by color, so the
+// whole layer ends up in a single draw command for the renderer backend.
+class WireRenderer {
+public:
+  // Starts collecting the wires of a new frame
+  void Begin(int frame);
+  // Queues a wire between two slot positions, in canvas units. `key` must be
+  // stable for the wire across frames.
+  void Add(uint64_t key, ImVec2 output, ImVec2 input, ImU32 color,
+           float curveStrength);
+  // Removes a queued wire from this frame's batch (drawn some other way)
+  void Skip(uint64_t key);
+  // Key of the queued wire closest to point within radius, or 0 if none
+  uint64_t HitTest(ImVec2 point, float radius) const;
+  // Emits the queued wires. origin and zoom map canvas to screen space.
+  void Draw(ImDrawList *drawList, ImVec2 origin, float zoom, float thickness);
+
+private:
+  struct Curve {
+    ImVec2 output, input;
+    float strength = 0;
+    std::vector<ImVec2> points; // Canvas space
+    ImRect bounds;
+    int lastUsed = 0;
+  };
+  struct Queued {
+    ImU32 color;
+    Curve *curve;
+    uint64_t key;
+  };
+
+  std::unordered_map<uint64_t, Curve> cache;
+  std::vector<Queued> batch;
+  std::vector<ImVec2> screenPoints; // Scratch
+  int frame = 0;
+
+  static void Tessellate(Curve &curve);
+  static void EmitStrip(ImDrawList *drawList, const ImVec2 *points, int count,
+                        ImU32 color, float thickness);
+};
+} // namespace Logicarium
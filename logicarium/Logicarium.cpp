@@ -1,10 +1,47 @@
 #include "Logicarium.hpp"
+#include "Minimap.hpp"
+#include "Profiler.hpp"
+#include "Repaint.hpp"
 
 namespace Logicarium {
 void Logicarium::glfw_error_callback(int error, const char *description) {
   fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
+// ImGui repeats held keys on its own, without new input events
+static bool AnyKeyHeld() {
+  for (int key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; ++key)
+    if (ImGui::IsKeyDown((ImGuiKey)key))
+      return true;
+  return false;
+}
+
+// The minimap's texture is updated a few tiles at a time, in place
+static ImTextureID CreateMinimapTexture(int width, int height) {
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  return (ImTextureID)(intptr_t)texture;
+}
+
+static void UpdateMinimapTexture(ImTextureID texture, int x, int y, int width,
+                                 int height, const ImU32 *pixels, int stride) {
+  glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA,
+                  GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+static void DestroyMinimapTexture(ImTextureID texture) {
+  GLuint id = (GLuint)(intptr_t)texture;
+  glDeleteTextures(1, &id);
+}
+
 Logicarium::Logicarium() {}
 
 int Logicarium::Mainloop() {
@@ -32,7 +69,6 @@ int Logicarium::Mainloop() {
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
   ImGuiIO &io = ImGui::GetIO();
-  (void)io;
 
   // Setup style
   // Setup style
@@ -63,13 +99,39 @@ int Logicarium::Mainloop() {
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init(glsl_version);
 
+  Minimap::TextureBackend minimapTextures;
+  minimapTextures.create = CreateMinimapTexture;
+  minimapTextures.update = UpdateMinimapTexture;
+  minimapTextures.destroy = DestroyMinimapTexture;
+  Minimap::SetTextureBackend(minimapTextures);
+
   ImVec4 clear_color = ImVec4(0.00f, 0.00f, 0.00f, 1.00f);
 
   NodeEditor nodeEditor;
 
+  // Power saving: frames are only drawn on input or when something asks for a
+  // repaint. Exposed or resized windows need one too.
+  Repaint::SetWakeHandler(glfwPostEmptyEvent);
+  glfwSetWindowRefreshCallback(window,
+                               [](GLFWwindow *) { Repaint::Request(); });
+
   while (!glfwWindowShouldClose(window)) {
-    // Poll and handle events (inputs, window resize, etc.)
-    glfwPollEvents();
+    // Poll and handle events (inputs, window resize, etc.), sleeping until
+    // there are some if no frame is due
+    double wait = Repaint::TimeUntilDue();
+    if (wait < 0)
+      glfwWaitEvents();
+    else if (wait > 0)
+      glfwWaitEventsTimeout(wait);
+    else
+      glfwPollEvents();
+
+    // The backend queues every input event for ImGui
+    if (!ImGui::GetCurrentContext()->InputEventsQueue.empty())
+      Repaint::Request();
+    if (!Repaint::BeginFrame())
+      continue;
+    Profiler::NewFrame();
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
@@ -92,9 +154,17 @@ int Logicarium::Mainloop() {
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
     glfwSwapBuffers(window);
+
+    // Blinking text cursor and key repeat animate without input events
+    if (io.WantTextInput)
+      Repaint::Within(0.4);
+    if (AnyKeyHeld())
+      Repaint::Within(io.KeyRepeatRate);
   }
 
-  // Cleanup
+  // Cleanup. The GL context takes the minimap texture with it; the editor
+  // outlives it, so it must not try to free the texture itself.
+  Minimap::SetTextureBackend({});
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
@@ -1,8 +1,28 @@
 #include "Gates.hpp"
 
 namespace Logicarium {
-std::vector<std::function<Gate *()>> availableGates{
-    []() -> Gate * { return new AND(); },
-    []() -> Gate * { return new NOT(); },
-};
+std::vector<PaletteEntry> BuiltinGatePalette() {
+  return {
+      MakePaletteEntry(
+          [](NodeArena &arena) -> Node * { return arena.Create<AND>(); }),
+      MakePaletteEntry(
+          [](NodeArena &arena) -> Node * { return arena.Create<NOT>(); }),
+  };
+}
+
+PaletteEntry MakeGatePaletteEntry(const LazyGateDefinition &def) {
+  GateSummary summary = def.Summary();
+  PaletteEntry entry;
+  entry.name = summary.name;
+  entry.icon = MakePaletteIcon(summary.name);
+  entry.color = summary.color;
+  entry.inputCount = summary.inputCount;
+  entry.outputCount = summary.outputCount;
+  entry.create = [def](NodeArena &arena) -> Node * {
+    return arena.Create<CustomGate>(def.Get());
+  };
+  return entry;
+}
+
+std::vector<PaletteEntry> availableGates = BuiltinGatePalette();
 } // namespace Logicarium
@@ -1,14 +1,22 @@
 #pragma once
 
 #include "Gate.hpp"
+#include "Palette.hpp"
 
 #include "AND.hpp"
 #include "CustomGate.hpp"
 #include "NOT.hpp"
 #include "PlaceholderGate.hpp"
+#include "WordGate.hpp"
 
 #include <functional>
 
 namespace Logicarium {
-extern std::vector<std::function<Gate *()>> availableGates;
-}
+extern std::vector<PaletteEntry> availableGates;
+
+// Palette entries for the built-in gates, in dock order
+std::vector<PaletteEntry> BuiltinGatePalette();
+// Palette entry for a custom gate, read from its summary so a gate that isn't
+// built yet stays that way until it is placed
+PaletteEntry MakeGatePaletteEntry(const LazyGateDefinition &def);
+} // namespace Logicarium
@@ -17,7 +17,7 @@ bool AND::AND_F(const std::vector<bool> &input, const int &pinCount) {
   return current;
 }
 
-bool AND::Evaluate(const std::string &slot) {
+bool AND::Evaluate(int slot) {
   if (isEvaluating || lastEvaluatedFrame == GlobalFrameCount)
     return value;
 
@@ -28,9 +28,9 @@ bool AND::Evaluate(const std::string &slot) {
     value = EvaluateExpression();
   } else {
     std::vector<bool> input;
-    for (const auto &cn : connections)
-      if (cn.inputNode == this)
-        input.push_back(((Node *)cn.outputNode)->Evaluate(cn.outputSlot));
+    for (int i = 0; i < inputSlotCount; ++i)
+      if (drivers[i].node)
+        input.push_back(InputValue(i));
 
     value = AND_F(input, inputSlotCount);
   }
@@ -8,6 +8,6 @@ public:
   AND();
   static bool AND_F(const std::vector<bool> &input, const int &pinCount);
 
-  bool Evaluate(const std::string &slot = "") override;
+  bool Evaluate(int slot = 0) override;
 };
 } // namespace Logicarium
@@ -4,53 +4,166 @@
 #include "AND.hpp"
 #include "NOT.hpp"
 #include "PlaceholderGate.hpp"
+#include "WordGate.hpp"
 #include <cstdlib>
 
 namespace Logicarium {
 
-std::map<std::string, GateDefinition> CustomGate::GateRegistry;
+GateTable CustomGate::GateRegistry;
 
-Node *CreateNodeByType(const std::string &type) {
-  if (type == "AND")
-    return new AND();
-  if (type == "NOT")
-    return new NOT();
-  if (type == "In")
-    return new PinIn();
-  if (type == "Out")
-    return new PinOut();
+GateSummary Summarize(const GateDefinition &def) {
+  GateSummary summary;
+  summary.name = def.name;
+  summary.color = def.color;
+  // CustomGate exposes one slot per interface pin node
+  for (const auto &nodeDef : def.nodes) {
+    if (nodeDef.type == "In")
+      summary.inputCount++;
+    else if (nodeDef.type == "Out")
+      summary.outputCount++;
+  }
+  return summary;
+}
 
-  // Check Custom Gate Registry
-  if (CustomGate::GateRegistry.count(type)) {
-    return new CustomGate(CustomGate::GateRegistry[type]);
+LazyGateDefinition::LazyGateDefinition(GateDefinitionRef def)
+    : state(std::make_shared<State>()) {
+  state->def = std::move(def);
+  state->built = true;
+}
+
+LazyGateDefinition::LazyGateDefinition(
+    std::shared_ptr<const GateDefinitionSource> source, uint32_t index,
+    GateSummary summary)
+    : state(std::make_shared<State>()) {
+  state->source = std::move(source);
+  state->index = index;
+  state->summary = std::move(summary);
+}
+
+const GateDefinitionRef &LazyGateDefinition::Get() const {
+  static const GateDefinitionRef none;
+  if (!state)
+    return none;
+  // Background compiles look gates up in copies of the registry, so two
+  // threads may get here for the same definition at once
+  if (!state->built.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (!state->built.load(std::memory_order_relaxed)) {
+      state->def = state->source->Build(state->index);
+      state->source.reset();
+      state->built.store(true, std::memory_order_release);
+    }
   }
+  return state->def;
+}
+
+bool LazyGateDefinition::Built() const {
+  return state && state->built.load(std::memory_order_acquire);
+}
+
+std::string_view LazyGateDefinition::Name() const {
+  if (!state)
+    return {};
+  if (Built() && state->def)
+    return state->def->name;
+  return state->summary.name;
+}
+
+GateSummary LazyGateDefinition::Summary() const {
+  if (state && Built() && state->def)
+    return Summarize(*state->def);
+  return state ? state->summary : GateSummary();
+}
+
+const GateDefinitionRef &GateTable::Register(GateDefinitionRef def) {
+  return Register(LazyGateDefinition(std::move(def))).Get();
+}
+
+const LazyGateDefinition &GateTable::Register(LazyGateDefinition def) {
+  Symbol type = SymbolTable::Intern(def.Name());
+  if (type >= byType.size())
+    byType.resize(type + 1);
+  byType[type] = std::move(def);
+  return byType[type];
+}
+
+Node *CreateNodeByType(NodeArena &arena, Symbol type) {
+  switch (type) {
+  case Sym::AND:
+    return arena.Create<AND>();
+  case Sym::NOT:
+    return arena.Create<NOT>();
+  case Sym::In:
+    return arena.Create<PinIn>();
+  case Sym::Out:
+    return arena.Create<PinOut>();
+  }
+
+  // Check Custom Gate Registry
+  if (const auto &def = CustomGate::GateRegistry.Find(type))
+    return arena.Create<CustomGate>(def);
+
+  // Word-wide gates that bus expressions in defines lower to
+  WordGate::Op op;
+  int width;
+  if (type != NoSymbol &&
+      WordGate::ParseTypeName(SymbolTable::Name(type), op, width))
+    return arena.Create<WordGate>(op, width);
 
   return nullptr;
 }
 
-Node *CreateNodeByTypeOrPlaceholder(const std::string &type, int inputHint,
-                                    int outputHint) {
+Node *CreateNodeByType(NodeArena &arena, std::string_view type) {
+  Symbol symbol = SymbolTable::Find(type);
+  // Word gate names are only interned once the first such gate is made
+  WordGate::Op op;
+  int width;
+  if (symbol == NoSymbol && WordGate::ParseTypeName(type, op, width))
+    return arena.Create<WordGate>(op, width);
+  return CreateNodeByType(arena, symbol);
+}
+
+Node *CreateNodeByTypeOrPlaceholder(NodeArena &arena, std::string_view type,
+                                    int inputHint, int outputHint) {
   // Try to create the real node first
-  Node *node = CreateNodeByType(type);
+  Node *node = CreateNodeByType(arena, type);
   if (node)
     return node;
 
   // If type not found, create a placeholder
-  return new PlaceholderGate(type, inputHint, outputHint);
+  return arena.Create<PlaceholderGate>(std::string(type), inputHint,
+                                       outputHint);
 }
 
-CustomGate::CustomGate(const GateDefinition &def)
-    : Gate(def.name.c_str(), {}, {}), definition(def) {
-  title = _strdup(def.name.c_str()); // ImNodes needs a char*
+CustomGate::CustomGate(GateDefinitionRef defRef)
+    : Gate(defRef->name.c_str(), {}, {}), definition(std::move(defRef)) {
+  const GateDefinition &def = *definition;
 
   // 1. Create Internal Nodes
   std::map<int, Node *> nodeMap; // Map definition ID to actual Node*
 
+  // Every instance has its own arena, so size each pool to what this
+  // definition puts in it rather than the default first chunk. Custom and
+  // word gates of any name share one pool each; count them together, which
+  // bounds both.
+  enum { PoolAND, PoolNOT, PoolIn, PoolOut, PoolOther, PoolKinds };
+  auto poolKind = [](const std::string &type) {
+    return type == "AND"   ? PoolAND
+           : type == "NOT" ? PoolNOT
+           : type == "In"  ? PoolIn
+           : type == "Out" ? PoolOut
+                           : PoolOther;
+  };
+  uint32_t poolSlots[PoolKinds] = {};
+  for (const auto &nodeDef : def.nodes)
+    poolSlots[poolKind(nodeDef.type)]++;
+
   for (const auto &nodeDef : def.nodes) {
-    Node *newNode = CreateNodeByType(nodeDef.type);
+    internalArena.SetFirstChunkSlots(poolSlots[poolKind(nodeDef.type)]);
+    Node *newNode = CreateNodeByType(internalArena, nodeDef.type);
     if (newNode) {
-      // newNode->pos = nodeDef.pos; // Position doesn't matter for logic, only
-      // for editing if we allowed opening it
+      // Only used when the instance is opened in the editor
+      newNode->pos = nodeDef.pos;
       internalNodes.push_back(newNode);
       nodeMap[nodeDef.id] = newNode;
 
@@ -61,6 +174,8 @@ CustomGate::CustomGate(const GateDefinition &def)
       }
     }
   }
+  // Nodes added later, when the gate is edited, grow the pools as usual
+  internalArena.SetFirstChunkSlots(NodeArena::DefaultFirstChunkSlots);
 
   // 2. Setup External Slots based on PinIn/PinOut counts
   // Sort internalInputs/Outputs based on some logic (e.g., Y position) if
@@ -76,95 +191,60 @@ CustomGate::CustomGate(const GateDefinition &def)
   for (int i = 0; i < inputSlotCount; ++i) {
     // Use custom pin names if defined (from script), otherwise indexed names
     if (i < (int)def.inputPinNames.size() && !def.inputPinNames[i].empty()) {
-      inputSlots[i] = {strdup(def.inputPinNames[i].c_str()), 1};
+      inputSlots[i] = {SymbolTable::InternedName(def.inputPinNames[i]), 1};
     } else {
       char buf[16];
       if (inputSlotCount == 1)
         sprintf(buf, "in");
       else
         sprintf(buf, "in%d", i);
-      inputSlots[i] = {strdup(buf), 1};
+      inputSlots[i] = {SymbolTable::InternedName(buf), 1};
     }
   }
   for (int i = 0; i < outputSlotCount; ++i) {
     // Use custom pin names if defined (from script), otherwise indexed names
     if (i < (int)def.outputPinNames.size() && !def.outputPinNames[i].empty()) {
-      outputSlots[i] = {strdup(def.outputPinNames[i].c_str()), 1};
+      outputSlots[i] = {SymbolTable::InternedName(def.outputPinNames[i]), 1};
     } else {
       char buf[16];
       if (outputSlotCount == 1)
         sprintf(buf, "out");
       else
         sprintf(buf, "out%d", i);
-      outputSlots[i] = {strdup(buf), 1};
+      outputSlots[i] = {SymbolTable::InternedName(buf), 1};
     }
   }
 
-  // 3. Create Internal Connections
-  for (const auto &connDef : definition.connections) {
-    if (nodeMap.count(connDef.inputNodeId) &&
-        nodeMap.count(connDef.outputNodeId)) {
-      Connection conn;
-      conn.inputNode = nodeMap[connDef.inputNodeId];
-      conn.inputSlot = connDef.inputSlot.c_str();
-      conn.outputNode = nodeMap[connDef.outputNodeId];
-      conn.outputSlot = connDef.outputSlot.c_str();
-
-      // Link them virtually
-      ((Node *)conn.inputNode)->connections.push_back(conn);
-      ((Node *)conn.outputNode)->connections.push_back(conn);
-
-      internalConnections.push_back(conn);
-    }
-  }
-}
+  drivers.resize(inputSlotCount);
+  outputCache.assign(outputSlotCount, false);
 
-CustomGate::~CustomGate() {
-  // Delete internal nodes first
-  for (auto node : internalNodes) {
-    delete node;
-  }
-  // Free strdup'd slot names
-  for (auto &slot : inputSlots) {
-    if (slot.title)
-      free((void *)slot.title);
-  }
-  for (auto &slot : outputSlots) {
-    if (slot.title)
-      free((void *)slot.title);
+  // 3. Create Internal Connections (slot names resolved to indices once here)
+  Wires::Unlogged unlogged;
+  for (const auto &connDef : def.connections) {
+    auto inIt = nodeMap.find(connDef.inputNodeId);
+    auto outIt = nodeMap.find(connDef.outputNodeId);
+    if (inIt != nodeMap.end() && outIt != nodeMap.end()) {
+      Node *inNode = inIt->second;
+      Node *outNode = outIt->second;
+      Wires::Connect(outNode, outNode->FindOutputSlot(connDef.outputSlot.c_str()),
+                     inNode, inNode->FindInputSlot(connDef.inputSlot.c_str()));
+    }
   }
-  // Free strdup'd title last
-  if (title)
-    free((void *)title);
 }
 
-bool CustomGate::Evaluate(const std::string &slot) {
-  if (isEvaluating) {
-    return outputCache[slot]; // Simple cycle break
-  }
+bool CustomGate::Evaluate(int slot) {
+  if (slot < 0 || slot >= (int)outputCache.size())
+    return false;
 
-  if (lastEvaluatedFrame == Node::GlobalFrameCount) {
-    if (slot.empty() && !internalOutputs.empty()) {
-      return outputCache[outputSlots[0].title];
-    }
-    return outputCache[slot];
+  if (isEvaluating || lastEvaluatedFrame == Node::GlobalFrameCount) {
+    return outputCache[slot]; // Cached, or simple cycle break
   }
 
   isEvaluating = true;
 
   // Step A: Update Internal PinIns from external connections
-  for (int i = 0; i < inputSlots.size(); ++i) {
-    bool slotValue = false;
-    const char *slotName = inputSlots[i].title;
-
-    for (const auto &conn : connections) {
-      if (conn.inputNode == this && !conn.inputSlot.empty() &&
-          strcmp(conn.inputSlot.c_str(), slotName) == 0) {
-        Node *source = (Node *)conn.outputNode;
-        slotValue = source->Evaluate(conn.outputSlot); // Pull from source slot
-        break;
-      }
-    }
+  for (int i = 0; i < inputSlotCount; ++i) {
+    bool slotValue = InputValue(i); // Pull from source slot
 
     if (i < (int)internalInputs.size()) {
       internalInputs[i]->value = slotValue;
@@ -182,22 +262,14 @@ bool CustomGate::Evaluate(const std::string &slot) {
   // For complex circuits with feedback, we might still want multiple passes,
   // but for DAGs, one recursive pull per output is correct.
   for (int i = 0; i < (int)internalOutputs.size(); ++i) {
-    bool val = internalOutputs[i]->Evaluate(); // Pulls through internal logic
-    outputCache[outputSlots[i].title] = val;
+    outputCache[i] = internalOutputs[i]->Evaluate(); // Pulls through internal logic
   }
 
-  // Handle empty name or default
-  if (!internalOutputs.empty()) {
-    value = outputCache[outputSlots[0].title];
-  } else {
-    value = false;
-  }
+  value = outputCache[0];
 
   lastEvaluatedFrame = Node::GlobalFrameCount;
   isEvaluating = false;
 
-  if (slot.empty())
-    return value;
   return outputCache[slot];
 }
 
@@ -3,8 +3,12 @@
 #include "../Special/PinIn.hpp"
 #include "../Special/PinOut.hpp"
 #include "Gate.hpp"
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Logicarium {
@@ -37,31 +41,116 @@ struct GateDefinition {
       true; // True if defined via script, false when saved to library
 };
 
-Node *CreateNodeByType(const std::string &type);
-Node *CreateNodeByTypeOrPlaceholder(const std::string &type, int inputHint = 1,
-                                    int outputHint = 1);
+// Definitions are immutable once registered. The registry, the gate library,
+// palette entries and every CustomGate built from one share a single copy. To
+// change a definition, copy it, edit the copy and register the result; gates
+// built from the previous version keep that one alive until they go away.
+using GateDefinitionRef = std::shared_ptr<const GateDefinition>;
+
+// What the palette shows for a definition. Library files record it, so a
+// library's gates can be listed without building any of them.
+struct GateSummary {
+  std::string name;
+  ImU32 color = 0;
+  int inputCount = 0;  // Interface pins, i.e. In nodes
+  int outputCount = 0; // Out nodes
+};
+GateSummary Summarize(const GateDefinition &def);
+
+// Builds definitions on demand, e.g. out of a library file that is mapped
+// rather than read
+class GateDefinitionSource {
+public:
+  virtual ~GateDefinitionSource() = default;
+  // Called at most once per index, possibly from a background thread
+  virtual GateDefinitionRef Build(uint32_t index) const = 0;
+};
+
+// A definition that may not be built yet: either one already in memory or one
+// a source builds the first time Get() is called. Copies share one state, so
+// whichever copy builds it builds it for all of them, and the source is let go
+// once that has happened.
+class LazyGateDefinition {
+public:
+  LazyGateDefinition() = default;
+  LazyGateDefinition(GateDefinitionRef def);
+  LazyGateDefinition(std::shared_ptr<const GateDefinitionSource> source,
+                     uint32_t index, GateSummary summary);
+
+  // Null ref for a default-constructed one
+  const GateDefinitionRef &Get() const;
+  bool Built() const;
+  // Neither of these builds the definition
+  std::string_view Name() const;
+  GateSummary Summary() const;
+
+  explicit operator bool() const { return state != nullptr; }
+
+private:
+  struct State {
+    std::mutex mutex;
+    std::atomic<bool> built{false};
+    GateDefinitionRef def;
+    std::shared_ptr<const GateDefinitionSource> source;
+    uint32_t index = 0;
+    GateSummary summary; // Only for one from a source
+  };
+  std::shared_ptr<State> state;
+};
+
+// Gate definitions keyed by interned type name. Symbols are small dense
+// integers, so the table is a flat array indexed by symbol: a lookup is a
+// bounds check and a few loads, with no hashing or string compares.
+class GateTable {
+public:
+  // Null ref when nothing is registered under that type
+  const GateDefinitionRef &Find(Symbol type) const {
+    static const GateDefinitionRef none;
+    return type < byType.size() ? byType[type].Get() : none;
+  }
+  // Does not intern: names that were never registered simply miss
+  const GateDefinitionRef &Find(std::string_view name) const {
+    return Find(SymbolTable::Find(name));
+  }
+  // Adds or replaces the definition registered under def->name
+  const GateDefinitionRef &Register(GateDefinitionRef def);
+  const GateDefinitionRef &Register(GateDefinition def) {
+    return Register(std::make_shared<const GateDefinition>(std::move(def)));
+  }
+  // Same for one not built yet; Find builds it the first time it is asked
+  // for it
+  const LazyGateDefinition &Register(LazyGateDefinition def);
+
+private:
+  std::vector<LazyGateDefinition> byType;
+};
+
+Node *CreateNodeByType(NodeArena &arena, Symbol type);
+Node *CreateNodeByType(NodeArena &arena, std::string_view type);
+Node *CreateNodeByTypeOrPlaceholder(NodeArena &arena, std::string_view type,
+                                    int inputHint = 1, int outputHint = 1);
 
 class CustomGate : public Gate {
 public:
-  CustomGate(const GateDefinition &def);
-  ~CustomGate();
+  CustomGate(GateDefinitionRef def);
 
-  bool Evaluate(const std::string &slot = "") override;
-  ImU32 GetColor() const override { return definition.color; }
+  bool Evaluate(int slot = 0) override;
+  ImU32 GetColor() const override { return definition->color; }
+  const GateDefinitionRef &Definition() const { return definition; }
 
-  // Members to hold the internal state
+  // Members to hold the internal state (owned by internalArena)
+  NodeArena internalArena;
   std::vector<Node *> internalNodes;
-  std::vector<Connection> internalConnections;
 
   // Pointers to the interface pins within internalNodes
   std::vector<PinIn *> internalInputs;
   std::vector<PinOut *> internalOutputs;
 
   // Registry for all custom gates
-  static std::map<std::string, GateDefinition> GateRegistry;
+  static GateTable GateRegistry;
 
 private:
-  GateDefinition definition;
-  std::map<std::string, bool> outputCache;
+  GateDefinitionRef definition;
+  std::vector<bool> outputCache; // Indexed by output slot
 };
 } // namespace Logicarium
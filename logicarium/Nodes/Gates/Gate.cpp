@@ -3,24 +3,26 @@
 #include <string>
 
 namespace Logicarium {
-extern Node *nodeToDuplicate;
-extern Node *nodeToEdit;
-extern Node *nodeToDelete;
-extern Node *nodeToSaveGate; // Gate to save permanently
+extern NodeHandle nodeToDuplicate;
+extern NodeHandle nodeToEdit;
+extern NodeHandle nodeToDelete;
+extern NodeHandle nodeToSaveGate; // Gate to save permanently
 extern bool nodeHoveredForContextMenu;
+extern bool wiringLocked;
 
 Gate::Gate(const char *_title, std::vector<ImNodes::Ez::SlotInfo> &&_inputSlots,
            std::vector<ImNodes::Ez::SlotInfo> &&_outputSlots)
     : Node(_title, std::move(_inputSlots), std::move(_outputSlots)) {}
 
 ImU32 Gate::GetColor() const {
-  std::string t = title;
-  if (t == "AND")
+  switch (type) {
+  case Sym::AND:
     return IM_COL32(10, 30, 60, 255);
-  if (t == "NOT")
+  case Sym::NOT:
     return IM_COL32(80, 20, 20, 255);
-  if (t == "NAND")
+  case Sym::NAND:
     return IM_COL32(40, 10, 80, 255);
+  }
   return Node::GetColor();
 }
 
@@ -52,65 +54,13 @@ void Gate::Render() {
     // Handle new connections
     void *inNode, *outNode;
     const char *inSlot, *outSlot;
-    if (ImNodes::GetNewConnection(&inNode, &inSlot, &outNode, &outSlot)) {
-      Connection new_connection;
-      new_connection.inputNode = inNode;
-      new_connection.inputSlot = inSlot;
-      new_connection.outputNode = outNode;
-      new_connection.outputSlot = outSlot;
-
-      Node *inputNode = (Node *)new_connection.inputNode;
-      Connection existingConnection = {};
-      bool foundExisting = false;
-
-      for (const auto &conn : inputNode->connections) {
-        if (conn.inputNode == inputNode &&
-            conn.inputSlot == new_connection.inputSlot) {
-          existingConnection = conn;
-          foundExisting = true;
-          break;
-        }
-      }
-
-      if (foundExisting) {
-        ((Node *)existingConnection.outputNode)
-            ->DeleteConnection(existingConnection);
-        inputNode->DeleteConnection(existingConnection);
-      }
-
-      ((Node *)new_connection.inputNode)->connections.push_back(new_connection);
-      ((Node *)new_connection.outputNode)
-          ->connections.push_back(new_connection);
-    }
-
-    // Render output connections
-    for (const Connection &connection : connections) {
-      if (connection.outputNode != this)
-        continue;
-
-      bool signal = Evaluate(connection.outputSlot);
-      ImColor activeColor = IM_COL32(50, 255, 150, 255);
-      ImColor inactiveColor = IM_COL32(80, 90, 100, 255);
-
-      auto *canvas = ImNodes::GetCurrentCanvas();
-      ImColor originalConnectionColor = canvas->Colors[ImNodes::ColConnection];
-
-      // Check if both nodes are selected for connection highlighting
-      bool bothSelected = selected && ((Node *)connection.inputNode)->selected;
-      if (bothSelected) {
-        canvas->Colors[ImNodes::ColConnection] = IM_COL32(0, 200, 255, 255);
-      } else {
-        canvas->Colors[ImNodes::ColConnection] =
-            signal ? activeColor : inactiveColor;
-      }
-
-      if (!ImNodes::Connection(
-              connection.inputNode, connection.inputSlot.c_str(),
-              connection.outputNode, connection.outputSlot.c_str())) {
-        ((Node *)connection.inputNode)->DeleteConnection(connection);
-        ((Node *)connection.outputNode)->DeleteConnection(connection);
-      }
-      canvas->Colors[ImNodes::ColConnection] = originalConnectionColor;
+    if (ImNodes::GetNewConnection(&inNode, &inSlot, &outNode, &outSlot) &&
+        !wiringLocked) {
+      Node *inputNode = (Node *)inNode;
+      Node *outputNode = (Node *)outNode;
+      // Connect() replaces any wire already driving the input
+      Wires::Connect(outputNode, outputNode->FindOutputSlot(outSlot), inputNode,
+                     inputNode->FindInputSlot(inSlot));
     }
   }
 
@@ -122,31 +72,38 @@ void Gate::Render() {
   }
 
   if (ImGui::BeginPopupContextItem()) {
-    if (ImGui::MenuItem("Duplicate")) {
-      nodeToDuplicate = this;
+    if (ImGui::MenuItem("Duplicate", nullptr, false, !wiringLocked)) {
+      nodeToDuplicate = handle;
     }
-    if (std::string(title) != "In" && std::string(title) != "Out") {
-      bool isCustom = CustomGate::GateRegistry.count(title);
-      bool isTemporary =
-          isCustom && CustomGate::GateRegistry[title].isTemporary;
+    if (type != Sym::In && type != Sym::Out) {
+      const auto &def = CustomGate::GateRegistry.Find(type);
+      bool isCustom = def != nullptr;
+      bool isTemporary = isCustom && def->isTemporary;
+
+      if (isCustom) {
+        // Steps into this instance, showing its internals with live values
+        if (ImGui::MenuItem("Open Circuit", "E")) {
+          nodeToEdit = handle;
+        }
+      }
 
-      if (isCustom && isTemporary) {
+      if (isCustom && isTemporary && !wiringLocked) {
         // Show "Save Gate" for temporary (script-defined) custom gates
         if (ImGui::MenuItem("Save Gate")) {
-          nodeToSaveGate = this;
+          nodeToSaveGate = handle;
         }
       }
 
-      if (!isTemporary) {
-        // Only show Edit Circuit/Logic for saved gates
-        if (ImGui::MenuItem(isCustom ? "Edit Circuit" : "Edit Logic")) {
-          nodeToEdit = this;
+      if (!isCustom && !isTemporary && !wiringLocked) {
+        // Only show Edit Logic for saved gates
+        if (ImGui::MenuItem("Edit Logic")) {
+          nodeToEdit = handle;
         }
       }
     }
     ImGui::Separator();
-    if (ImGui::MenuItem("Delete", "Del")) {
-      nodeToDelete = this;
+    if (ImGui::MenuItem("Delete", "Del", false, !wiringLocked)) {
+      nodeToDelete = handle;
     }
     ImGui::EndPopup();
   }
@@ -161,16 +118,7 @@ bool Gate::EvaluateExpression() {
   // 1. Get current input values
   std::map<std::string, bool> inputs;
   for (int i = 0; i < inputSlotCount; ++i) {
-    std::string name = inputSlots[i].title;
-
-    bool val = false;
-    for (const auto &conn : connections) {
-      if (conn.inputNode == this && conn.inputSlot == name) {
-        val = ((Node *)conn.outputNode)->Evaluate(conn.outputSlot);
-        break;
-      }
-    }
-    inputs[name] = val;
+    inputs[inputSlots[i].title] = InputValue(i);
   }
 
   // 2. Simple recursive descent if possible, or just a basic replace-and-eval
@@ -11,7 +11,7 @@ bool NOT::NOT_F(const std::vector<bool> &input, const int &) {
   return !input[0];
 }
 
-bool NOT::Evaluate(const std::string &slot) {
+bool NOT::Evaluate(int slot) {
   if (isEvaluating || lastEvaluatedFrame == GlobalFrameCount)
     return value;
 
@@ -21,9 +21,9 @@ bool NOT::Evaluate(const std::string &slot) {
     value = EvaluateExpression();
   } else {
     std::vector<bool> input;
-    for (const auto &cn : connections)
-      if (cn.inputNode == this)
-        input.push_back(((Node *)cn.outputNode)->Evaluate(cn.outputSlot));
+    for (int i = 0; i < inputSlotCount; ++i)
+      if (drivers[i].node)
+        input.push_back(InputValue(i));
 
     value = NOT_F(input, inputSlotCount);
   }
@@ -8,6 +8,6 @@ public:
   NOT();
   static bool NOT_F(const std::vector<bool> &input, const int &);
 
-  bool Evaluate(const std::string &slot = "") override;
+  bool Evaluate(int slot = 0) override;
 };
 } // namespace Logicarium
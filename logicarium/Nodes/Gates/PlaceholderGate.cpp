@@ -6,16 +6,16 @@
 
 namespace Logicarium {
 
-extern Node *nodeToDuplicate;
-extern Node *nodeToDelete;
+extern NodeHandle nodeToDuplicate;
+extern NodeHandle nodeToDelete;
 extern bool nodeHoveredForContextMenu;
+extern bool wiringLocked;
 
 PlaceholderGate::PlaceholderGate(const std::string &typeName, int inputs,
                                  int outputs)
     : Gate(typeName.c_str(), {}, {}), missingTypeName(typeName) {
 
-  // Store the original type name as title (will be displayed with "?" prefix)
-  title = _strdup(typeName.c_str());
+  // The original type name is the title (displayed with a "?" prefix)
 
   // Setup slots based on provided counts
   inputSlotCount = inputs;
@@ -23,6 +23,7 @@ PlaceholderGate::PlaceholderGate(const std::string &typeName, int inputs,
 
   inputSlots.resize(inputSlotCount);
   outputSlots.resize(outputSlotCount);
+  drivers.resize(inputSlotCount);
 
   for (int i = 0; i < inputSlotCount; ++i) {
     char buf[16];
@@ -30,7 +31,7 @@ PlaceholderGate::PlaceholderGate(const std::string &typeName, int inputs,
       sprintf(buf, "in");
     else
       sprintf(buf, "in%d", i);
-    inputSlots[i] = {strdup(buf), 1};
+    inputSlots[i] = {SymbolTable::InternedName(buf), 1};
   }
 
   for (int i = 0; i < outputSlotCount; ++i) {
@@ -39,26 +40,11 @@ PlaceholderGate::PlaceholderGate(const std::string &typeName, int inputs,
       sprintf(buf, "out");
     else
       sprintf(buf, "out%d", i);
-    outputSlots[i] = {strdup(buf), 1};
+    outputSlots[i] = {SymbolTable::InternedName(buf), 1};
   }
 }
 
-PlaceholderGate::~PlaceholderGate() {
-  // Free strdup'd slot names
-  for (auto &slot : inputSlots) {
-    if (slot.title)
-      free((void *)slot.title);
-  }
-  for (auto &slot : outputSlots) {
-    if (slot.title)
-      free((void *)slot.title);
-  }
-  // Free strdup'd title
-  if (title)
-    free((void *)title);
-}
-
-bool PlaceholderGate::Evaluate(const std::string &slot) {
+bool PlaceholderGate::Evaluate(int slot) {
   // Placeholder gates always return false (safe default)
   value = false;
   return false;
@@ -69,6 +55,11 @@ ImU32 PlaceholderGate::GetColor() const {
   return IM_COL32(120, 40, 40, 255);
 }
 
+ImU32 PlaceholderGate::GetWireColor(int slot) {
+  // Muted, since the gate doesn't evaluate
+  return IM_COL32(100, 80, 80, 180);
+}
+
 void PlaceholderGate::Render() {
   ImU32 color = GetColor();
   ImU32 borderColor = IM_COL32(200, 80, 80, 255); // Red border
@@ -97,61 +88,12 @@ void PlaceholderGate::Render() {
     // Handle new connections (same as Gate::Render)
     void *inNode, *outNode;
     const char *inSlot, *outSlot;
-    if (ImNodes::GetNewConnection(&inNode, &inSlot, &outNode, &outSlot)) {
-      Connection new_connection;
-      new_connection.inputNode = inNode;
-      new_connection.inputSlot = inSlot;
-      new_connection.outputNode = outNode;
-      new_connection.outputSlot = outSlot;
-
-      Node *inputNode = (Node *)new_connection.inputNode;
-      Connection existingConnection = {};
-      bool foundExisting = false;
-
-      for (const auto &conn : inputNode->connections) {
-        if (conn.inputNode == inputNode &&
-            conn.inputSlot == new_connection.inputSlot) {
-          existingConnection = conn;
-          foundExisting = true;
-          break;
-        }
-      }
-
-      if (foundExisting) {
-        ((Node *)existingConnection.outputNode)
-            ->DeleteConnection(existingConnection);
-        inputNode->DeleteConnection(existingConnection);
-      }
-
-      ((Node *)new_connection.inputNode)->connections.push_back(new_connection);
-      ((Node *)new_connection.outputNode)
-          ->connections.push_back(new_connection);
-    }
-
-    // Render connections (grayed out since gate doesn't work)
-    for (const Connection &connection : connections) {
-      if (connection.outputNode != this)
-        continue;
-
-      auto *canvas = ImNodes::GetCurrentCanvas();
-      ImColor originalColor = canvas->Colors[ImNodes::ColConnection];
-
-      // Gray/muted connection color to indicate inactive
-      bool bothSelected = selected && ((Node *)connection.inputNode)->selected;
-      if (bothSelected) {
-        canvas->Colors[ImNodes::ColConnection] = IM_COL32(0, 200, 255, 255);
-      } else {
-        canvas->Colors[ImNodes::ColConnection] = IM_COL32(100, 80, 80, 180);
-      }
-
-      if (!ImNodes::Connection(
-              connection.inputNode, connection.inputSlot.c_str(),
-              connection.outputNode, connection.outputSlot.c_str())) {
-        ((Node *)connection.inputNode)->DeleteConnection(connection);
-        ((Node *)connection.outputNode)->DeleteConnection(connection);
-      }
-
-      canvas->Colors[ImNodes::ColConnection] = originalColor;
+    if (ImNodes::GetNewConnection(&inNode, &inSlot, &outNode, &outSlot) &&
+        !wiringLocked) {
+      Node *inputNode = (Node *)inNode;
+      Node *outputNode = (Node *)outNode;
+      Wires::Connect(outputNode, outputNode->FindOutputSlot(outSlot), inputNode,
+                     inputNode->FindInputSlot(inSlot));
     }
   }
 
@@ -171,11 +113,11 @@ void PlaceholderGate::Render() {
   // Simplified context menu (no Edit option since we can't edit a missing gate)
   if (ImGui::BeginPopupContextItem()) {
     if (ImGui::MenuItem("Duplicate")) {
-      nodeToDuplicate = this;
+      nodeToDuplicate = handle;
     }
     ImGui::Separator();
     if (ImGui::MenuItem("Delete", "Del")) {
-      nodeToDelete = this;
+      nodeToDelete = handle;
     }
     ImGui::EndPopup();
   }
@@ -13,11 +13,11 @@ namespace Logicarium {
 class PlaceholderGate : public Gate {
 public:
   PlaceholderGate(const std::string &missingTypeName, int inputs, int outputs);
-  ~PlaceholderGate();
 
-  bool Evaluate(const std::string &slot = "") override;
+  bool Evaluate(int slot = 0) override;
   void Render() override;
   ImU32 GetColor() const override;
+  ImU32 GetWireColor(int slot) override;
 
   // The original type name (e.g., "HalfAdder") for later upgrade
   std::string missingTypeName;
@@ -0,0 +1,127 @@
+#include "WordGate.hpp"
+#include <charconv>
+
+namespace Logicarium {
+std::string BusPinName(std::string_view base, int bit) {
+  std::string name(base);
+  name += '[';
+  name += std::to_string(bit);
+  name += ']';
+  return name;
+}
+
+bool SplitBusPin(std::string_view name, std::string_view &base, int &bit) {
+  size_t open = name.find('[');
+  if (open == 0 || open == std::string_view::npos || name.back() != ']')
+    return false;
+  const char *first = name.data() + open + 1;
+  const char *last = name.data() + name.size() - 1;
+  auto result = std::from_chars(first, last, bit);
+  if (result.ec != std::errc() || result.ptr != last || bit < 0)
+    return false;
+  base = name.substr(0, open);
+  return true;
+}
+
+static const char *OpName(WordGate::Op op) {
+  switch (op) {
+  case WordGate::Op::And:
+    return "AND";
+  case WordGate::Op::Or:
+    return "OR";
+  case WordGate::Op::Not:
+    return "NOT";
+  }
+  return "";
+}
+
+static std::vector<ImNodes::Ez::SlotInfo> BusSlots(const char *base,
+                                                   int width) {
+  std::vector<ImNodes::Ez::SlotInfo> slots(width);
+  for (int i = 0; i < width; ++i)
+    slots[i] = {SymbolTable::InternedName(BusPinName(base, i)), 1};
+  return slots;
+}
+
+static std::vector<ImNodes::Ez::SlotInfo> InputSlots(WordGate::Op op,
+                                                     int width) {
+  std::vector<ImNodes::Ez::SlotInfo> slots = BusSlots("a", width);
+  if (op != WordGate::Op::Not) {
+    std::vector<ImNodes::Ez::SlotInfo> b = BusSlots("b", width);
+    slots.insert(slots.end(), b.begin(), b.end());
+  }
+  return slots;
+}
+
+WordGate::WordGate(Op op, int width)
+    : Gate(SymbolTable::InternedName(TypeName(op, width)),
+           InputSlots(op, width), BusSlots("out", width)),
+      op(op), width(width) {}
+
+std::string WordGate::TypeName(Op op, int width) {
+  return std::string(OpName(op)) + "*" + std::to_string(width);
+}
+
+bool WordGate::ParseTypeName(std::string_view type, Op &op, int &width) {
+  size_t star = type.find('*');
+  if (star == std::string_view::npos)
+    return false;
+  std::string_view name = type.substr(0, star);
+  if (name == "AND")
+    op = Op::And;
+  else if (name == "OR")
+    op = Op::Or;
+  else if (name == "NOT")
+    op = Op::Not;
+  else
+    return false;
+  const char *first = type.data() + star + 1;
+  const char *last = type.data() + type.size();
+  auto result = std::from_chars(first, last, width);
+  return result.ec == std::errc() && result.ptr == last && width >= 1 &&
+         width <= MaxWidth;
+}
+
+uint64_t WordGate::Gather(int first) {
+  uint64_t bits = 0;
+  for (int i = 0; i < width; ++i)
+    bits |= (uint64_t)InputValue(first + i) << i;
+  return bits;
+}
+
+bool WordGate::Evaluate(int slot) {
+  if (!isEvaluating && lastEvaluatedFrame != GlobalFrameCount) {
+    isEvaluating = true;
+
+    uint64_t a = Gather(0);
+    switch (op) {
+    case Op::And:
+      word = a & Gather(width);
+      break;
+    case Op::Or:
+      word = a | Gather(width);
+      break;
+    case Op::Not:
+      word = ~a;
+      break;
+    }
+    value = word & 1;
+
+    lastEvaluatedFrame = GlobalFrameCount;
+    isEvaluating = false;
+  }
+  return (word >> slot) & 1;
+}
+
+ImU32 WordGate::GetColor() const {
+  switch (op) {
+  case Op::And:
+    return IM_COL32(10, 30, 60, 255);
+  case Op::Or:
+    return IM_COL32(10, 60, 40, 255);
+  case Op::Not:
+    return IM_COL32(80, 20, 20, 255);
+  }
+  return Gate::GetColor();
+}
+} // namespace Logicarium
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Gate.hpp"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Logicarium {
+// Bit i of a bus named base is the pin "base[i]"
+std::string BusPinName(std::string_view base, int bit);
+// Splits "base[i]" into base and i; false for a name that is not a bus bit
+bool SplitBusPin(std::string_view name, std::string_view &base, int &bit);
+
+// Bitwise operator over a whole bus of up to 64 bits, which script defines
+// lower bus expressions to. Inputs are a[i] (and b[i]), outputs out[i].
+// Evaluating any output computes every bit as one machine-word operation and
+// keeps the word for the rest of the frame, so the other outputs cost a
+// shift. Its type name spells the operator and the width, like "AND*32".
+class WordGate : public Gate {
+public:
+  enum class Op : uint8_t { And, Or, Not };
+  static constexpr int MaxWidth = 64;
+
+  WordGate(Op op, int width);
+
+  bool Evaluate(int slot = 0) override;
+  ImU32 GetColor() const override;
+
+  static std::string TypeName(Op op, int width);
+  // False unless type is a name TypeName returns
+  static bool ParseTypeName(std::string_view type, Op &op, int &width);
+
+  const Op op;
+  const int width;
+
+private:
+  uint64_t word = 0;
+
+  // The inputs from slot first on, packed into a word
+  uint64_t Gather(int first);
+};
+} // namespace Logicarium
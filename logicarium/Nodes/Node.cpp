@@ -4,24 +4,56 @@ namespace Logicarium {
 uint64_t Node::GlobalFrameCount = 0;
 Node::Node(const char *_title, std::vector<ImNodes::Ez::SlotInfo> &&_inputSlots,
            std::vector<ImNodes::Ez::SlotInfo> &&_outputSlots) {
-  title = _title;
+  type = SymbolTable::Intern(_title);
+  title = SymbolTable::Name(type);
   inputSlots = _inputSlots;
   outputSlots = _outputSlots;
 
+  // Slot titles point into the symbol pool, so they can be matched by address
+  for (auto &slot : inputSlots)
+    slot.title = SymbolTable::InternedName(slot.title);
+  for (auto &slot : outputSlots)
+    slot.title = SymbolTable::InternedName(slot.title);
+
   inputSlotCount = static_cast<int>(inputSlots.size());
   outputSlotCount = static_cast<int>(outputSlots.size());
+  drivers.resize(inputSlotCount);
+}
+
+int Node::FindInputSlot(const char *name) const {
+  return FindInputSlot(SymbolTable::Find(name));
 }
 
-void Node::DeleteConnection(const Connection &connection) {
-  for (auto it = connections.begin(); it != connections.end(); ++it) {
-    if (connection == *it) {
-      connections.erase(it);
-      break;
-    }
-  }
+int Node::FindOutputSlot(const char *name) const {
+  return FindOutputSlot(SymbolTable::Find(name));
 }
 
-bool Node::Evaluate(const std::string &slot) {
+int Node::FindInputSlot(Symbol name) const {
+  if (name == NoSymbol)
+    return -1;
+  const char *interned = SymbolTable::Name(name);
+  for (int i = 0; i < inputSlotCount; ++i)
+    if (inputSlots[i].title == interned)
+      return i;
+  return -1;
+}
+
+int Node::FindOutputSlot(Symbol name) const {
+  if (name == NoSymbol)
+    return -1;
+  const char *interned = SymbolTable::Name(name);
+  for (int i = 0; i < outputSlotCount; ++i)
+    if (outputSlots[i].title == interned)
+      return i;
+  return -1;
+}
+
+bool Node::InputValue(int slot) {
+  const Driver &driver = drivers[slot];
+  return driver.node ? driver.node->Evaluate(driver.slot) : false;
+}
+
+bool Node::Evaluate(int slot) {
   if (isEvaluating || lastEvaluatedFrame == GlobalFrameCount)
     return value;
   return value;
@@ -29,6 +61,11 @@ bool Node::Evaluate(const std::string &slot) {
 
 ImU32 Node::GetColor() const { return IM_COL32(40, 40, 45, 255); }
 
+ImU32 Node::GetWireColor(int slot) {
+  return Evaluate(slot) ? IM_COL32(50, 255, 150, 255)
+                        : IM_COL32(80, 90, 100, 255);
+}
+
 void Node::Render() {
   // Default empty render - individual types should override
 }
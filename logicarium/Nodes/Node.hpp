@@ -1,15 +1,21 @@
 #pragma once
 
 #include "Connection.hpp"
+#include "NodeArena.hpp"
+#include "Symbols.hpp"
 #include "pch.hpp"
 #include <string>
 
 namespace Logicarium {
 class Node {
 public:
-  /// Node title
+  /// Node title (interned; the spelling of `type`)
   const char *title = nullptr;
+  /// Interned type name, used for all type comparisons and registry lookups
+  Symbol type = NoSymbol;
   std::string id = "";
+  /// Handle issued by the owning NodeArena
+  NodeHandle handle = NullNodeHandle;
   bool selected = false;
   ImVec2 pos{};
   bool value = false;
@@ -17,19 +23,41 @@ public:
   bool isEvaluating = false;
   static uint64_t GlobalFrameCount;
 
-  std::vector<Connection> connections{};
+  /// One driver per input slot (unconnected inputs have a null node)
+  std::vector<Driver> drivers{};
+  /// Wires leaving this node's output slots
+  std::vector<Connection> fanout{};
   std::vector<ImNodes::Ez::SlotInfo> inputSlots{};
   std::vector<ImNodes::Ez::SlotInfo> outputSlots{};
 
   int inputSlotCount;
   int outputSlotCount;
 
+  /// Layout from the last frame the node was drawn, in canvas units relative
+  /// to pos: lets the editor cull the node and still place its wires
+  ImVec2 size{};
+  std::vector<ImVec2> inputAnchors{};
+  std::vector<ImVec2> outputAnchors{};
+  /// ImGui frame the node was last laid out through ImNodes. It is skipped on
+  /// frames where it is off-screen or the canvas is zoomed out.
+  int laidOutFrame = -1;
+
   Node(const char *title, std::vector<ImNodes::Ez::SlotInfo> &&_inputSlots,
        std::vector<ImNodes::Ez::SlotInfo> &&_outputSlots);
-  void DeleteConnection(const Connection &connection);
   virtual ~Node() = default;
-  virtual bool Evaluate(const std::string &slot = "");
+
+  /// Slot index for a slot title, or -1 if the node has no such slot
+  int FindInputSlot(const char *name) const;
+  int FindOutputSlot(const char *name) const;
+  int FindInputSlot(Symbol name) const;
+  int FindOutputSlot(Symbol name) const;
+  /// Value arriving at an input slot (false when unconnected)
+  bool InputValue(int slot);
+
+  virtual bool Evaluate(int slot = 0);
   virtual void Render();
   virtual ImU32 GetColor() const;
+  /// Color of the wires leaving an output slot
+  virtual ImU32 GetWireColor(int slot);
 };
 } // namespace Logicarium
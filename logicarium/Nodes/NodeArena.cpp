@@ -0,0 +1,148 @@
+#include "NodeArena.hpp"
+#include "Node.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Logicarium {
+// The handle layout can't represent what was asked of it. Carrying on would
+// hand out handles that alias other nodes, so stop here, in every build.
+[[noreturn]] static void HandleLayoutExceeded(const char *what) {
+  fprintf(stderr, "NodeArena: %s\n", what);
+  std::abort();
+}
+
+uint32_t NodeArena::NextPoolIndex() {
+  static std::atomic<uint32_t> next{0};
+  uint32_t index = next++;
+  if (index >= MaxPools)
+    HandleLayoutExceeded("more node types than the handle has pool bits for");
+  return index;
+}
+
+NodeArena::~NodeArena() { Clear(); }
+
+NodeArena::Pool &NodeArena::GetPool(uint32_t index, size_t size, size_t align,
+                                    void (*destroy)(Node *)) {
+  if (index >= pools.size())
+    pools.resize(index + 1);
+  if (!pools[index]) {
+    pools[index] = std::make_unique<Pool>();
+    pools[index]->stride = (size + align - 1) / align * align;
+    pools[index]->destroy = destroy;
+  }
+  return *pools[index];
+}
+
+uint32_t NodeArena::Pool::Allocate(uint32_t firstChunkSlots) {
+  if (!freeList.empty()) {
+    uint32_t slot = freeList.back();
+    freeList.pop_back();
+    return slot;
+  }
+
+  if (used == capacity) {
+    // Each chunk after the first doubles the pool's capacity
+    Chunk chunk;
+    chunk.first = capacity;
+    chunk.capacity = capacity ? capacity : std::max(firstChunkSlots, 1u);
+    if (chunk.first + chunk.capacity > MaxSlotsPerPool)
+      chunk.capacity = MaxSlotsPerPool - chunk.first;
+    if (chunk.capacity == 0)
+      HandleLayoutExceeded("node pool exhausted");
+    chunk.storage.reset(new unsigned char[chunk.capacity * stride]);
+
+    capacity += chunk.capacity;
+    nodes.resize(capacity, nullptr);
+    generations.resize(capacity, 1);
+    chunks.push_back(std::move(chunk));
+  }
+  return used++;
+}
+
+void *NodeArena::Pool::Address(uint32_t slot) const {
+  for (const auto &chunk : chunks)
+    if (slot < chunk.first + chunk.capacity)
+      return chunk.storage.get() + (size_t)(slot - chunk.first) * stride;
+  return nullptr;
+}
+
+bool NodeArena::Pool::Release(uint32_t slot) {
+  destroy(nodes[slot]);
+  nodes[slot] = nullptr;
+  // Reusing the slot at a wrapped generation would let handles to its first
+  // nodes resolve to a later one. Generation 0 marks it retired; no handle
+  // carries that, so lookups of old ones keep failing.
+  return ++generations[slot] != 0;
+}
+
+void NodeArena::Destroy(Node *node) {
+  if (!node)
+    return;
+  NodeHandle handle = node->handle;
+  assert(Get(handle) == node && "node does not belong to this arena");
+
+  uint32_t poolIndex = handle >> (IndexBits + GenerationBits);
+  uint32_t slot = handle & (MaxSlotsPerPool - 1);
+  Pool &pool = *pools[poolIndex];
+  if (pool.Release(slot))
+    pool.freeList.push_back(slot);
+  --liveCount;
+  ++revision;
+  if (!changeLog.empty())
+    changeLog[revision % ChangeLogSize] = handle;
+}
+
+void NodeArena::Clear() {
+  for (auto &pool : pools) {
+    if (!pool)
+      continue;
+    // Nodes in one arena only wire to each other, so nothing needs detaching;
+    // run the destructors and rewind the pool.
+    for (uint32_t i = 0; i < pool->used; ++i)
+      if (pool->nodes[i])
+        pool->Release(i);
+    // With no live node left in the pool, retired slots can start over;
+    // otherwise every clear and refill would leave more of them behind
+    std::replace(pool->generations.begin(), pool->generations.end(),
+                 (uint8_t)0, (uint8_t)1);
+    pool->freeList.clear();
+    pool->used = 0;
+  }
+  liveCount = 0;
+  ++revision;
+  changeLogStart = revision; // Nothing to patch from; owners rebuild
+}
+
+void NodeArena::TrackChanges() {
+  if (!changeLog.empty())
+    return;
+  changeLog.resize(ChangeLogSize);
+  changeLogStart = revision;
+}
+
+bool NodeArena::ChangesSince(uint64_t since,
+                             std::vector<NodeHandle> &out) const {
+  if (changeLog.empty() || since < changeLogStart || since > revision ||
+      revision - since > ChangeLogSize)
+    return false;
+  for (uint64_t r = since + 1; r <= revision; ++r)
+    out.push_back(changeLog[r % ChangeLogSize]);
+  return true;
+}
+
+Node *NodeArena::Get(NodeHandle handle) const {
+  uint32_t poolIndex = handle >> (IndexBits + GenerationBits);
+  uint32_t generation = (handle >> IndexBits) & ((1u << GenerationBits) - 1);
+  uint32_t slot = handle & (MaxSlotsPerPool - 1);
+
+  if (poolIndex >= pools.size() || !pools[poolIndex])
+    return nullptr;
+  const Pool &pool = *pools[poolIndex];
+  if (slot >= pool.used || pool.generations[slot] != generation)
+    return nullptr;
+  return pool.nodes[slot];
+}
+} // namespace Logicarium
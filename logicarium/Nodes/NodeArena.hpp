@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Logicarium {
+class Node;
+
+// 32-bit generation-checked node reference: | pool:4 | generation:8 | index:20 |
+// Generations start at 1, so a zero handle never refers to a live node.
+using NodeHandle = uint32_t;
+constexpr NodeHandle NullNodeHandle = 0;
+
+// Owns nodes in contiguous, type-segregated pools. Every concrete node type
+// gets its own pool of geometrically growing chunks, so nodes of one type sit
+// next to each other in memory and never move once created (ImNodes keys on
+// their addresses). Destroyed slots are recycled through a free list and bump
+// their generation, which turns stale handles into null lookups. A slot whose
+// generation would wrap is retired instead, so a handle can never come to
+// refer to a later node in its slot, until Clear() empties the pool and puts
+// retired slots back in use.
+class NodeArena {
+public:
+  static constexpr uint32_t IndexBits = 20;
+  static constexpr uint32_t GenerationBits = 8;
+  static constexpr uint32_t PoolBits = 4;
+  static constexpr uint32_t MaxPools = 1u << PoolBits;
+  static constexpr uint32_t MaxSlotsPerPool = 1u << IndexBits;
+  static constexpr uint32_t DefaultFirstChunkSlots = 16;
+
+  NodeArena() = default;
+  ~NodeArena();
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+
+  template <typename T, typename... Args> T *Create(Args &&...args) {
+    static_assert(std::is_base_of<Node, T>::value,
+                  "NodeArena only stores Node types");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "over-aligned node types are not supported");
+
+    uint32_t poolIndex = PoolIndexOf<T>();
+    Pool &pool = GetPool(poolIndex, sizeof(T), alignof(T),
+                         [](Node *node) { static_cast<T *>(node)->~T(); });
+
+    uint32_t slot = pool.Allocate(firstChunkSlots);
+    T *node = new (pool.Address(slot)) T(std::forward<Args>(args)...);
+    pool.nodes[slot] = node;
+    node->handle = MakeHandle(poolIndex, pool.generations[slot], slot);
+    ++liveCount;
+    ++revision;
+    if (!changeLog.empty())
+      changeLog[revision % ChangeLogSize] = node->handle;
+    return node;
+  }
+
+  // Slots in the first chunk of pools created from now on. Arenas that know
+  // how many nodes of each type they will hold (a CustomGate's, from its
+  // definition) set this before creating the first of a type.
+  void SetFirstChunkSlots(uint32_t slots) { firstChunkSlots = slots; }
+
+  // Destroys a single node. Wires must already be detached.
+  void Destroy(Node *node);
+  // Destroys every node in one linear pass per pool. Chunks are kept for reuse
+  // and allocation restarts at the front of each pool. Handles issued before
+  // must not be looked up afterwards.
+  void Clear();
+
+  // Null if the handle is stale or was issued by another arena
+  Node *Get(NodeHandle handle) const;
+  size_t Size() const { return liveCount; }
+  // Bumped whenever a node is created or destroyed
+  uint64_t Revision() const { return revision; }
+  // Starts logging the handles created and destroyed, so an owner that
+  // indexes the nodes can patch its index instead of rebuilding it
+  void TrackChanges();
+  // Appends the handles created or destroyed after revision since, in order.
+  // False if the log doesn't reach back that far (or past a Clear()), in
+  // which case the owner has to rebuild.
+  bool ChangesSince(uint64_t since, std::vector<NodeHandle> &out) const;
+
+  // Visits live nodes pool by pool in memory order
+  template <typename F> void ForEach(F &&fn) const {
+    for (const auto &pool : pools) {
+      if (!pool)
+        continue;
+      for (uint32_t i = 0; i < pool->used; ++i)
+        if (pool->nodes[i])
+          fn(pool->nodes[i]);
+    }
+  }
+
+private:
+  struct Chunk {
+    std::unique_ptr<unsigned char[]> storage;
+    uint32_t first = 0;
+    uint32_t capacity = 0;
+  };
+
+  struct Pool {
+    size_t stride = 0;
+    void (*destroy)(Node *) = nullptr;
+    std::vector<Chunk> chunks;
+    std::vector<Node *> nodes;       // Per slot, null when free
+    std::vector<uint8_t> generations; // Per slot, 0 while retired
+    std::vector<uint32_t> freeList;
+    uint32_t used = 0;     // Slots handed out since the last Clear()
+    uint32_t capacity = 0; // Slots across all chunks
+
+    uint32_t Allocate(uint32_t firstChunkSlots);
+    void *Address(uint32_t slot) const;
+    // False if the slot's generation ran out and it can't be used again
+    bool Release(uint32_t slot);
+  };
+
+  std::vector<std::unique_ptr<Pool>> pools;
+  size_t liveCount = 0;
+  uint64_t revision = 0;
+  // Ring of the handle each revision created or destroyed; empty until
+  // TrackChanges(). Complete for revisions after changeLogStart.
+  static constexpr uint32_t ChangeLogSize = 4096;
+  std::vector<NodeHandle> changeLog;
+  uint64_t changeLogStart = 0;
+  uint32_t firstChunkSlots = DefaultFirstChunkSlots;
+
+  Pool &GetPool(uint32_t index, size_t size, size_t align,
+                void (*destroy)(Node *));
+
+  static NodeHandle MakeHandle(uint32_t pool, uint8_t generation,
+                               uint32_t slot) {
+    return (pool << (IndexBits + GenerationBits)) |
+           ((uint32_t)generation << IndexBits) | slot;
+  }
+
+  static uint32_t NextPoolIndex();
+  template <typename T> static uint32_t PoolIndexOf() {
+    static const uint32_t index = NextPoolIndex();
+    return index;
+  }
+};
+} // namespace Logicarium
@@ -1,7 +1,9 @@
 #include "Nodes.hpp"
 
 namespace Logicarium {
-std::vector<Node *(*)()> availableNodes{
-    []() -> Node * { return new PinIn(); },
-    []() -> Node * { return new PinOut(); }};
+std::vector<PaletteEntry> availableNodes{
+    MakePaletteEntry(
+        [](NodeArena &arena) -> Node * { return arena.Create<PinIn>(); }),
+    MakePaletteEntry(
+        [](NodeArena &arena) -> Node * { return arena.Create<PinOut>(); })};
 } // namespace Logicarium
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Node.hpp"
+#include "Palette.hpp"
 
 #include "AND.hpp"
 #include "NOT.hpp"
@@ -9,5 +10,5 @@
 
 
 namespace Logicarium {
-extern std::vector<Node *(*)()> availableNodes;
+extern std::vector<PaletteEntry> availableNodes;
 }
@@ -0,0 +1,23 @@
+#include "Palette.hpp"
+
+namespace Logicarium {
+std::string MakePaletteIcon(const std::string &name) {
+  if (name.size() > 4)
+    return name.substr(0, 3) + ".";
+  return name;
+}
+
+PaletteEntry MakePaletteEntry(std::function<Node *(NodeArena &)> create) {
+  NodeArena scratch;
+  Node *prototype = create(scratch);
+
+  PaletteEntry entry;
+  entry.name = prototype->title;
+  entry.icon = MakePaletteIcon(entry.name);
+  entry.color = prototype->GetColor();
+  entry.inputCount = prototype->inputSlotCount;
+  entry.outputCount = prototype->outputSlotCount;
+  entry.create = std::move(create);
+  return entry;
+}
+} // namespace Logicarium
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Node.hpp"
+#include <functional>
+#include <string>
+
+namespace Logicarium {
+// What the dock and the context menus need to show a placeable node. Entries
+// are filled in once, when the node type is registered, so drawing the palette
+// never instantiates anything; `create` only runs when the user places one.
+struct PaletteEntry {
+  std::string name;
+  std::string icon; // Short label drawn inside the dock bubble
+  ImU32 color = 0;
+  int inputCount = 0;
+  int outputCount = 0;
+  std::function<Node *(NodeArena &)> create;
+};
+
+// Builds an entry by instantiating the node once and reading its metadata
+PaletteEntry MakePaletteEntry(std::function<Node *(NodeArena &)> create);
+// Dock labels longer than four characters are cut to three plus a dot
+std::string MakePaletteIcon(const std::string &name);
+} // namespace Logicarium
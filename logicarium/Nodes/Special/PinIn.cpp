@@ -3,16 +3,16 @@
 namespace Logicarium {
 PinIn::PinIn() : Node("In", {}, {{"out"}}) { value = true; };
 
-bool PinIn::Evaluate(const std::string &slot) {
+bool PinIn::Evaluate(int slot) {
   if (isEvaluating || lastEvaluatedFrame == GlobalFrameCount)
     return value;
   lastEvaluatedFrame = GlobalFrameCount;
   return value;
 };
 
-extern Node *nodeToDuplicate;
-extern Node *nodeToDelete;
-extern Node *nodeToRename;
+extern NodeHandle nodeToDuplicate;
+extern NodeHandle nodeToDelete;
+extern NodeHandle nodeToRename;
 extern bool nodeHoveredForContextMenu;
 
 void PinIn::Render() {
@@ -63,32 +63,6 @@ void PinIn::Render() {
     ImGui::PopStyleVar();
 
     ImNodes::Ez::OutputSlots(outputSlots.data(), outputSlotCount);
-
-    // Logic for connections
-    for (const Connection &connection : connections) {
-      if (connection.outputNode != this)
-        continue;
-      bool signal = Evaluate();
-      auto *canvas = ImNodes::GetCurrentCanvas();
-      ImColor originalConnectionColor = canvas->Colors[ImNodes::ColConnection];
-
-      // Check if both nodes are selected for connection highlighting
-      bool bothSelected = selected && ((Node *)connection.inputNode)->selected;
-      if (bothSelected) {
-        canvas->Colors[ImNodes::ColConnection] = IM_COL32(0, 200, 255, 255);
-      } else {
-        canvas->Colors[ImNodes::ColConnection] =
-            signal ? IM_COL32(50, 255, 150, 255) : IM_COL32(80, 90, 100, 255);
-      }
-
-      if (!ImNodes::Connection(
-              connection.inputNode, connection.inputSlot.c_str(),
-              connection.outputNode, connection.outputSlot.c_str())) {
-        ((Node *)connection.inputNode)->DeleteConnection(connection);
-        ((Node *)connection.outputNode)->DeleteConnection(connection);
-      }
-      canvas->Colors[ImNodes::ColConnection] = originalConnectionColor;
-    }
   }
 
   ImNodes::Ez::EndNode();
@@ -100,14 +74,14 @@ void PinIn::Render() {
 
   if (ImGui::BeginPopupContextItem()) {
     if (ImGui::MenuItem("Rename")) {
-      nodeToRename = this;
+      nodeToRename = handle;
     }
     if (ImGui::MenuItem("Duplicate")) {
-      nodeToDuplicate = this;
+      nodeToDuplicate = handle;
     }
     ImGui::Separator();
     if (ImGui::MenuItem("Delete", "Del")) {
-      nodeToDelete = this;
+      nodeToDelete = handle;
     }
     ImGui::EndPopup();
   }
@@ -3,30 +3,20 @@
 namespace Logicarium {
 PinOut::PinOut() : Node("Out", {{"in"}}, {}) { value = true; };
 
-bool PinOut::Evaluate(const std::string &slot) {
+bool PinOut::Evaluate(int slot) {
   if (isEvaluating || lastEvaluatedFrame == GlobalFrameCount)
     return value;
 
   isEvaluating = true;
-  for (const auto &cn : connections) {
-    if (cn.inputNode == this &&
-        ((Node *)cn.outputNode)->Evaluate(cn.outputSlot)) {
-      value = true;
-      lastEvaluatedFrame = GlobalFrameCount;
-      isEvaluating = false;
-      return value;
-    }
-  }
-
-  value = false;
+  value = InputValue(0);
   lastEvaluatedFrame = GlobalFrameCount;
   isEvaluating = false;
   return value;
 };
 
-extern Node *nodeToDuplicate;
-extern Node *nodeToDelete;
-extern Node *nodeToRename;
+extern NodeHandle nodeToDuplicate;
+extern NodeHandle nodeToDelete;
+extern NodeHandle nodeToRename;
 extern bool nodeHoveredForContextMenu;
 
 void PinOut::Render() {
@@ -75,14 +65,14 @@ void PinOut::Render() {
 
   if (ImGui::BeginPopupContextItem()) {
     if (ImGui::MenuItem("Rename")) {
-      nodeToRename = this;
+      nodeToRename = handle;
     }
     if (ImGui::MenuItem("Duplicate")) {
-      nodeToDuplicate = this;
+      nodeToDuplicate = handle;
     }
     ImGui::Separator();
     if (ImGui::MenuItem("Delete", "Del")) {
-      nodeToDelete = this;
+      nodeToDelete = handle;
     }
     ImGui::EndPopup();
   }
@@ -6,7 +6,7 @@ namespace Logicarium {
 class PinOut : public Node {
 public:
   PinOut();
-  bool Evaluate(const std::string &slot = "") override;
+  bool Evaluate(int slot = 0) override;
   void Render() override;
   ImU32 GetColor() const override { return IM_COL32(40, 40, 45, 255); }
 };
@@ -0,0 +1,128 @@
+#include "Symbols.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Logicarium {
+namespace {
+// Strings are appended to fixed-size blocks that are never reallocated, so
+// the char pointers handed out by Name() remain valid forever.
+constexpr size_t PoolBlockSize = 16 * 1024;
+// The symbol-to-name array is chunked the same way, so Name() can read it
+// without a lock while Intern() appends
+constexpr size_t NamesPerChunk = 4096;
+constexpr size_t MaxNameChunks = 16384;
+
+struct Table {
+  // Exclusive to add a name, shared to look one up in the map; Name() takes
+  // neither
+  std::shared_mutex mutex;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char *block = nullptr; // Block currently being filled
+  size_t blockUsed = PoolBlockSize;
+  std::unordered_map<std::string_view, Symbol> lookup;
+
+  // Indexed by symbol; 0 is NoSymbol. An entry is written before count is
+  // raised past it, so a reader that sees the count sees the entry.
+  std::atomic<const char **> names[MaxNameChunks] = {};
+  std::atomic<Symbol> count{0};
+
+  Table() {
+    Append("");
+    for (const char *name : {"AND", "NOT", "NAND", "In", "Out"})
+      Add(name);
+  }
+
+  const char *Name(Symbol symbol) const {
+    if (symbol >= count.load(std::memory_order_acquire))
+      return "";
+    const char **chunk =
+        names[symbol / NamesPerChunk].load(std::memory_order_relaxed);
+    return chunk[symbol % NamesPerChunk];
+  }
+
+  Symbol Append(const char *stored) {
+    Symbol symbol = count.load(std::memory_order_relaxed);
+    size_t chunkIndex = symbol / NamesPerChunk;
+    if (chunkIndex >= MaxNameChunks) {
+      fprintf(stderr, "SymbolTable: too many symbols\n");
+      std::abort();
+    }
+    const char **chunk = names[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+      chunk = new const char *[NamesPerChunk];
+      names[chunkIndex].store(chunk, std::memory_order_relaxed);
+    }
+    chunk[symbol % NamesPerChunk] = stored;
+    count.store(symbol + 1, std::memory_order_release);
+    return symbol;
+  }
+
+  const char *Store(std::string_view name) {
+    size_t size = name.size() + 1;
+    char *dst;
+    if (size > PoolBlockSize / 4) {
+      // Oversized names get a private block so they don't waste a shared one
+      blocks.emplace_back(new char[size]);
+      dst = blocks.back().get();
+    } else {
+      if (blockUsed + size > PoolBlockSize) {
+        blocks.emplace_back(new char[PoolBlockSize]);
+        block = blocks.back().get();
+        blockUsed = 0;
+      }
+      dst = block + blockUsed;
+      blockUsed += size;
+    }
+    memcpy(dst, name.data(), name.size());
+    dst[name.size()] = '\0';
+    return dst;
+  }
+
+  Symbol Add(std::string_view name) {
+    const char *stored = Store(name);
+    Symbol symbol = Append(stored);
+    lookup.emplace(std::string_view(stored, name.size()), symbol);
+    return symbol;
+  }
+};
+
+Table &GetTable() {
+  static Table table;
+  return table;
+}
+} // namespace
+
+namespace SymbolTable {
+Symbol Intern(std::string_view name) {
+  Table &table = GetTable();
+  {
+    std::shared_lock<std::shared_mutex> lock(table.mutex);
+    auto it = table.lookup.find(name);
+    if (it != table.lookup.end())
+      return it->second;
+  }
+  std::unique_lock<std::shared_mutex> lock(table.mutex);
+  // Another thread may have added it since the shared lock was dropped
+  auto it = table.lookup.find(name);
+  if (it != table.lookup.end())
+    return it->second;
+  return table.Add(name);
+}
+
+Symbol Find(std::string_view name) {
+  Table &table = GetTable();
+  std::shared_lock<std::shared_mutex> lock(table.mutex);
+  auto it = table.lookup.find(name);
+  return it != table.lookup.end() ? it->second : NoSymbol;
+}
+
+const char *Name(Symbol symbol) { return GetTable().Name(symbol); }
+} // namespace SymbolTable
+} // namespace Logicarium
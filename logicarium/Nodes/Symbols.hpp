@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Logicarium {
+// Interned name: gate types and pin names are stored once in a shared string
+// pool and referred to by a small dense integer, so comparing or looking up
+// names is an integer operation. Symbol 0 is reserved for "no symbol".
+using Symbol = uint32_t;
+constexpr Symbol NoSymbol = 0;
+
+// Names used on hot paths, pre-interned in this order at startup
+namespace Sym {
+enum : Symbol { AND = 1, NOT, NAND, In, Out };
+}
+
+namespace SymbolTable {
+// Returns the symbol for name, adding it to the pool if it is new
+Symbol Intern(std::string_view name);
+// Returns the symbol for name, or NoSymbol if it was never interned
+Symbol Find(std::string_view name);
+// Pool-owned, null-terminated spelling; stays valid for the program's life.
+// Takes no lock, so any thread can call it on hot paths.
+const char *Name(Symbol symbol);
+// Shorthand for Name(Intern(name)), for places that need a stable char*
+inline const char *InternedName(std::string_view name) {
+  return Name(Intern(name));
+}
+} // namespace SymbolTable
+} // namespace Logicarium